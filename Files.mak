@@ -4,31 +4,116 @@
 # Changes:
 # 2018-12-24 JFL Adapted to build for Windows with the MsvcLibX library make system.
 # 2019-01-18 JFL Define variable PROGRAMS instead of ALL, now usable both in Windows and Unix.
+# 2026-10-18 JFL Added moonelp.c, and the moonbench program in BENCHMARKS.
+#		 Added eclipse.c and seasons.c.
+# 2026-10-19 JFL Added dark.c.
+#		 Added the stars program, and planets.c.
+#		 Added tzfile.c to all programs using sun.c, then to all programs
+#		 using parsetime.c.
+#		 Added daterange.c to all programs taking a date argument.
+#		 Added the nbrgen generator of nbrtab.h, for nbrtxt.c.
+#		 Added record.c to all programs with a --format option.
+#		 Added the libtoday library, with all the engine sources.
+#		 All programs are built from their main source and libtoday.
+#		 Added the todayd daemon and its todayc client in DAEMONS.
+#		 Added the todaybox multi-call program in MULTICALL.
+#		 Added the libtoday_bash bash builtin in BASH_BUILTINS.
+#		 Added the today Python extension module in PYTHON_MODULES.
+#		 Added the todaybench micro-benchmarks program in BENCHMARKS.
+#		 Added the todaycheck accuracy checks program in CHECKS.
+#		 Added trace.c, with the tracing events and statistics.
 #
 
 # List of programs to build
-PROGRAMS = sunrise sunset today potm localtime
+PROGRAMS = sunrise sunset today potm localtime stars
+
+# Multi-call program, combining all the above programs. Their sources are
+# compiled with -DMULTICALL, to rename their main() and usage() routines.
+MULTICALL = todaybox
+
+# Bash loadable builtins. Unix only. Built on demand, with the bash headers.
+BASH_BUILTINS = libtoday_bash
+
+# Python extension modules. Built on demand, with the Python headers.
+PYTHON_MODULES = todaymodule
+
+# List of daemons and their clients. They use Linux-specific APIs like epoll.
+DAEMONS = todayd todayc
+
+# List of benchmark programs. Built on demand, and not installed.
+BENCHMARKS = moonbench todaybench
+
+# List of accuracy checks, with the golden tables in golden.csv, and the saved engines results in engines.csv.
+# Built on demand, and not installed.
+CHECKS = todaycheck
+
+# List of code generators. Built on demand, and not installed.
+GENERATORS = nbrgen
+
+# List of libraries. Their API is in $(lib).h
+LIBRARIES = libtoday
+
+# List of source files for each of the above libraries
+libtoday_SOURCES = libtoday.c datetx.c moontx.c moonelp.c eclipse.c seasons.c dark.c planets.c nbrtxt.c timetx.c sun.c tzfile.c daterange.c record.c parsetime.c trace.c
 
 # List of source files for each of the above programs
-localtime_SOURCES = localtime.c parsetime.c
-potm_SOURCES = potm.c moontx.c parsetime.c
-sunrise_SOURCES = sunrise.c moontx.c sun.c parsetime.c
-sunset_SOURCES = sunset.c moontx.c sun.c parsetime.c
-today_SOURCES = today.c datetx.c moontx.c nbrtxt.c timetx.c sun.c parsetime.c
+localtime_SOURCES = localtime.c $(libtoday_SOURCES)
+potm_SOURCES = potm.c $(libtoday_SOURCES)
+sunrise_SOURCES = sunrise.c $(libtoday_SOURCES)
+sunset_SOURCES = sunset.c $(libtoday_SOURCES)
+stars_SOURCES = stars.c $(libtoday_SOURCES)
+today_SOURCES = today.c $(libtoday_SOURCES)
+todaybox_SOURCES = todaybox.c sunrise.c sunset.c today.c potm.c localtime.c stars.c $(libtoday_SOURCES)
+libtoday_bash_SOURCES = today_bash.c $(libtoday_SOURCES)
+todaymodule_SOURCES = todaymodule.c $(libtoday_SOURCES)
+todayd_SOURCES = todayd.c $(libtoday_SOURCES)
+todayc_SOURCES = todayc.c
+moonbench_SOURCES = moonbench.c $(libtoday_SOURCES)
+todaybench_SOURCES = todaybench.c today.c $(libtoday_SOURCES)
+todaycheck_SOURCES = todaycheck.c $(libtoday_SOURCES)
+nbrgen_SOURCES = nbrgen.c
 
 # How to build the source release
 ZIPFILE = $(OD)today.zip
 ZIPSOURCES = *.c *.h *Makefile *.mak *.bat *.md include
 
 # Include files dependencies (Microsoft nmake considers the .c touched if a .h is newer)
-nbrtxt.c:	today.h
+libtoday.c:	today.h libtoday.h
+
+nbrtxt.c:	today.h nbrtab.h
 
 datetx.c:	today.h
 
 moontx.c:	today.h moontx.h
 
+moonelp.c:	today.h moontx.h
+
+eclipse.c:	today.h moontx.h
+
+seasons.c:	today.h
+
+dark.c:		today.h moontx.h
+
+planets.c:	today.h
+
+moonbench.c:	today.h moontx.h
+
+todaybench.c:	today.h moontx.h
+
+todaycheck.c:	today.h moontx.h
+
+stars.c:	today.h
+
 sun.c:		today.h params.h
 
+tzfile.c:	today.h
+
+daterange.c:	today.h
+
+record.c:	today.h
+
+trace.c:	today.h
+
 potm.c:		today.h  moontx.h
 
 sunrise.c:	today.h
@@ -37,4 +122,10 @@ sunset.c:	today.h
 
 timetx.c:	today.h params.h
 
-today.c:	today.h
+today.c:	today.h libtoday.h screensize.c
+
+todayd.c:	libtoday.h
+
+today_bash.c:	libtoday.h
+
+todaymodule.c:	libtoday.h today.h
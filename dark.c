@@ -0,0 +1,158 @@
+/*
+ * dark.c
+ *
+ * Find the astronomical darkness windows over a range of dates.
+ *
+ * A window is a time interval when the Sun is more than 18 degrees below the
+ * horizon, and the Moon is either below the horizon, or illuminated less
+ * than a given percentage.
+ *
+ * The whole range is scanned in a single pass, with 5-minute steps. The Sun
+ * and Moon positions are not computed at every step: They're computed only
+ * at 0h, 12h, and 24h UT each day, and interpolated in between. The Sun
+ * position computed at each of these nodes is shared by the Sun altitude and
+ * the Moon illumination evaluations, and the 24h node of one day is reused
+ * as the 0h node of the next. Every change of state between two steps is then
+ * refined by bisection, down to about one second.
+ *
+ * The Sun position is from sun_meeus(), and the Moon position from
+ * moon_elp(), both in moonelp.c.
+ *
+ * Authors:
+ *   JFL jf.larvoire@free.fr
+ *
+ * History:
+ *   2026-10-19 JFL Created this module.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#include "today.h"
+#include "moontx.h"
+
+#define J2000		2451545.0	/* JDE of 2000-01-01 12:00 TT */
+#define EARTH_KM	6378.14		/* Earth equatorial radius in km */
+#define STEPS		288		/* Number of steps per day = 5 minutes */
+#define SUN_LIMIT	-18.0		/* Astronomical twilight limit */
+
+typedef struct _NODE {	/* Sun & Moon state at one interpolation node */
+  double raS, decS;	/* Sun right ascension & declination, degrees */
+  double raM, decM;	/* Moon right ascension & declination, degrees */
+  double h0M;		/* Moon geocentric altitude at moonrise/moonset */
+  double illum;		/* Moon illuminated percentage */
+} NODE;
+
+typedef struct _DAY {	/* Interpolation data for one day */
+  double jd0;		/* Julian day of 0h UT */
+  NODE n[3];		/* Nodes at 0h, 12h, 24h */
+  double sinLat, cosLat;
+  double maxIllum;
+} DAY;
+
+/* Convert ecliptic coordinates to equatorial coordinates, in degrees */
+static void ecl_to_eq(double jde, double lambda, double beta, double *pra, double *pdec) {
+  double eps = dtor(23.4392911 - 0.0130042 * (jde - J2000) / 36525.0);
+  double l = dtor(lambda), b = dtor(beta);
+  *pra = atan2(sin(l) * cos(eps) - tan(b) * sin(eps), cos(l)) * 180.0 / PI;
+  *pdec = asin(sin(b) * cos(eps) + cos(b) * sin(eps) * sin(l)) * 180.0 / PI;
+}
+
+static void get_node(double jd, NODE *pn) {
+  double jde = jd + delta_t(jd) / 86400.0;
+  double ls, rs, lm, bm, dm;
+
+  sun_meeus(jde, &ls, &rs);
+  moon_elp(jde, &lm, &bm, &dm);
+  ecl_to_eq(jde, ls - 0.005694, 0.0, &pn->raS, &pn->decS);
+  ecl_to_eq(jde, lm, bm, &pn->raM, &pn->decM);
+  pn->h0M = 0.7275 * asin(EARTH_KM / dm) * 180.0 / PI - 0.5667;
+  pn->illum = phase_illum(lm, bm, dm, ls, rs);
+}
+
+/* Make the right ascensions continuous over the day, for interpolating them */
+static void unwrap(double *pra0, double *pra1, double *pra2) {
+  while (*pra1 - *pra0 > 180.0) *pra1 -= 360.0;
+  while (*pra1 - *pra0 < -180.0) *pra1 += 360.0;
+  while (*pra2 - *pra1 > 180.0) *pra2 -= 360.0;
+  while (*pra2 - *pra1 < -180.0) *pra2 += 360.0;
+}
+
+/* Quadratic interpolation between the 3 nodes, for x in [0, 1] */
+#define INTERP(pd, field, x) \
+  (  (pd)->n[0].field * 2.0 * ((x) - 0.5) * ((x) - 1.0) \
+   - (pd)->n[1].field * 4.0 * (x) * ((x) - 1.0) \
+   + (pd)->n[2].field * 2.0 * (x) * ((x) - 0.5))
+
+/* Altitude in degrees of an object at a given hour angle and declination */
+static double altitude(DAY *pd, double ha, double dec) {
+  return asin(pd->sinLat * sin(dtor(dec)) + pd->cosLat * cos(dtor(dec)) * cos(dtor(ha))) * 180.0 / PI;
+}
+
+/* Return 1 if it's dark at time t within the day */
+static int is_dark(DAY *pd, double t) {
+  double n = t - pd->jd0;
+  double lst = 280.46061837 + 360.98564736629 * (t - J2000) - today_lon; /* Local sidereal time. lon is +=West */
+
+  if (altitude(pd, lst - INTERP(pd, raS, n), INTERP(pd, decS, n)) >= SUN_LIMIT) return 0;
+  if (INTERP(pd, illum, n) < pd->maxIllum) return 1;
+  return altitude(pd, lst - INTERP(pd, raM, n), INTERP(pd, decM, n)) < INTERP(pd, h0M, n);
+}
+
+/* Find the darkness windows in [jdFrom, jdTo], and pass each to the callback.
+   maxIllum = Moon illumination percentage below which the Moon does not matter.
+   Return 0, or the first non-zero value returned by the callback */
+int dark_windows(double jdFrom, double jdTo, double maxIllum, DARKCB pfn, void *pRef) {
+  DAY day;
+  double jdStart = 0.0;	/* Start of the current window */
+  int iDark = 0;	/* 1 = Inside a window */
+  int iFirst = 1;
+  int iErr;
+
+  day.sinLat = sin(dtor(today_lat));
+  day.cosLat = cos(dtor(today_lat));
+  day.maxIllum = maxIllum;
+  day.jd0 = floor(jdFrom - 0.5) + 0.5;
+  get_node(day.jd0, &day.n[2]);
+  for ( ; day.jd0 < jdTo; day.jd0 += 1.0) {
+    int k;
+    day.n[0] = day.n[2];	/* Reuse the previous day's 24h node */
+    get_node(day.jd0 + 0.5, &day.n[1]);
+    get_node(day.jd0 + 1.0, &day.n[2]);
+    unwrap(&day.n[0].raS, &day.n[1].raS, &day.n[2].raS);
+    unwrap(&day.n[0].raM, &day.n[1].raM, &day.n[2].raM);
+    for (k = 0; k <= STEPS; k++) {
+      double t = day.jd0 + (double)k / STEPS;
+      int iDark2;
+      if (t < jdFrom) continue;
+      if (t > jdTo) t = jdTo;
+      iDark2 = is_dark(&day, t);
+      if (iFirst) {
+	iFirst = 0;
+	iDark = iDark2;
+	jdStart = t;
+      } else if (iDark2 != iDark) {
+	double lo = t - 1.0 / STEPS, hi = t;
+	int i;
+	if (lo < jdFrom) lo = jdFrom;
+	for (i = 0; i < 9; i++) { /* Bisect down to about 1 second */
+	  double mid = (lo + hi) / 2;
+	  if (is_dark(&day, mid) == iDark) lo = mid; else hi = mid;
+	}
+	if (iDark2) {
+	  jdStart = hi;
+	} else if ((iErr = (*pfn)(jdStart, hi, pRef)) != 0) {
+	  return iErr;
+	}
+	iDark = iDark2;
+      }
+      if (t >= jdTo) break;
+    }
+    /* Restore the un-wrapped RA of the 24h node, to share it with the next day */
+    day.n[2].raS = fmod(day.n[2].raS + 720.0, 360.0);
+    day.n[2].raM = fmod(day.n[2].raM + 720.0, 360.0);
+  }
+  if (iDark && (jdTo > jdStart)) return (*pfn)(jdStart, jdTo, pRef);
+  return 0;
+}
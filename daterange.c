@@ -0,0 +1,300 @@
+/*
+ * daterange.c
+ *
+ * Expand ISO 8601 date intervals, repeats, and week dates, one date at a time.
+ *
+ * Supported expressions, in addition to the single dates parsed by
+ * parsetime():
+ *   START/END		Every day from START to END included.
+ *   START/DURATION	Every day from START, for that DURATION. Ex: 2025-01-01/P1M
+ *   DURATION/END	Every day during that DURATION, up to END included.
+ *   R[N]/START/DURATION	N dates from START, every DURATION. Unlimited if N is omitted.
+ *   R[N]/START/END	N dates from START, every (END - START).
+ *   YYYY-Www		The 7 days of that ISO week, from Monday to Sunday.
+ *   YYYY-Www-D		Day D of that ISO week. 1=Monday ... 7=Sunday.
+ * Durations are PnYnMnWnDTnHnMnS, with any of the fields omitted.
+ * Week dates can also be used as the bounds of an interval.
+ *
+ * Nothing is allocated: The DATERANGE structure holds the start date and the
+ * step, and each call to daterange_next() computes the next date from them.
+ * So arbitrarily long ranges use a constant amount of memory.
+ * The Nth date is computed as START + N * STEP, and not by adding STEP to
+ * the previous date, so that 2025-01-31 + N months never drifts to the 28th.
+ *
+ * Authors:
+ *   JFL jf.larvoire@free.fr
+ *
+ * History:
+ *   2026-10-19 JFL Created this module.
+ *		    Reject the START/END ranges with END before START.
+ *		    Step from the local start time as entered, not from its
+ *		    normalized time, which moves forward in a DST gap.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "today.h"
+
+#define MAX_PART	64	/* Maximum length of each part of an expression */
+
+static const int mdays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+/* Number of days in a month. month = 0 to 11 */
+static int month_days(int year, int month) {
+  int leap = ((year % 4) == 0) && (((year % 400) == 0) || ((year % 100) != 0));
+  return mdays[month] + ((month == 1) && leap);
+}
+
+/* Parse an unsigned decimal number. Return the number of digits */
+static int parse_uint(const char *p, const char *pEnd, long *pValue) {
+  int n = 0;
+  *pValue = 0;
+  while ((p + n < pEnd) && isdigit((unsigned char)p[n])) *pValue = *pValue * 10 + (p[n++] - '0');
+  return n;
+}
+
+/* Parse a PnYnMnWnDTnHnMnS duration. Return 0 if OK */
+static int parse_duration(const char *p, const char *pEnd, DATERANGE *pdr) {
+  int iTime = 0;
+  int nFields = 0;
+
+  if ((p >= pEnd) || ((*p | 0x20) != 'p')) return 1;
+  pdr->nYears = pdr->nMonths = pdr->nDays = 0;
+  pdr->nSeconds = 0;
+  for (p++; p < pEnd; ) {
+    long n;
+    int l;
+    if (((*p | 0x20) == 't') && !iTime) {
+      iTime = 1;
+      p++;
+      continue;
+    }
+    if (!(l = parse_uint(p, pEnd, &n)) || (p + l >= pEnd)) return 1;
+    p += l;
+    switch ((*p++ | 0x20) + (iTime ? 0x100 : 0)) {
+      case 'y': pdr->nYears = (int)n; break;
+      case 'm': pdr->nMonths = (int)n; break;
+      case 'w': pdr->nDays += (int)(7 * n); break;
+      case 'd': pdr->nDays += (int)n; break;
+      case 0x100 + 'h': pdr->nSeconds += 3600 * n; break;
+      case 0x100 + 'm': pdr->nSeconds += 60 * n; break;
+      case 0x100 + 's': pdr->nSeconds += n; break;
+      default: return 1;
+    }
+    nFields += 1;
+  }
+  return nFields ? 0 : 1;
+}
+
+/* Parse an ISO week date YYYY-Www[-D]. Return 0 if OK */
+static int parse_week(const char *p, const char *pEnd, int isEnd, struct tm *ptm, int *pnDays) {
+  long year, week, wday = 0;
+  long jan4, monday, days;
+  int y, m, d;
+
+  if (parse_uint(p, pEnd, &year) != 4) return 1;
+  p += 4;
+  if ((p < pEnd) && (*p == '-')) p++;
+  if ((p >= pEnd) || ((*p | 0x20) != 'w')) return 1;
+  p++;
+  if (parse_uint(p, pEnd, &week) != 2) return 1;
+  p += 2;
+  if (p < pEnd) {
+    if (*p == '-') p++;
+    if ((parse_uint(p, pEnd, &wday) != 1) || (p + 1 != pEnd) || (wday < 1) || (wday > 7)) return 1;
+  }
+  jan4 = days_from_civil((int)year, 1, 4);	/* Jan 4 is always in week 1 */
+  monday = jan4 - ((jan4 % 7) + 10) % 7;	/* 1970-01-01 was a Thursday */
+  if ((week < 1) || (week > 53)) return 1;
+  if (week == 53) {				/* Check that this year has 53 weeks */
+    long jan4Next = days_from_civil((int)year + 1, 1, 4);
+    if (monday + 52 * 7 > jan4Next - ((jan4Next % 7) + 10) % 7 - 7) return 1;
+  }
+  days = monday + (week - 1) * 7 + (wday ? wday - 1 : (isEnd ? 6 : 0));
+  *pnDays = wday ? 1 : 7;
+  civil_from_days(days, &y, &m, &d);
+  memset(ptm, 0, sizeof(struct tm));
+  ptm->tm_year = y - 1900;
+  ptm->tm_mon = m - 1;
+  ptm->tm_mday = d;
+  ptm->tm_hour = ptm->tm_min = ptm->tm_sec = -2;	/* No time specified */
+  tm_normalize(ptm);
+  return 0;
+}
+
+/* Parse one date or week date. Return 0 if OK, or 1 + the offset of the error */
+static int parse_point(const char *p, const char *pEnd, int isEnd, struct tm *ptm, int *pnDays) {
+  char buf[MAX_PART];
+
+  *pnDays = 1;
+  if (!parse_week(p, pEnd, isEnd, ptm, pnDays)) return 0;
+  if (pEnd - p >= MAX_PART) return MAX_PART;
+  memcpy(buf, p, pEnd - p);
+  buf[pEnd - p] = '\0';
+  return parsetime_nominal(buf, ptm);	/* Even in a DST gap, for nth_date() */
+}
+
+/* Seconds since midnight. Missing fields count as 0 */
+static long tm_seconds(const struct tm *ptm) {
+  return (ptm->tm_hour > 0 ? ptm->tm_hour * 3600L : 0)
+       + (ptm->tm_min > 0 ? ptm->tm_min * 60L : 0)
+       + (ptm->tm_sec > 0 ? ptm->tm_sec : 0);
+}
+
+/* Compute the Nth date from the start, by adding N steps, or -N steps. Return the UTC time */
+static time_t nth_date(const DATERANGE *pdr, long n, struct tm *ptm) {
+  time_t secs = (time_t)n * pdr->nSeconds;
+  int nDaysInMonth;
+
+  *ptm = pdr->tmStart;
+  ptm->tm_year += (int)(n * pdr->nYears);
+  ptm->tm_mon += (int)(n * pdr->nMonths);
+  if (pdr->nYears || pdr->nMonths) {	/* Clip the 31st to the end of shorter months */
+    ptm->tm_year += ptm->tm_mon / 12;
+    ptm->tm_mon %= 12;
+    if (ptm->tm_mon < 0) {
+      ptm->tm_mon += 12;
+      ptm->tm_year -= 1;
+    }
+    nDaysInMonth = month_days(ptm->tm_year + 1900, ptm->tm_mon);
+    if (ptm->tm_mday > nDaysInMonth) ptm->tm_mday = nDaysInMonth;
+  }
+  ptm->tm_mday += (int)(n * pdr->nDays + secs / 86400);
+  if (secs % 86400) {
+    if (ptm->tm_hour < 0) ptm->tm_hour = 0;	/* Missing times count as 00:00:00 */
+    if (ptm->tm_min < 0) ptm->tm_min = 0;
+    if (ptm->tm_sec < 0) ptm->tm_sec = 0;
+    ptm->tm_sec += (int)(secs % 86400);
+    if (ptm->tm_sec < 0) {	/* Stepping back in time */
+      ptm->tm_sec += 86400;
+      ptm->tm_mday -= 1;
+    }
+  }
+  return tm_normalize(ptm);
+}
+
+int daterange_parse(const char *text, DATERANGE *pdr)
+/*
+ * Parse a date, or a date range expression.
+ * Return 0 if OK, or 1 + the offset of the error, like parsetime().
+ */
+{
+  const char *parts[3], *ends[3];
+  int nParts = 0;
+  const char *p;
+  int iRepeat = 0;
+  int iErr;
+  int nDays;
+  long n;
+  struct tm stm;
+
+  memset(pdr, 0, sizeof(DATERANGE));
+  while (*text == ' ') text++;
+  for (p = parts[0] = text; ; p++) {	/* Split the expression at the / */
+    if (*p && (*p != '/')) continue;
+    if (nParts == 3) return (int)(p - text) + 1;
+    ends[nParts++] = p;
+    if (!*p) break;
+    parts[nParts] = p + 1;
+  }
+  pdr->nCount = -1;
+  pdr->nDays = 1;			/* Default step: One day */
+
+  if ((*parts[0] | 0x20) == 'r') {	/* R[N]/START/STEP */
+    if (nParts != 3) return (int)(ends[nParts-1] - text) + 1;
+    iRepeat = 1;
+    if (parse_uint(parts[0] + 1, ends[0], &n) != ends[0] - parts[0] - 1) return 2;
+    if (ends[0] > parts[0] + 1) pdr->nCount = n;
+    if ((iErr = parse_point(parts[1], ends[1], 0, &pdr->tmStart, &nDays)) != 0) {
+      return (int)(parts[1] - text) + iErr;
+    }
+    if (parse_duration(parts[2], ends[2], pdr)) {	/* Then it's an END date */
+      long days, secs;
+      if ((iErr = parse_point(parts[2], ends[2], 1, &stm, &nDays)) != 0) {
+	return (int)(parts[2] - text) + iErr;
+      }
+      /* The step is the difference of the local dates and times, ignoring DST changes */
+      days = days_from_civil(stm.tm_year + 1900, stm.tm_mon + 1, stm.tm_mday)
+	   - days_from_civil(pdr->tmStart.tm_year + 1900, pdr->tmStart.tm_mon + 1, pdr->tmStart.tm_mday);
+      secs = (tm_seconds(&stm) - tm_seconds(&pdr->tmStart)) + 86400 * days;
+      if (secs <= 0) return (int)(parts[2] - text) + 1;
+      pdr->nYears = pdr->nMonths = pdr->nDays = 0;
+      pdr->nSeconds = 0;
+      if ((secs % 86400) == 0) {
+	pdr->nDays = (int)(secs / 86400);
+      } else {
+	pdr->nSeconds = secs;
+      }
+    }
+  } else if (nParts == 1) {		/* A single date or week */
+    if ((iErr = parse_point(parts[0], ends[0], 0, &pdr->tmStart, &nDays)) != 0) return iErr;
+    pdr->nCount = nDays;
+  } else if (nParts == 2) {		/* START/END, START/DURATION, or DURATION/END */
+    DATERANGE drDuration;
+    if (!parse_duration(parts[0], ends[0], &drDuration)) {	/* DURATION/END */
+      if ((iErr = parse_point(parts[1], ends[1], 1, &pdr->tmStart, &nDays)) != 0) {
+	return (int)(parts[1] - text) + iErr;
+      }
+      pdr->tEnd = tm_normalize(&pdr->tmStart);
+      drDuration.tmStart = pdr->tmStart;
+      nth_date(&drDuration, -1, &pdr->tmStart);
+      pdr->iNext = 1;			/* The start is excluded */
+    } else {
+      if ((iErr = parse_point(parts[0], ends[0], 0, &pdr->tmStart, &nDays)) != 0) return iErr;
+      if (!parse_duration(parts[1], ends[1], &drDuration)) {	/* START/DURATION */
+	drDuration.tmStart = pdr->tmStart;
+	pdr->tEnd = nth_date(&drDuration, 1, &stm) - 1;	/* The end is excluded */
+      } else {							/* START/END */
+	if ((iErr = parse_point(parts[1], ends[1], 1, &stm, &nDays)) != 0) {
+	  return (int)(parts[1] - text) + iErr;
+	}
+	if (stm.tm_hour < 0) {		/* Include that whole day */
+	  stm.tm_hour = 23;
+	  stm.tm_min = 59;
+	  stm.tm_sec = 59;
+	}
+	pdr->tEnd = tm_normalize(&stm);
+	stm = pdr->tmStart;		/* Reject END before START */
+	if (stm.tm_hour < 0) stm.tm_hour = 0;
+	if (stm.tm_min < 0) stm.tm_min = 0;
+	if (stm.tm_sec < 0) stm.tm_sec = 0;
+	if (pdr->tEnd < tm_normalize(&stm)) return (int)(parts[1] - text) + 1;
+      }
+    }
+    pdr->iHasEnd = 1;
+  } else {
+    return (int)(ends[1] - text) + 1;
+  }
+
+  if (pdr->nSeconds) {	/* Stepping by hours, minutes, or seconds. Start at 00:00:00 by default */
+    if (pdr->tmStart.tm_hour < 0) pdr->tmStart.tm_hour = 0;
+    if (pdr->tmStart.tm_min < 0) pdr->tmStart.tm_min = 0;
+    if (pdr->tmStart.tm_sec < 0) pdr->tmStart.tm_sec = 0;
+    tm_normalize(&pdr->tmStart);	/* Out of a DST gap, so that no time repeats */
+  }
+  if (iRepeat && !pdr->nYears && !pdr->nMonths && !pdr->nDays && !pdr->nSeconds) return 1;
+  if (today_debug) printf("daterange: %04d-%02d-%02d + %ld * P%dY%dM%dDT%ldS%s\n",
+		    pdr->tmStart.tm_year + 1900, pdr->tmStart.tm_mon + 1, pdr->tmStart.tm_mday,
+		    pdr->nCount, pdr->nYears, pdr->nMonths, pdr->nDays, pdr->nSeconds,
+		    pdr->iHasEnd ? " up to the end" : "");
+  return 0;
+}
+
+int daterange_next(DATERANGE *pdr, struct tm *ptm)
+/*
+ * Get the next date in the range. Return 1 if there's one, or 0 at the end.
+ */
+{
+  struct tm stm;
+  time_t t;
+
+  if ((pdr->nCount >= 0) && (pdr->iNext >= pdr->nCount)) return 0;
+  t = nth_date(pdr, pdr->iNext, &stm);
+  if (pdr->iHasEnd && (t > pdr->tEnd)) return 0;
+  pdr->iNext += 1;
+  *ptm = stm;
+  return 1;
+}
@@ -12,12 +12,24 @@
  * The readable date will be written into the outpub buffer, terminated by
  * a null byte.  datetxt returns a pointer to the null byte.
  *
+ *      int     datetxt_n(buffer, size, year, month, day);
+ *      size_t  size;           -- Output buffer size
+ *
+ * Same, writing at most size bytes, including the null. Returns the length
+ * of the full text, like snprintf().
+ *
  * External routines called:
  *
- *      nbrtxt          (Number to ascii conversion)
- *      copyst          (String copy routine)
+ *      nbradd          (Number to ascii conversion)
+ *      txtadd          (Bounded string copy routine)
+ *
+ * History:
+ *   2026-10-19 JFL Added datetxt_n(), assembling the text with bounded
+ *		    copies of precomputed strings.
  */
 
+#include <string.h>
+
 #include "today.h"
 
 static char *daynames[] = {
@@ -47,11 +59,11 @@ static char *monthnames[] = {
 };
 
 /* Forward references to local routines */
-char *datetxt(char *buffer, int year, int month, int day);
 int dayofweek(int year, int month, int day);
 
-char *datetxt(buffer, year, month, day)
+int datetxt_n(buffer, size, year, month, day)
 char    *buffer;                        /* Output goes here             */
+size_t  size;                           /* Output buffer size           */
 int     year;                           /* Year, 1979 = 1979            */
 int     month;                          /* Month of year, Jan = 1       */
 int     day;                            /* Day in the month 1 = 1       */
@@ -60,25 +72,40 @@ int     day;                            /* Day in the month 1 = 1       */
  *      Tuesday, the third of October
  */
 {
-	register char   *op;                    /* Output pointer       */
+	size_t  len;                            /* Output length        */
+	char    *name;
 
-	op = buffer;                            /* Setup output pointer */
-	op = copyst(op, daynames[dayofweek(year, month, day)]);
-	op = copyst(op, ", the ");
-	op = nbrtxt(op, day, 1);
-	op = copyst(op, " day of ");
-	op = copyst(op, monthnames[(month < 0 || month > 12) ? 0 : month]);
-	op = copyst(op, ", ");
+	name = daynames[dayofweek(year, month, day)];
+	len = txtadd(buffer, size, 0, name, strlen(name));
+	len = TXTADD(buffer, size, len, ", the ", 6);
+	len = nbradd(buffer, size, len, day, 1);
+	len = TXTADD(buffer, size, len, " day of ", 8);
+	name = monthnames[(month < 0 || month > 12) ? 0 : month];
+	len = txtadd(buffer, size, len, name, strlen(name));
+	len = TXTADD(buffer, size, len, ", ", 2);
 	if (year < 1000 || year >= 2000)
-		return(nbrtxt(op, year, 0));
+		len = nbradd(buffer, size, len, year, 0);
 	else {
-		op = nbrtxt(op, year/100, 0);
-		op = copyst(op, " ");
+		len = nbradd(buffer, size, len, year/100, 0);
+		len = TXTADD(buffer, size, len, " ", 1);
 		if ((year = year % 100) == 0)
-			return(copyst(op, "hundred"));
+			len = txtadd(buffer, size, len, "hundred", 7);
 		else
-			return(nbrtxt(op, year, 0));
+			len = nbradd(buffer, size, len, year, 0);
 	}
+	return((int)len);
+}
+
+char *datetxt(buffer, year, month, day)
+char    *buffer;                        /* Output goes here             */
+int     year;                           /* Year, 1979 = 1979            */
+int     month;                          /* Month of year, Jan = 1       */
+int     day;                            /* Day in the month 1 = 1       */
+/*
+ * Same as datetxt_n(), for a buffer assumed to be large enough.
+ */
+{
+	return(buffer + datetxt_n(buffer, TXT_UNBOUNDED, year, month, day));
 }
 
 int dayofweek(year, month, day)
@@ -0,0 +1,196 @@
+/*
+ * eclipse.c
+ *
+ * Find the solar and lunar eclipses in a given period of time.
+ *
+ * Eclipses can only occur at new or full moons, when the Moon is close to
+ * one of the nodes of its orbit. So the search does not scan time: It visits
+ * only the mean syzygies, one lunation at a time, and for each computes the
+ * Moon mean argument of latitude F = l - Nm with moon_state() in moontx.c.
+ * Like in Meeus' "Astronomical Algorithms" chapter 54, there can't be any
+ * eclipse if |sin(F)| > 0.36. This eliminates about 90% of the syzygies.
+ * The remaining candidates are refined with the ELP-2000/82 engine in
+ * moonelp.c: The exact syzygy, the closest approach of the Moon to the Sun
+ * or to the Earth shadow, and finally the eclipse type and magnitude.
+ *
+ * The period is split into centuries, that are searched independently.
+ * When built with OpenMP support, they're searched in parallel.
+ *
+ * Authors:
+ *   JFL jf.larvoire@free.fr
+ *
+ * History:
+ *   2026-10-18 JFL Created this module.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "today.h"
+#include "moontx.h"
+
+#define SYNODIC		29.530588861	/* Mean synodic month, in days */
+#define NEWMOON0	2451550.09766	/* JDE of the mean new moon of 2000-01-06 (Meeus 49.1) */
+#define CENTURY		36525.0		/* Days per century */
+#define AU_KM		149597870.7	/* Astronomical Unit in km */
+#define EARTH_KM	6378.14		/* Earth equatorial radius in km */
+#define MOON_KM		1737.4		/* Moon radius in km */
+#define SUN_KM		696000.0	/* Sun radius in km */
+
+typedef struct _ECLLIST {	/* Growable list of eclipses */
+  ECLIPSE *pList;
+  int n;
+  int nAlloc;
+} ECLLIST;
+
+static int append(ECLLIST *pl, ECLIPSE *pe) {
+  if (pl->n == pl->nAlloc) {
+    int nAlloc = pl->nAlloc ? 2 * pl->nAlloc : 64;
+    ECLIPSE *pList = realloc(pl->pList, nAlloc * sizeof(ECLIPSE));
+    if (!pList) return -1;
+    pl->pList = pList;
+    pl->nAlloc = nAlloc;
+  }
+  pl->pList[pl->n++] = *pe;
+  return 0;
+}
+
+/* Geocentric Moon latitude and elongation from the (aberrated) Sun, in degrees */
+static void moon_vs_sun(double jde, double *pdl, double *pb, double *pDist, double *pR) {
+  double lm, ls;
+  moon_elp(jde, &lm, pb, pDist);
+  sun_meeus(jde, &ls, pR);
+  *pdl = lm - (ls - 0.005694);
+  *pdl = fmod(*pdl + 540.0, 360.0) - 180.0; /* In [-180, 180) */
+}
+
+/* Refine a candidate eclipse near the mean syzygy jde. Return 1 if there's an eclipse. */
+static int refine(double jde, int lunar, ECLIPSE *pe) {
+  double t, dl, b, dist, r, dl1, b1, dl2, b2, dummy;
+  double vx, vy, v2, tmin, dmin, pm, ps, sm, ss, u, g;
+  double h = 0.05;	/* Half-step for the numerical derivatives, in days */
+
+  t = moon_phase_jde(jde, lunar ? 180.0 : 0.0);
+  moon_vs_sun(t, &dl, &b, &dist, &r);
+  moon_vs_sun(t - h, &dl1, &b1, &dummy, &dummy);
+  moon_vs_sun(t + h, &dl2, &b2, &dummy, &dummy);
+  if (lunar) { /* Measure the Moon position relative to the center of the Earth shadow */
+    dl = fmod(dl + 360.0, 360.0) - 180.0;
+    dl1 = fmod(dl1 + 360.0, 360.0) - 180.0;
+    dl2 = fmod(dl2 + 360.0, 360.0) - 180.0;
+  }
+  /* Relative motion, assumed linear during the eclipse */
+  vx = (dl2 - dl1) / (2 * h) * cos(dtor(b));
+  vy = (b2 - b1) / (2 * h);
+  v2 = vx * vx + vy * vy;
+  tmin = t - (dl * cos(dtor(b)) * vx + b * vy) / v2;
+  dmin = (b * vx - dl * cos(dtor(b)) * vy) / sqrt(v2); /* Signed. > 0 = North */
+
+  pm = asin(EARTH_KM / dist) * 180.0 / PI;	/* Moon horizontal parallax */
+  ps = 8.794 / 3600.0 / r;			/* Sun horizontal parallax */
+  sm = asin(MOON_KM / dist) * 180.0 / PI;	/* Moon semi-diameter */
+  ss = 959.63 / 3600.0 / r;			/* Sun semi-diameter */
+  r *= AU_KM;
+
+  memset(pe, 0, sizeof(ECLIPSE));
+  if (!lunar) {
+    /* Shadow axis distance to the Earth center, and umbral cone radius, in Earth radii.
+       Like in Meeus, u is counted negatively when the umbra reaches the Earth. */
+    g = dist * sin(dtor(dmin)) * r / (r - dist) / EARTH_KM;
+    u = (dist * (SUN_KM - MOON_KM) / (r - dist) - MOON_KM) / EARTH_KM;
+    if (fabs(g) >= 1.5433 + u) return 0;
+    pe->type = ECL_SOLAR;
+    if (fabs(g) < 0.9972 + fabs(u)) { /* Central, or rare non-central total/annular */
+      pe->type |= (u < 0) ? ECL_TOTAL : ECL_ANNULAR;
+      pe->mag = sm / ss;
+    } else {
+      pe->type |= ECL_PARTIAL;
+      pe->mag = (1.5433 + u - fabs(g)) / (0.5461 + 2 * u);
+    }
+  } else {
+    /* Earth umbra and penumbra radii, enlarged by 2% for the atmosphere (Chauvenet) */
+    double ru = 1.02 * (0.99834 * pm - ss + ps);
+    double rp = 1.02 * (0.99834 * pm + ss + ps);
+    double umag = (ru + sm - fabs(dmin)) / (2 * sm);
+    double pmag = (rp + sm - fabs(dmin)) / (2 * sm);
+    if (pmag <= 0.0) return 0;
+    g = dist * sin(dtor(dmin)) / EARTH_KM;
+    pe->type = ECL_LUNAR;
+    if (umag >= 1.0) {
+      pe->type |= ECL_TOTAL;
+      pe->mag = umag;
+    } else if (umag > 0.0) {
+      pe->type |= ECL_PARTIAL;
+      pe->mag = umag;
+    } else {
+      pe->type |= ECL_PENUMBRAL;
+      pe->mag = pmag;
+    }
+  }
+  pe->gamma = g;
+  pe->jd = tmin - delta_t(tmin) / 86400.0;
+  return 1;
+}
+
+/* Search eclipses in [jdFrom, jdTo). Return 0, or -1 if out of memory */
+static int search(double jdFrom, double jdTo, ECLLIST *pl) {
+  double jd0 = jd_jan0(EPOCH);
+  long k, kFrom, kTo;
+  int half;
+
+  kFrom = (long)floor((jdFrom - NEWMOON0) / SYNODIC) - 1;
+  kTo = (long)ceil((jdTo - NEWMOON0) / SYNODIC) + 1;
+  for (k = kFrom; k <= kTo; k++) {
+    for (half = 0; half < 2; half++) {
+      double jde = NEWMOON0 + SYNODIC * ((double)k + 0.5 * half);
+      MOONSTATE ms;
+      ECLIPSE ecl;
+      moon_state(jde - jd0, &ms);
+      if (fabs(sin(dtor(ms.l - ms.Nm))) > 0.36) continue; /* Too far from a node */
+      if (!refine(jde, half, &ecl)) continue;
+      if ((ecl.jd < jdFrom) || (ecl.jd >= jdTo)) continue;
+      if (append(pl, &ecl)) return -1;
+    }
+  }
+  return 0;
+}
+
+/* Find all eclipses in [jdFrom, jdTo). The list is sorted, and must be freed by the caller */
+int eclipses(double jdFrom, double jdTo, ECLIPSE **ppList) {
+  int nChunks, i, n, iErr = 0;
+  ECLLIST *pChunks;
+  ECLIPSE *pList;
+
+  *ppList = NULL;
+  if (jdTo <= jdFrom) return 0;
+  nChunks = (int)ceil((jdTo - jdFrom) / CENTURY);
+  pChunks = calloc(nChunks, sizeof(ECLLIST));
+  if (!pChunks) return -1;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) reduction(|:iErr)
+#endif
+  for (i = 0; i < nChunks; i++) {
+    double jd1 = jdFrom + CENTURY * i;
+    double jd2 = (i == nChunks-1) ? jdTo : jd1 + CENTURY;
+    iErr |= search(jd1, jd2, pChunks + i);
+  }
+
+  for (i = n = 0; i < nChunks; i++) n += pChunks[i].n;
+  pList = iErr ? NULL : malloc((n ? n : 1) * sizeof(ECLIPSE));
+  if (pList) {
+    ECLIPSE *pe = pList;
+    for (i = 0; i < nChunks; i++) {
+      if (pChunks[i].n) memcpy(pe, pChunks[i].pList, pChunks[i].n * sizeof(ECLIPSE));
+      pe += pChunks[i].n;
+    }
+  }
+  for (i = 0; i < nChunks; i++) free(pChunks[i].pList);
+  free(pChunks);
+  if (!pList) return -1;
+  *ppList = pList;
+  return n;
+}
@@ -0,0 +1,204 @@
+/*
+ * libtoday.c - The libtoday API, defined in libtoday.h
+ *
+ * Thin reentrant wrappers around the engine routines used by the programs.
+ * The location is passed explicitly in a TODAY_SITE, which is the LOCATION
+ * structure of today.h, instead of using the global variables in sun.c.
+ *
+ * This is also where the today_debug flag, common to all the programs and
+ * the library routines, is defined.
+ *
+ * History:
+ *   2026-10-19 JFL Created this file.
+ *		    Added today_utc_time().
+ *		    Added today_sun_compute_at(), for batches of positions.
+ *		    Bugfix: The sites loaded from a configuration file without
+ *		    TIMEZONE never used DST. Use the system time zone DST rules
+ *		    for them, like the programs do.
+ *		    today_site_new() fails if the time zone ID is invalid, or
+ *		    can't be loaded, instead of using UTC.
+ *		    today_site_open() loads the system time zone, so that the
+ *		    threads using the site never race to load it.
+ *		    Renamed the debug flag today_debug, like the other globals
+ *		    in libtoday.a, to avoid collisions with the applications.
+ *		    Reject the latitudes and longitudes out of range, and the
+ *		    moon states out of the years supported.
+ */
+
+#define VERSION "2026-10-19"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "today.h"
+#include "libtoday.h"
+
+#define SYNODIC_MONTH	29.530588853	/* Mean lunation, in days */
+#define JD_1970		2440587.5	/* Julian day of the Unix epoch */
+
+int today_debug = 0;		/* Set by the programs -d option */
+
+const char *today_version() {
+  return VERSION;
+}
+
+TODAY_SITE *today_site_open(const char *pszFile) {
+  LOCATION *ploc = (LOCATION *)malloc(sizeof(LOCATION));
+
+  if (!ploc) return NULL;
+  if (location_load((char *)pszFile, ploc)) {
+    location_free(ploc);
+    free(ploc);
+    return NULL;
+  }
+  /* Load the system time zone now, as system_tz() is not thread-safe the
+     first time, and the other routines may be called by parallel threads */
+  if (!ploc->tzf.pBase && ploc->iSysTz) system_tz();
+  return ploc;
+}
+
+TODAY_SITE *today_site_new(double lat, double lonEast, const char *pszTzId, const char *pszCity) {
+  LOCATION *ploc;
+
+  if (!(fabs(lat) <= 90) || !(fabs(lonEast) <= 180)) return NULL;	/* Also rejects NaNs */
+  ploc = (LOCATION *)calloc(1, sizeof(LOCATION));
+  if (!ploc) return NULL;
+  ploc->lat = lat;
+  ploc->lon = -lonEast;		/* Caution: LOCATION longitudes are +=West */
+  ploc->tz = 0;			/* Use UTC if the time zone can't be loaded */
+  strcpy(ploc->tzs, "UTC");
+  strcpy(ploc->dtzs, "UTC");
+  if (pszTzId) {		/* Don't silently use UTC instead */
+    if (!tzfile_valid_id(pszTzId) || tzfile_open(pszTzId, &ploc->tzf)) {
+      free(ploc);
+      return NULL;
+    }
+    strncpy(ploc->tzid, pszTzId, sizeof(ploc->tzid) - 1);
+  }
+  if (pszCity) strncpy(ploc->city, pszCity, sizeof(ploc->city) - 1);
+  return ploc;
+}
+
+void today_site_close(TODAY_SITE *ps) {
+  if (!ps) return;
+  location_free(ps);
+  free(ps);
+}
+
+const char *today_site_city(const TODAY_SITE *ps) {
+  return ps->city;
+}
+
+double today_site_latitude(const TODAY_SITE *ps) {
+  return ps->lat;
+}
+
+double today_site_longitude(const TODAY_SITE *ps) {
+  return -ps->lon;
+}
+
+struct tm *today_local_time(const TODAY_SITE *ps, time_t t, struct tm *ptm) {
+  long offset;
+  int isDst;
+  const char *pszAbbr;
+
+  /* Configured sites without TIMEZONE use the system time zone, like the programs */
+  if (!ps->tzf.pBase && ps->iSysTz) return location_localtime(ps, t, ptm);
+  /* Else don't fall back to the C library local time, which is not the site's */
+  if (tzfile_lookup(&ps->tzf, t, &offset, &isDst, &pszAbbr)) {
+    offset = -3600L * ps->tz;
+    isDst = 0;
+  }
+  utc_to_tm(t, offset, isDst, ptm);
+  return ptm;
+}
+
+int today_parse_time(const TODAY_SITE *ps, const char *pszText, struct tm *ptm) {
+  if (!ps->tzf.pBase && ps->iSysTz) return parsetime(pszText, ptm) ? TODAY_ERROR : TODAY_OK;
+  return parsetime_tz(pszText, ptm, &ps->tzf) ? TODAY_ERROR : TODAY_OK;
+}
+
+time_t today_utc_time(const TODAY_SITE *ps, struct tm *ptm) {
+  time_t t;
+
+  if (!ps->tzf.pBase && ps->iSysTz) return tm_normalize(ptm);	/* The system time zone */
+  t = tm_normalize_tz(ptm, &ps->tzf);	/* Uses UTC if the time zone is not loaded */
+
+  if (!ps->tzf.pBase) t += 3600L * ps->tz;	/* Then use the standard time, like today_local_time() */
+  return t;
+}
+
+int today_sun_compute(const TODAY_SITE *ps, int year, int month, int day, TODAY_SUN *pSun) {
+  struct tm stm;
+  SUNDAY sd;
+
+  if ((year < 1583) || (month < 1) || (month > 12) || (day < 1) || (day > 31)) {
+    return TODAY_ERROR;		/* julian_date() exits for dates before 1583 */
+  }
+  memset(&stm, 0, sizeof(stm));
+  stm.tm_year = year - 1900;
+  stm.tm_mon = month - 1;
+  stm.tm_mday = day;
+  stm.tm_hour = 12;
+  if (!ps->tzf.pBase && ps->iSysTz) tm_normalize(&stm);	/* Set tm_isdst, like parsetime() does */
+  sun_day_at(ps, &stm, &sd);
+  pSun->utc_offset = location_utc_offset(ps, &stm);
+  pSun->noon = sd.noon;
+  if (sd.state == RS_RISES) {
+    pSun->status = TODAY_OK;
+    pSun->rise = sd.rise;
+    pSun->set = sd.set;
+  } else {
+    pSun->status = (sd.state == RS_CIRCUMPOLAR) ? TODAY_POLAR_DAY : TODAY_POLAR_NIGHT;
+    pSun->rise = pSun->set = -1.0;
+  }
+  return pSun->status;
+}
+
+int today_sun_compute_at(const TODAY_SITE *ps, double lat, double lonEast,
+			 int year, int month, int day, TODAY_SUN *pSun) {
+  LOCATION loc = *ps;		/* Shares the time zone data, which is read-only */
+
+  if (!(fabs(lat) <= 90) || !(fabs(lonEast) <= 180)) return TODAY_ERROR;
+  loc.lat = lat;
+  loc.lon = -lonEast;
+  return today_sun_compute(&loc, year, month, day, pSun);
+}
+
+int today_moon_state(time_t t, int iEngine, TODAY_MOON *pMoon) {
+  struct tm stm;
+  double phase;
+
+  utc_to_tm(t, 0, 0, &stm);
+  if ((stm.tm_year + 1900 < TODAY_MOON_MIN_YEAR) || (stm.tm_year + 1900 > TODAY_MOON_MAX_YEAR)) {
+    pMoon->illumination = NAN;
+    pMoon->waxing = -1;
+    pMoon->phase = "";
+    return TODAY_ERROR;
+  }
+  phase = moon_illum_with((iEngine == TODAY_MOON_ELP) ? potm_elp : potm, &stm, &pMoon->waxing);
+  pMoon->illumination = phase / 100;
+  pMoon->phase = moon_phase_name(phase, pMoon->waxing);
+  return TODAY_OK;
+}
+
+time_t today_moon_phase(time_t t, int iPhase) {
+  double jd = JD_1970 + (double)t / 86400;
+  double angle = 90.0 * (iPhase & 3);
+  double jde;
+
+  /* Start from the phase nearest to a quarter lunation before t, and step */
+  jde = moon_phase_jde(jd - SYNODIC_MONTH / 4, angle);
+  while ((jde - delta_t(jde) / 86400) <= jd) jde = moon_phase_jde(jde + SYNODIC_MONTH, angle);
+  return (time_t)floor((jde - delta_t(jde) / 86400 - JD_1970) * 86400 + 0.5);
+}
+
+int today_date_text(char *buf, size_t size, int year, int month, int day) {
+  return datetxt_n(buf, size, year, month, day);
+}
+
+int today_time_text(char *buf, size_t size, int hour, int minute, int second) {
+  return timetxt_n(buf, size, hour, minute, second, -1);	/* -1 = No time zone */
+}
@@ -0,0 +1,129 @@
+/*
+ * libtoday.h - The today programs engine, as a C library
+ *
+ * The sun, moon, and time routines used by the today programs, for
+ * applications linking with libtoday.a or libtoday.so.
+ *
+ * All routines are reentrant. They use no global variables: The location
+ * and its time zone are kept in a TODAY_SITE object, that the caller passes
+ * to every routine needing it. A site may be shared by several threads.
+ *
+ * The API version is incremented for incompatible changes only.
+ *
+ * History:
+ *   2026-10-19 JFL Created this file.
+ *		    Added today_utc_time(), for todayd.
+ *		    Added today_sun_compute_at(), for the Python module.
+ *		    Export only the today_xxx routines from libtoday.so.
+ *		    today_site_new() fails for unknown time zones.
+ *		    today_site_new() and today_sun_compute_at() fail for the
+ *		    positions out of range. today_moon_state() fails for the
+ *		    years out of range.
+ *		    The few globals in libtoday.a, used by the programs, are
+ *		    also named today_xxx.
+ */
+
+#ifndef _LIBTODAY_H_
+#define _LIBTODAY_H_
+
+#include <stddef.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TODAY_API_VERSION	1
+
+/* The shared library exports only the routines below. The engine objects
+   are compiled with -fvisibility=hidden, so its other symbols stay private */
+#if defined(__GNUC__) && (__GNUC__ >= 4)
+#define TODAY_API __attribute__((visibility("default")))
+#else
+#define TODAY_API
+#endif
+
+/* Results of the routines below */
+#define TODAY_OK		0
+#define TODAY_ERROR		1	/* Invalid argument, or file not found */
+#define TODAY_POLAR_DAY		2	/* today_sun_compute(): The sun does not set */
+#define TODAY_POLAR_NIGHT	3	/* today_sun_compute(): The sun does not rise */
+
+/* Moon phase engines */
+#define TODAY_MOON_FAST		0	/* The original potm() algorithm. Fast */
+#define TODAY_MOON_ELP		1	/* The ELP-2000/82 theory. Accurate */
+
+/* Years supported by today_moon_state(). From the start of the Julian Days */
+#define TODAY_MOON_MIN_YEAR	-4712
+#define TODAY_MOON_MAX_YEAR	9999
+
+/* Moon phases, for today_moon_phase() */
+#define TODAY_NEW_MOON		0
+#define TODAY_FIRST_QUARTER	1
+#define TODAY_FULL_MOON		2
+#define TODAY_LAST_QUARTER	3
+
+typedef struct _LOCATION TODAY_SITE;	/* A location, with its time zone. Opaque */
+
+typedef struct _TODAY_SUN {	/* Sun events on one local date */
+  int status;			/* TODAY_OK, TODAY_POLAR_DAY, or TODAY_POLAR_NIGHT */
+  double rise, noon, set;	/* Local times, in hours. rise & set = -1 if polar */
+  long utc_offset;		/* UTC offset of the local time, in seconds. +=East */
+} TODAY_SUN;
+
+typedef struct _TODAY_MOON {	/* Moon state at one time */
+  double illumination;		/* Illuminated fraction, from 0 to 1 */
+  int waxing;			/* 1=Waxing; 0=Waning */
+  const char *phase;		/* "new", "waxing_crescent", ..., "waning_crescent" */
+} TODAY_MOON;
+
+/* Library version, like "2026-10-19" */
+extern TODAY_API const char *today_version(void);
+
+/* Load a site from a location configuration file, then from the LATITUDE,
+   LONGITUDE, CITY, TIMEZONE, etc, environment variables, like the programs do.
+   pszFile = NULL searches the default files. Returns NULL if it can't be read.
+   Without TIMEZONE, the local times use the TZABBR time zone, with the DST
+   rules of the system time zone, like the programs do. That system time zone
+   is loaded here, so call it before sharing the site between threads */
+extern TODAY_API TODAY_SITE *today_site_open(const char *pszFile);
+/* Create a site. pszTzId = tz database ID, like "Europe/Paris". If it's NULL,
+   the local times are UTC. Returns NULL if lat or lonEast is out of range, if
+   pszTzId is not a valid tz database ID, or if it can't be loaded */
+extern TODAY_API TODAY_SITE *today_site_new(double lat, double lonEast, const char *pszTzId, const char *pszCity);
+extern TODAY_API void today_site_close(TODAY_SITE *ps);
+extern TODAY_API const char *today_site_city(const TODAY_SITE *ps);
+extern TODAY_API double today_site_latitude(const TODAY_SITE *ps);	/* +=North */
+extern TODAY_API double today_site_longitude(const TODAY_SITE *ps);	/* +=East */
+
+/* Site local time at t. Returns ptm */
+extern TODAY_API struct tm *today_local_time(const TODAY_SITE *ps, time_t t, struct tm *ptm);
+/* Parse a date/time in the site time zone, like the programs arguments */
+extern TODAY_API int today_parse_time(const TODAY_SITE *ps, const char *pszText, struct tm *ptm);
+/* UTC time of a site local time. Also normalizes *ptm, like mktime() */
+extern TODAY_API time_t today_utc_time(const TODAY_SITE *ps, struct tm *ptm);
+
+/* Sunrise, solar noon, and sunset on a local date. Returns the status */
+extern TODAY_API int today_sun_compute(const TODAY_SITE *ps, int year, int month, int day, TODAY_SUN *pSun);
+/* Same at another position, using the site time zone. For many positions in one time zone.
+   Returns TODAY_ERROR if lat or lonEast is out of range */
+extern TODAY_API int today_sun_compute_at(const TODAY_SITE *ps, double lat, double lonEast,
+				int year, int month, int day, TODAY_SUN *pSun);
+
+/* Moon state at time t. iEngine = TODAY_MOON_FAST or TODAY_MOON_ELP.
+   Returns TODAY_ERROR, with a NaN illumination and waxing = -1, for the
+   years out of the TODAY_MOON_MIN_YEAR to TODAY_MOON_MAX_YEAR range */
+extern TODAY_API int today_moon_state(time_t t, int iEngine, TODAY_MOON *pMoon);
+/* Time of the first moon phase iPhase after time t, to the second */
+extern TODAY_API time_t today_moon_phase(time_t t, int iPhase);
+
+/* English texts of a date and a time, as displayed by the today program.
+   They return the length of the full text, like snprintf() */
+extern TODAY_API int today_date_text(char *buf, size_t size, int year, int month, int day);
+extern TODAY_API int today_time_text(char *buf, size_t size, int hour, int minute, int second);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LIBTODAY_H_ */
@@ -13,9 +13,13 @@
 **   2019-11-03 JFL Added option -f to display the full date/time.
 **   2019-11-17 JFL Added option /? for Windows.
 **   2019-11-18 JFL Use the new versions.h instead of include/debugm.h.
+**   2026-10-19 JFL Document the RFC 3339 UTC offsets and fractional seconds.
+**		    Accept ISO 8601 date ranges and repeats, displaying every date.
+**		    Added option --format, for JSON Lines or CSV output.
+**		    Rename main() and usage() when built into todaybox.
 */
 
-#define VERSION "2019-11-18"
+#define VERSION "2026-10-19"
 
 #include <stdio.h>
 #include <string.h>
@@ -24,12 +28,20 @@
 #include "today.h"
 #include "versions.h"
 
+#ifdef MULTICALL		/* Linked into the todaybox multi-call program */
+#define main localtime_main
+#define usage localtime_usage
+#endif
+
 #define streq(s1, s2) (!strcmp(s1, s2))
 
 #define FALSE 0
 #define TRUE 1
 
-int debug = 0;
+/* Fields of the --format records */
+static const char * const fields[] = {
+  "date", "time", "epoch", "utc_offset", NULL
+};
 
 void usage() {
   printf("\
@@ -40,11 +52,15 @@ Usage: localtime [OPTIONS] [DATE_TIME]\n\
 Options:\n\
   -?|-h|--help    Display this help screen\n\
   -f              Display the full date/time in the canonic ISO 8601 format\n\
+  --format=FORMAT Output one record per date. FORMAT = jsonl or csv\n\
   -V|--version    Display the program version\n\
 \n\
-Date_time: [YYYY-MM-DD][T]HH:MM[:SS][Z], default: now, default date: today\n\
+Date_time: [YYYY-MM-DD][T]HH:MM[:SS[.FFF]][Z|+HH:MM], default: now, default date: today\n\
            The date can also be formatted as YYYY-DDD\n\
-           The optional Z suffix flags a GMT time\n\
+           The optional Z suffix flags a GMT time, and +HH:MM or -HH:MM\n\
+           another UTC offset. Fractional seconds are ignored\n\
+           Or a range, like 2025-01-01T08:00/2025-01-31, R/2025-01-01/PT6H,\n\
+           or 2025-W10\n\
 \n\
 ");
 }
@@ -53,8 +69,12 @@ int main(int argc, char *argv[]) {
   int i;
   struct tm stm;
   struct tm *ptm = NULL;
+  DATERANGE dr;
+  int iRange = FALSE;
   int iErr;
   int iFull = FALSE;
+  int iFormat = FMT_TEXT;
+  RECORD rec;
 
   for (i=1; i<argc; i++) {
     char *arg = argv[i];
@@ -70,7 +90,7 @@ int main(int argc, char *argv[]) {
     }
     if (   streq(arg, "-d")	/* -d = Debug mode */
         || streq(arg, "--debug")) {
-      debug = 1;
+      today_debug = 1;
       continue;
     }
     if (   streq(arg, "-f")	/* -f = Full date/time mode */
@@ -78,40 +98,81 @@ int main(int argc, char *argv[]) {
       iFull = 1;
       continue;
     }
+    if (   (streq(arg, "--format") && ((i+1)<argc)) /* --format = Output format */
+        || !strncmp(arg, "--format=", 9)) {
+      char *pszFormat = arg[8] ? arg+9 : argv[++i];
+      iFormat = record_format(pszFormat);
+      if (iFormat < 0) {
+	fprintf(stderr, "Error: Unsupported format: %s\n", pszFormat);
+	return 1;
+      }
+      continue;
+    }
     if (   streq(arg, "-V")     /* -V: Display the version */
 	|| streq(arg, "--version")) {
       printf(VERSION " " EXE_OS_NAME "\n");
       return 0;
     }
     /* Else this is an argument */
-    /* Try parsing another date/time */
-    iErr = parsetime(arg, &stm);
+    /* Try parsing another date/time, or a range of dates */
+    iErr = daterange_parse(arg, &dr);
     if (!iErr) {
-      ptm = &stm;
+      iRange = TRUE;
+      if (dr.nCount != 1) iFull = TRUE; /* Display which date each time is for */
       continue;
     }
     fprintf(stderr, "Error: Invalid argument: '%s'\n", arg);
     return 1;
   }
 
-  if (!ptm) {
-    time_t now;
-    time(&now);			/* get system time */
-    ptm = localtime(&now);	/* get ptr to gmt time struct */
+  if (iFormat) {
+    record_init(&rec, iFormat, fields);
+    fwrite(rec.szBuf, 1, record_header(&rec), stdout);
   }
+
+  do {
+    if (iRange) {
+      if (!daterange_next(&dr, &stm)) break;
+      ptm = &stm;
+    }
+    if (!ptm) {
+      time_t now;
+      time(&now);			/* get system time */
+      ptm = localtime(&now);	/* get ptr to gmt time struct */
+    }
+
+    if (iFormat) {		/* Machine-readable output */
+      struct tm stmLoc = *ptm;
+      time_t t;
+      long secs, offset;
+      if (stmLoc.tm_hour < 0) stmLoc.tm_hour = 0;	/* Missing fields */
+      if (stmLoc.tm_min < 0) stmLoc.tm_min = 0;
+      if (stmLoc.tm_sec < 0) stmLoc.tm_sec = 0;
+      t = tm_normalize(&stmLoc);	/* Also moves times in DST gaps */
+      secs = (stmLoc.tm_hour * 60L + stmLoc.tm_min) * 60 + stmLoc.tm_sec;
+      offset = (long)((time_t)days_from_civil(stmLoc.tm_year+1900, stmLoc.tm_mon+1, stmLoc.tm_mday) * 86400 + secs - t);
+      record_begin(&rec);
+      record_date(&rec, stmLoc.tm_year+1900, stmLoc.tm_mon+1, stmLoc.tm_mday);
+      record_time(&rec, stmLoc.tm_year+1900, stmLoc.tm_mon+1, stmLoc.tm_mday, secs, offset);
+      record_int(&rec, (long)t);
+      record_int(&rec, offset);
+      fwrite(rec.szBuf, 1, record_end(&rec), stdout);
+      continue;
+    }
   
-  if (iFull) printf("%04d-%02d-%02d ", ptm->tm_year+1900, ptm->tm_mon+1, ptm->tm_mday);
+    if (iFull) printf("%04d-%02d-%02d ", ptm->tm_year+1900, ptm->tm_mon+1, ptm->tm_mday);
 
-  if (ptm->tm_min == -2) ptm->tm_min = 0;
-  printf("%02d:%02d", ptm->tm_hour, ptm->tm_min);
-  if (ptm->tm_sec == -2) {
-    ptm->tm_sec = 0;
-  } else {
-    printf(":%02d", ptm->tm_sec);
-  }
-  printf("\n");
+    if (ptm->tm_min == -2) ptm->tm_min = 0;
+    printf("%02d:%02d", ptm->tm_hour, ptm->tm_min);
+    if (ptm->tm_sec == -2) {
+      ptm->tm_sec = 0;
+    } else {
+      printf(":%02d", ptm->tm_sec);
+    }
+    printf("\n");
   
-  if (debug) printf("# %s\n", asctime(ptm));
+    if (today_debug) printf("# %s\n", asctime(ptm));
+  } while (iRange);
 
   return 0;
 }
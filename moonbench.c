@@ -0,0 +1,143 @@
+/*
+** moonbench.c - Compare the cost and accuracy of the moon phase engines
+**
+** Runs potm() (Duffett-Smith, as used by default) and potm_elp() (Meeus
+** ELP-2000/82 truncation) over the same set of dates, and reports the
+** time per call of each, and the errors of potm() relative to potm_elp().
+** The phase error is also converted into a time error, by dividing it by
+** the rate of change of the illuminated fraction. This is meaningful only
+** away from the new and full moons, so it's only computed between 25% and
+** 75% of illumination, i.e. around the first and last quarters.
+**
+** Authors:
+**   JFL jf.larvoire@free.fr
+**
+** History:
+**   2026-10-18 JFL Created this program.
+*/
+
+#define VERSION "2026-10-18"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "today.h"
+#include "moontx.h"
+#include "versions.h"
+
+#define streq(s1, s2) (!strcmp(s1, s2))
+
+void usage() {
+  printf("\
+moonbench - Compare the cost and accuracy of the moon phase engines\n\
+\n\
+Usage: moonbench [OPTIONS]\n\
+\n\
+Options:\n\
+  -?|-h|--help      Display this help screen\n\
+  -n N              Number of sample dates. Default: 1000000\n\
+  -V|--version      Display the program version\n\
+  -y FROM TO        Years range sampled. Default: 1583 3000\n\
+\n\
+");
+}
+
+/* Time N calls to an engine over the days array. Return the ns/call. */
+double timeit(double (*engine)(double days), double *pDays, long n, double *pSum) {
+  clock_t t0, t1;
+  double sum = 0.0;
+  long i;
+  t0 = clock();
+  for (i=0; i<n; i++) sum += (*engine)(pDays[i]);
+  t1 = clock();
+  *pSum = sum; /* Prevents the compiler from optimizing the loop away */
+  return 1e9 * (double)(t1 - t0) / CLOCKS_PER_SEC / (double)n;
+}
+
+int main(int argc, char *argv[]) {
+  int i;
+  long n = 1000000L;
+  long l;
+  int yFrom = 1583, yTo = 3000;
+  double *pDays;
+  double d0, span;
+  double ns1, ns2, sum1, sum2;
+  double maxErr = 0.0, sumErr2 = 0.0;
+  double maxHours = 0.0, sumHours = 0.0;
+  long nHours = 0;
+
+  for (i=1; i<argc; i++) {
+    char *arg = argv[i];
+    if (   streq(arg, "-?")
+        || streq(arg, "-h")
+        || streq(arg, "--help")) {
+      usage();
+      return 0;
+    }
+    if (streq(arg, "-d")) {
+      today_debug = 1;
+      continue;
+    }
+    if (streq(arg, "-n") && ((i+1)<argc)) {
+      n = atol(argv[++i]);
+      continue;
+    }
+    if (   streq(arg, "-V")
+	|| streq(arg, "--version")) {
+      printf(VERSION " " EXE_OS_NAME "\n");
+      return 0;
+    }
+    if (streq(arg, "-y") && ((i+2)<argc)) {
+      yFrom = atoi(argv[++i]);
+      yTo = atoi(argv[++i]);
+      continue;
+    }
+    fprintf(stderr, "Unexpected argument: %s\n", arg);
+    return 1;
+  }
+  if ((n <= 0) || (yTo < yFrom)) {
+    fprintf(stderr, "Error: Invalid sample count or year range\n");
+    return 1;
+  }
+
+  pDays = malloc(n * sizeof(double));
+  if (!pDays) {
+    fprintf(stderr, "Error: Out of memory\n");
+    return 1;
+  }
+  /* Deterministic dates, evenly spread over the years range, at odd times of the day */
+  d0 = jd_jan0(yFrom) - jd_jan0(EPOCH);
+  span = jd_jan0(yTo + 1) - jd_jan0(yFrom);
+  for (l=0; l<n; l++) pDays[l] = d0 + 1.0 + span * ((double)l + 0.5) / (double)n;
+
+  ns1 = timeit(potm, pDays, n, &sum1);
+  ns2 = timeit(potm_elp, pDays, n, &sum2);
+
+  for (l=0; l<n; l++) {
+    double p1 = potm(pDays[l]);
+    double p2 = potm_elp(pDays[l]);
+    double err = fabs(p1 - p2);
+    if (err > maxErr) maxErr = err;
+    sumErr2 += err * err;
+    if ((p2 > 25.0) && (p2 < 75.0)) {
+      double rate = (potm_elp(pDays[l] + 1.0/24) - potm_elp(pDays[l] - 1.0/24)) / 2.0; /* %/hour */
+      double hours = err / fabs(rate);
+      if (hours > maxHours) maxHours = hours;
+      sumHours += hours;
+      nHours++;
+    }
+  }
+
+  printf("Samples:          %ld dates from %d to %d\n", n, yFrom, yTo);
+  printf("potm() cost:      %8.1f ns/call\n", ns1);
+  printf("potm_elp() cost:  %8.1f ns/call  (x%.1f)\n", ns2, ns2 / ns1);
+  printf("potm() error:     %8.3f %% max, %.3f %% rms\n", maxErr, sqrt(sumErr2 / (double)n));
+  if (nHours) printf("Near quarters:    %8.2f h max, %.2f h mean\n", maxHours, sumHours / (double)nHours);
+  if (today_debug) printf("Checksums: %f %f\n", sum1, sum2);
+
+  free(pDays);
+  return 0;
+}
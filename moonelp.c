@@ -0,0 +1,332 @@
+/*
+ * moonelp.c
+ *
+ * Higher-accuracy phase of the Moon.
+ *
+ * The Moon position is computed with the truncated ELP-2000/82 lunar theory,
+ * as published in Jean Meeus' "Astronomical Algorithms", 2nd ed., chapter 47.
+ * The Sun position uses the low-accuracy solar theory from chapter 25.
+ * The illuminated fraction is then derived from the true phase angle, as in
+ * chapter 48, instead of the plain elongation used by potm() in moontx.c.
+ *
+ * The periodic terms are stored as static coefficient tables, and summed in
+ * a loop that does no trigonometric calls: The sines and cosines of the
+ * multiples of the four fundamental arguments D, M, M', F are computed once
+ * per date, and each term's sine/cosine is obtained by complex products.
+ * The eccentricity correction E^|M| is folded into the M multiples table.
+ *
+ * Typical errors: Moon longitude ~10", latitude ~4". Phase instants ~1 min.
+ * potm() errors in comparison are up to a few hours near the quarters.
+ * Use the moonbench program to compare their respective costs and errors.
+ *
+ * Authors:
+ *   JFL jf.larvoire@free.fr
+ *
+ * History:
+ *   2026-10-18 JFL Created this module.
+ *   2026-10-19 JFL Bugfix: jd_to_tm() used the Julian calendar before 1582,
+ *		    unlike jd_jan0() and tm_to_jd(). And jd_jan0() was off by
+ *		    one day for some years before year 1.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#include "today.h"
+#include "moontx.h"
+
+#define J2000	2451545.0	/* Julian Ephemeris Day of 2000-01-01 12:00 */
+#define AU_KM	149597870.7	/* Astronomical Unit in km */
+
+/* Arguments multiples ranges used in the tables below */
+#define MAXD	4		/* D  multiples in [-MAXD, MAXD]   */
+#define MAXM	2		/* M  multiples in [-MAXM, MAXM]   */
+#define MAXMP	4		/* M' multiples in [-MAXMP, MAXMP] */
+#define MAXF	3		/* F  multiples in [-MAXF, MAXF]   */
+
+/* Table 47.A: Periodic terms for the longitude (Sigma l) and distance (Sigma r).
+   Units: 1e-6 degree, and 1e-3 km. */
+#define NLR 60
+static const signed char lrD[NLR] = {
+   0, 2, 2, 0, 0, 0, 2, 2, 2, 2, 0, 1, 0, 2, 0, 0, 4, 0, 4, 2,
+   2, 1, 1, 2, 2, 4, 2, 0, 2, 2, 1, 2, 0, 0, 2, 2, 2, 4, 0, 3,
+   2, 4, 0, 2, 2, 2, 4, 0, 4, 1, 2, 0, 1, 3, 4, 2, 0, 1, 2, 2
+};
+static const signed char lrM[NLR] = {
+   0, 0, 0, 0, 1, 0, 0,-1, 0,-1, 1, 0, 1, 0, 0, 0, 0, 0, 0, 1,
+   1, 0, 1,-1, 0, 0, 0, 1, 0,-1, 0,-2, 1, 2,-2, 0, 0,-1, 0, 0,
+   1,-1, 2, 2, 1,-1, 0, 0,-1, 0, 1, 0, 1, 0, 0,-1, 2, 1, 0, 0
+};
+static const signed char lrMp[NLR] = {
+   1,-1, 0, 2, 0, 0,-2,-1, 1, 0,-1, 0, 1, 0, 1, 1,-1, 3,-2,-1,
+   0,-1, 0, 1, 2, 0,-3,-2,-1,-2, 1, 0, 2, 0,-1, 1, 0,-1, 2,-1,
+   1,-2,-1,-1,-2, 0, 1, 4, 0,-2, 0, 2, 1,-2,-3, 2, 1,-1, 3,-1
+};
+static const signed char lrF[NLR] = {
+   0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0,-2, 2,-2, 0, 0, 0, 0,
+   0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0,-2, 2, 0, 2, 0,
+   0, 0, 0, 0, 0,-2, 0, 0, 0, 0,-2,-2, 0, 0, 0, 0, 0, 0, 0,-2
+};
+static const long lCoef[NLR] = {
+  6288774, 1274027,  658314,  213618, -185116, -114332,   58793,   57066,
+    53322,   45758,  -40923,  -34720,  -30383,   15327,  -12528,   10980,
+    10675,   10034,    8548,   -7888,   -6766,   -5163,    4987,    4036,
+     3994,    3861,    3665,   -2689,   -2602,    2390,   -2348,    2236,
+    -2120,   -2069,    2048,   -1773,   -1595,    1215,   -1110,    -892,
+     -810,     759,    -713,    -700,     691,     596,     549,     537,
+      520,    -487,    -399,    -381,     351,    -340,     330,     327,
+     -323,     299,     294,       0
+};
+static const long rCoef[NLR] = {
+ -20905355,-3699111,-2955968, -569925,   48888,   -3149,  246158, -152138,
+   -170733, -204586, -129620,  108743,  104755,   10321,       0,   79661,
+    -34782,  -23210,  -21636,   24208,   30824,   -8379,  -16675,  -12831,
+    -10445,  -11650,   14403,   -7003,       0,   10056,    6322,   -9884,
+      5751,       0,   -4950,    4130,       0,   -3958,       0,    3258,
+      2616,   -1897,   -2117,    2354,       0,       0,   -1423,   -1117,
+     -1571,   -1739,       0,   -4421,       0,       0,       0,       0,
+      1165,       0,       0,    8752
+};
+
+/* Table 47.B: Periodic terms for the latitude (Sigma b). Unit: 1e-6 degree. */
+#define NB 60
+static const signed char bD[NB] = {
+   0, 0, 0, 2, 2, 2, 2, 0, 2, 0, 2, 2, 2, 2, 2, 2, 2, 0, 4, 0,
+   0, 0, 1, 0, 0, 0, 1, 0, 4, 4, 0, 4, 2, 2, 2, 2, 0, 2, 2, 2,
+   2, 4, 2, 2, 0, 2, 1, 1, 0, 2, 1, 2, 0, 4, 4, 1, 4, 1, 4, 2
+};
+static const signed char bM[NB] = {
+   0, 0, 0, 0, 0, 0, 0, 0, 0, 0,-1, 0, 0, 1,-1,-1,-1, 1, 0, 1,
+   0, 1, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0,-1, 0, 0, 0, 0, 1,
+   1, 0,-1,-2, 0, 1, 1, 1, 1, 1, 0,-1, 1, 0,-1, 0, 0, 0,-1,-2
+};
+static const signed char bMp[NB] = {
+   0, 1, 1, 0,-1,-1, 0, 2, 1, 2, 0,-2, 1, 0,-1, 0,-1,-1,-1, 0,
+   0,-1, 0, 1, 1, 0, 0, 3, 0,-1, 1,-2, 0, 2, 1,-2, 3, 2,-3,-1,
+   0, 0, 1, 0, 1, 1, 0, 0,-2,-1, 1,-2, 2,-2,-1, 1, 1,-1, 0, 0
+};
+static const signed char bF[NB] = {
+   1, 1,-1,-1, 1,-1, 1, 1,-1,-1,-1,-1, 1,-1, 1, 1,-1,-1,-1, 1,
+   3, 1, 1, 1,-1,-1,-1, 1,-1, 1,-3, 1,-3,-1,-1, 1,-1, 1,-1, 1,
+   1, 1, 1,-1, 3,-1,-1, 1,-1,-1, 1,-1, 1,-1,-1,-1,-1,-1,-1, 1
+};
+static const long bCoef[NB] = {
+  5128122,  280602,  277693,  173237,   55413,   46271,   32573,   17198,
+     9266,    8822,    8216,    4324,    4200,   -3359,    2463,    2211,
+     2065,   -1870,    1828,   -1794,   -1749,   -1565,   -1491,   -1475,
+    -1410,   -1344,   -1335,    1107,    1021,     833,     777,     671,
+      607,     596,     491,    -451,     439,     422,     421,    -366,
+     -351,     331,     315,     302,    -283,    -229,     223,     223,
+     -220,    -220,    -185,     181,    -177,     176,     166,    -164,
+      132,    -119,     115,     107
+};
+
+/* Fill cos/sin tables for the multiples -n..n of an angle, each scaled by f^|k| */
+static void multiples(double rad, int n, double f, double *c, double *s) {
+  int k;
+  double fk = 1.0;
+  c[n] = 1.0;
+  s[n] = 0.0;
+  for (k = 1; k <= n; k++) {
+    fk *= f;
+    c[n+k] = c[n-k] = fk * cos(k * rad);
+    s[n+k] = fk * sin(k * rad);
+    s[n-k] = -s[n+k];
+  }
+}
+
+/* Reduce an angle in degrees to [0, 360) */
+static double norm360(double deg) {
+  deg = fmod(deg, 360.0);
+  if (deg < 0.0) deg += 360.0;
+  return deg;
+}
+
+/* Julian Day of the day 0 of January of a given year, at 0h. Gregorian calendar. */
+double jd_jan0(int year) {
+  return 2440586.5 + (double)days_from_civil(year, 1, 1);	/* JD 2440587.5 = 1970-01-01 0h */
+}
+
+/* Geocentric ecliptic longitude & latitude (degrees), and distance (km) of the Moon */
+void moon_elp(double jde, double *lambda, double *beta, double *dist) {
+  double T, T2, T3, T4;
+  double Lp, D, M, Mp, F, A1, A2, A3, E;
+  double cD[2*MAXD+1], sD[2*MAXD+1];
+  double cM[2*MAXM+1], sM[2*MAXM+1];
+  double cMp[2*MAXMP+1], sMp[2*MAXMP+1];
+  double cF[2*MAXF+1], sF[2*MAXF+1];
+  double sl = 0.0, sr = 0.0, sb = 0.0;
+  int i;
+
+  T = (jde - J2000) / 36525.0;	/* Julian centuries since J2000 */
+  T2 = T * T;
+  T3 = T2 * T;
+  T4 = T3 * T;
+
+  /* Fundamental arguments (47.1 to 47.5) */
+  Lp = norm360(218.3164477 + 481267.88123421 * T - 0.0015786 * T2 + T3 / 538841.0 - T4 / 65194000.0);
+  D  = norm360(297.8501921 + 445267.1114034 * T - 0.0018819 * T2 + T3 / 545868.0 - T4 / 113065000.0);
+  M  = norm360(357.5291092 + 35999.0502909 * T - 0.0001536 * T2 + T3 / 24490000.0);
+  Mp = norm360(134.9633964 + 477198.8675055 * T + 0.0087414 * T2 + T3 / 69699.0 - T4 / 14712000.0);
+  F  = norm360(93.2720950 + 483202.0175233 * T - 0.0036539 * T2 - T3 / 3526000.0 + T4 / 863310000.0);
+  A1 = norm360(119.75 + 131.849 * T);
+  A2 = norm360(53.09 + 479264.290 * T);
+  A3 = norm360(313.45 + 481266.484 * T);
+  E  = 1.0 - 0.002516 * T - 0.0000074 * T2;	/* Earth orbit eccentricity decrease (47.6) */
+
+  /* Precompute the multiples shared by all terms */
+  multiples(dtor(D), MAXD, 1.0, cD, sD);
+  multiples(dtor(M), MAXM, E, cM, sM);		/* Terms in M are multiplied by E^|M| */
+  multiples(dtor(Mp), MAXMP, 1.0, cMp, sMp);
+  multiples(dtor(F), MAXF, 1.0, cF, sF);
+
+  for (i = 0; i < NLR; i++) {
+    int d = lrD[i] + MAXD, m = lrM[i] + MAXM, mp = lrMp[i] + MAXMP, f = lrF[i] + MAXF;
+    double c1 = cD[d] * cM[m] - sD[d] * sM[m];	/* e^i(dD + mM) */
+    double s1 = sD[d] * cM[m] + cD[d] * sM[m];
+    double c2 = cMp[mp] * cF[f] - sMp[mp] * sF[f];	/* e^i(m'M' + fF) */
+    double s2 = sMp[mp] * cF[f] + cMp[mp] * sF[f];
+    sl += lCoef[i] * (s1 * c2 + c1 * s2);
+    sr += rCoef[i] * (c1 * c2 - s1 * s2);
+  }
+  for (i = 0; i < NB; i++) {
+    int d = bD[i] + MAXD, m = bM[i] + MAXM, mp = bMp[i] + MAXMP, f = bF[i] + MAXF;
+    double c1 = cD[d] * cM[m] - sD[d] * sM[m];
+    double s1 = sD[d] * cM[m] + cD[d] * sM[m];
+    double c2 = cMp[mp] * cF[f] - sMp[mp] * sF[f];
+    double s2 = sMp[mp] * cF[f] + cMp[mp] * sF[f];
+    sb += bCoef[i] * (s1 * c2 + c1 * s2);
+  }
+
+  /* Additive terms due to Venus, Jupiter, and the flattening of the Earth */
+  sl += 3958.0 * sin(dtor(A1)) + 1962.0 * sin(dtor(Lp - F)) + 318.0 * sin(dtor(A2));
+  sb += -2235.0 * sin(dtor(Lp)) + 382.0 * sin(dtor(A3))
+	+ 175.0 * sin(dtor(A1 - F)) + 175.0 * sin(dtor(A1 + F))
+	+ 127.0 * sin(dtor(Lp - Mp)) - 115.0 * sin(dtor(Lp + Mp));
+
+  *lambda = norm360(Lp + sl / 1000000.0);
+  *beta = sb / 1000000.0;
+  *dist = 385000.56 + sr / 1000.0;
+
+  if (today_debug) printf("moon_elp(%f) = %f, %f, %f\n", jde, *lambda, *beta, *dist);
+}
+
+/* Geometric ecliptic longitude (degrees) and distance (AU) of the Sun. Meeus chapter 25 */
+void sun_meeus(double jde, double *lambda, double *r) {
+  double T, L0, M, ecc, C, v;
+
+  T = (jde - J2000) / 36525.0;
+  L0 = 280.46646 + 36000.76983 * T + 0.0003032 * T * T;
+  M = dtor(norm360(357.52911 + 35999.05029 * T - 0.0001537 * T * T));
+  ecc = 0.016708634 - 0.000042037 * T - 0.0000001267 * T * T;
+  C = (1.914602 - 0.004817 * T - 0.000014 * T * T) * sin(M)
+    + (0.019993 - 0.000101 * T) * sin(2 * M)
+    + 0.000289 * sin(3 * M);
+  v = M + dtor(C);
+  *lambda = norm360(L0 + C);
+  *r = 1.000001018 * (1 - ecc * ecc) / (1 + ecc * cos(v));
+}
+
+/* Illuminated percentage of the Moon disk, from the Moon longitude, latitude,
+   and distance in km, and the Sun longitude and distance in AU */
+double phase_illum(double lm, double bm, double dm, double ls, double rs) {
+  double cpsi, psi, i;
+
+  rs *= AU_KM;
+  cpsi = cos(dtor(bm)) * cos(dtor(lm - ls));	/* Geocentric elongation (48.2) */
+  psi = acos(cpsi);
+  i = atan2(rs * sin(psi), dm - rs * cpsi);	/* Phase angle (48.3) */
+  return 50.0 * (1.0 + cos(i));			/* Illuminated fraction (48.1) */
+}
+
+/* Illuminated percentage of the Moon disk, at a given Julian Ephemeris Day */
+double moon_illum_elp(double jde) {
+  double lm, bm, dm, ls, rs;
+
+  moon_elp(jde, &lm, &bm, &dm);
+  sun_meeus(jde, &ls, &rs);
+  return phase_illum(lm, bm, dm, ls, rs);
+}
+
+/* Drop-in replacement for potm(). days = Days since 0 January EPOCH, 0h */
+double potm_elp(double days) {
+  return moon_illum_elp(jd_jan0(EPOCH) + days);
+}
+
+/* Convert a Julian Day to a GMT date and time. Proleptic Gregorian calendar,
+   like jd_jan0() and tm_to_jd(), so that the conversions round trip. */
+void jd_to_tm(double jd, struct tm *ptm) {
+  long Z, secs;
+  int year, month, day;
+  static int cumDays[] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+
+  jd += 0.5;
+  Z = (long)floor(jd);
+  secs = (long)floor((jd - (double)Z) * 86400.0 + 0.5);
+  if (secs >= 86400L) {
+    secs -= 86400L;
+    Z += 1;
+  }
+  civil_from_days(Z - 2440588L, &year, &month, &day);	/* JD 2440588 = 1970-01-01 */
+
+  ptm->tm_year = year - 1900;
+  ptm->tm_mon = month - 1;
+  ptm->tm_mday = day;
+  ptm->tm_hour = (int)(secs / 3600);
+  ptm->tm_min = (int)((secs / 60) % 60);
+  ptm->tm_sec = (int)(secs % 60);
+  ptm->tm_wday = (int)((Z + 1) % 7);
+  ptm->tm_yday = cumDays[month-1] + day - 1
+	       + ((month > 2) && ((year%4 == 0 && year%100 != 0) || year%400 == 0));
+  ptm->tm_isdst = 0;
+}
+
+/* Approximate difference TT - UT, in seconds. Espenak & Meeus polynomials
+   for recent years, else the Morrison & Stephenson long-term parabola. */
+double delta_t(double jd) {
+  double y = 2000.0 + (jd - J2000) / 365.25;
+  double t = y - 2000.0;
+  double u = (y - 1820.0) / 100.0;
+
+  if (y >= 1986.0 && y < 2005.0) {
+    return 63.86 + t * (0.3345 + t * (-0.060374 + t * (0.0017275 + t * (0.000651814 + t * 0.00002373599))));
+  }
+  if (y >= 2005.0 && y < 2050.0) {
+    return 62.92 + t * (0.32217 + t * 0.005589);
+  }
+  if (y >= 2050.0 && y < 2150.0) {
+    return -20.0 + 32.0 * u * u - 0.5628 * (2150.0 - y);
+  }
+  return -20.0 + 32.0 * u * u;
+}
+
+/* Find the JDE nearest to jde when the Moon apparent elongation is angle degrees.
+   0 = New moon; 90 = First quarter; 180 = Full moon; 270 = Last quarter. */
+double moon_phase_jde(double jde, double angle) {
+  int i;
+  for (i = 0; i < 10; i++) {
+    double lm, bm, dm, ls, rs, dl;
+    moon_elp(jde, &lm, &bm, &dm);
+    sun_meeus(jde, &ls, &rs);
+    ls -= 0.005694;		/* Aberration of the Sun's light (25.8, average) */
+    dl = norm360(lm - ls - angle + 180.0) - 180.0;	/* In [-180, 180) */
+    jde -= dl / 12.190749;	/* Mean elongation rate, in degrees/day */
+    if (fabs(dl) < 1e-6) break;	/* Converged within ~0.01s */
+  }
+  return jde;
+}
+
+/* Convert a GMT date and time to a Julian Day. Missing time fields (< 0) count as 0. */
+double tm_to_jd(struct tm *ptm) {
+  static int cumDays[] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+  int year = ptm->tm_year + 1900;
+  int month = ptm->tm_mon + 1;
+  double hours = 0.0;
+
+  if (ptm->tm_hour > 0) hours += ptm->tm_hour;
+  if (ptm->tm_min > 0) hours += ptm->tm_min / 60.0;
+  if (ptm->tm_sec > 0) hours += ptm->tm_sec / 3600.0;
+  return jd_jan0(year) + cumDays[month-1] + ptm->tm_mday + hours / 24.0
+	 + ((month > 2) && ((year%4 == 0 && year%100 != 0) || year%400 == 0));
+}
@@ -38,6 +38,17 @@
      
      Or use ASCII art to draw the moon?
 
+     History:
+     2026-10-18 JFL Added the pPotm engine selector, for using potm_elp().
+                    Split potm() into moon_state(), reporting the node, etc.
+     2026-10-19 JFL Added moon_illum() and moon_phase_name(), for the
+                    machine-readable outputs.
+                    Added moon_illum_with(), using a given engine, for libtoday.
+                    Bugfix: tm_days() returned the days of EPOCH for any
+                    earlier year. Found by todaycheck.
+                    Renamed pPotm today_potm, as it's in libtoday.a.
+                   Count the ptr_adj360() range loops, for today --stats.
+
  ****************************************************************************/
 
 #include <stdlib.h>
@@ -51,13 +62,17 @@
 
 /* Forward references to local routines */
 /* void  moontxt(char buf[]);	// In today.h */
-double potm(double days);
+/* double potm(double days);	// In today.h */
 /* double dtor(double deg);  	// In today.h */
 int ly(int yr);
 void ptr_adj360(double *deg);
+static double tm_days(struct tm *pt);
 
 struct tm *gmtime();
 
+/* Phase of the moon engine. Either potm() below, or the slower but more accurate potm_elp() */
+double (*today_potm)(double days) = potm;
+
 void moontxt(buf, pt)
 char	buf[];
 struct	tm *pt;  /* ptr to time structure */
@@ -66,24 +81,19 @@ struct	tm *pt;  /* ptr to time structure */
   double days;   /* days since EPOCH */
   double phase;  /* percent of lunar surface illuminated */
   double phase2; /* percent of lunar surface illuminated one day later */
-  int i = EPOCH;
 
-  if (debug) printf("moontxt(%p, %p);\n", buf, pt);
+  if (today_debug) printf("moontxt(%p, %p);\n", buf, pt);
 
   if (!pt) {	/* If we were given no date, use now */
     time_t lo;		/* used by time calls */
     time(&lo);          /* get system time */
     pt = gmtime(&lo);   /* get ptr to gmt time struct */
   }
-  if (debug) printf("pt = {%d, %d, %d, %d, %d, %d, %d);\n", pt->tm_year, pt->tm_mon, pt->tm_mday, pt->tm_hour, pt->tm_min, pt->tm_sec, pt->tm_isdst);
+  if (today_debug) printf("pt = {%d, %d, %d, %d, %d, %d, %d);\n", pt->tm_year, pt->tm_mon, pt->tm_mday, pt->tm_hour, pt->tm_min, pt->tm_sec, pt->tm_isdst);
 
-  /* calculate days since EPOCH */
-  days = (pt->tm_yday +1.0) + ((pt->tm_hour + (pt->tm_min / 60.0)
-				+ (pt->tm_sec / 3600.0)) / 24.0);
-  while (i < pt->tm_year + 1900)
-    days = days + 365 + ly(i++);
+  days = tm_days(pt);	/* days since EPOCH */
 
-  phase = potm(days);
+  phase = (*today_potm)(days);
   sprintf(cp,"The Moon is ");
   cp += strlen(buf);
   if ((int)(phase + .5) == 100) {
@@ -92,14 +102,14 @@ struct	tm *pt;  /* ptr to time structure */
   else if ((int)(phase + 0.5) == 0) 
     sprintf(cp,"New");
   else if ((int)(phase + 0.5) == 50)  {
-    phase2 = potm(++days);
+    phase2 = (*today_potm)(++days);
     if (phase2 > phase)
       sprintf(cp,"at the First Quarter");
     else 
       sprintf(cp,"at the Last Quarter");
   }
   else if ((int)(phase + 0.5) > 50) {
-    phase2 = potm(++days);
+    phase2 = (*today_potm)(++days);
     if (phase2 > phase)
       sprintf(cp,"Waxing ");
     else 
@@ -108,7 +118,7 @@ struct	tm *pt;  /* ptr to time structure */
     sprintf(cp,"Gibbous (%1.0f%% of Full)", phase);
   }
   else if ((int)(phase + 0.5) < 50) {
-    phase2 = potm(++days);
+    phase2 = (*today_potm)(++days);
     if (phase2 > phase)
       sprintf(cp,"Waxing ");
     else
@@ -118,6 +128,66 @@ struct	tm *pt;  /* ptr to time structure */
   }
 }
 
+/* Days since EPOCH, at the GMT time *pt */
+static double tm_days(pt)
+struct	tm *pt;
+{
+  double days;
+  int i = EPOCH;
+
+  days = (pt->tm_yday +1.0) + ((pt->tm_hour + (pt->tm_min / 60.0)
+				+ (pt->tm_sec / 3600.0)) / 24.0);
+  while (i < pt->tm_year + 1900)
+    days = days + 365 + ly(i++);
+  while (i > pt->tm_year + 1900)	/* Dates before EPOCH */
+    days = days - 365 - ly(--i);
+  return days;
+}
+
+/* Illuminated percentage of the moon, and whether it's waxing */
+double moon_illum(pt, pWaxing)
+struct	tm *pt;  /* ptr to time structure. NULL = now */
+int	*pWaxing;
+{
+  return moon_illum_with(today_potm, pt, pWaxing);
+}
+
+/* Same as moon_illum(), using a given phase engine: potm or potm_elp */
+double moon_illum_with(pfn, pt, pWaxing)
+double	(*pfn)(double days);
+struct	tm *pt;  /* ptr to time structure. NULL = now */
+int	*pWaxing;
+{
+  double days;
+  double phase;
+  struct tm stm;
+
+  if (!pt) {	/* If we were given no date, use now */
+    time_t lo;		/* used by time calls */
+    time(&lo);          /* get system time */
+    utc_to_tm(lo, 0, 0, &stm);	/* gmtime() is not reentrant */
+    pt = &stm;
+  }
+  days = tm_days(pt);
+  phase = (*pfn)(days);
+  if (pWaxing) *pWaxing = ((*pfn)(days + 0.1) > phase);
+  return phase;
+}
+
+/* Name of the phase, rounded like in moontxt() */
+char *moon_phase_name(phase, waxing)
+double phase;	/* Illuminated percentage */
+int waxing;
+{
+  int percent = (int)(phase + 0.5);
+
+  if (percent == 100) return "full";
+  if (percent == 0) return "new";
+  if (percent == 50) return waxing ? "first_quarter" : "last_quarter";
+  if (percent > 50) return waxing ? "waxing_gibbous" : "waning_gibbous";
+  return waxing ? "waxing_crescent" : "waning_crescent";
+}
+
 /* Moon ASCII-Art generator */
 char *moonaa(nLines, nCols, inverse, pt)
 int nLines;
@@ -129,7 +199,7 @@ struct	tm *pt;  /* ptr to time structure */
   double days;   /* days since EPOCH */
   double phase;  /* percent of lunar surface illuminated */
   double phase2; /* percent of lunar surface illuminated one day later */
-  int i = EPOCH;
+  int i;
   char FourChars[] = " ',#";
   double lineWidth;
   double colWidth;
@@ -143,7 +213,7 @@ struct	tm *pt;  /* ptr to time structure */
   double epsilon;
   int iYPixel;
 
-  if (debug) printf("moonaa(%d, %d, %p);\n", nLines, nCols, pt);
+  if (today_debug) printf("moonaa(%d, %d, %p);\n", nLines, nCols, pt);
   
   if ((!nLines) || (!nCols)) {
     fprintf(stderr, "Error: Ascii Art array sizes can't be 0\n");
@@ -160,24 +230,20 @@ struct	tm *pt;  /* ptr to time structure */
     time(&lo);          /* get system time */
     pt = gmtime(&lo);   /* get ptr to gmt time struct */
   }
-  if (debug) printf("pt = {%d, %d, %d, %d, %d, %d, %d);\n", pt->tm_year, pt->tm_mon, pt->tm_mday, pt->tm_hour, pt->tm_min, pt->tm_sec, pt->tm_isdst);
+  if (today_debug) printf("pt = {%d, %d, %d, %d, %d, %d, %d);\n", pt->tm_year, pt->tm_mon, pt->tm_mday, pt->tm_hour, pt->tm_min, pt->tm_sec, pt->tm_isdst);
 
-  /* calculate days since EPOCH */
-  days = (pt->tm_yday +1.0) + ((pt->tm_hour + (pt->tm_min / 60.0)
-				+ (pt->tm_sec / 3600.0)) / 24.0);
-  while (i < pt->tm_year + 1900)
-    days = days + 365 + ly(i++);
+  days = tm_days(pt);	/* days since EPOCH */
 
-  phase = potm(days);
-  if (debug) printf("The Moon is %d full\n", (int)(phase + 0.5));
+  phase = (*today_potm)(days);
+  if (today_debug) printf("The Moon is %d full\n", (int)(phase + 0.5));
 
-  phase2 = potm(days + 0.1);
+  phase2 = (*today_potm)(days + 0.1);
 
   phase /= 100;		/* Convert percentage to 1x factor */
   phase2 /= 100;	/* Convert percentage to 1x factor */
 
   if (phase2 > phase) {
-    if (debug) printf("at the First Quarter\n");
+    if (today_debug) printf("at the First Quarter\n");
     colorLeft = 0;
     colorRight = 1;
     if (phase < 0.5) {	/* The terminator is on the right side */
@@ -188,7 +254,7 @@ struct	tm *pt;  /* ptr to time structure */
       xPlus = 0.0;
     }
   } else { 
-    if (debug) printf("at the Last Quarter\n");
+    if (today_debug) printf("at the Last Quarter\n");
     colorLeft = 1;
     colorRight = 0;
     if (phase < 0.5) {	/* The terminator is on the left side */
@@ -261,8 +327,10 @@ struct	tm *pt;  /* ptr to time structure */
   return buf;
 }
 
-double potm(days)
+/* Compute the moon state, including the phase and its main intermediate results */
+void moon_state(days, pms)
 double days;
+MOONSTATE *pms;
 {
   double N;
   double Msol;
@@ -320,7 +388,21 @@ double days;
   
   D = ldprime - LambdaSol;             /* sec 63 #2 */
   
-  return (50.0 * (1 - cos(dtor(D))));    /* sec 63 #3 */
+  pms->LambdaSol = LambdaSol;
+  pms->l = l;
+  pms->Nm = Nm;
+  pms->ldprime = ldprime;
+  pms->D = D;
+  pms->phase = 50.0 * (1 - cos(dtor(D))); /* sec 63 #3 */
+}
+
+double potm(days)
+double days;
+{
+  MOONSTATE ms;
+
+  moon_state(days, &ms);
+  return ms.phase;
 }
 
 int ly(yr)
@@ -341,10 +423,12 @@ void ptr_adj360(deg)
 double *deg;
 {
   /* adjust value so 0 <= deg <= 360 */
-  do if (*deg < 0.0)
+  do if (*deg < 0.0) {
     *deg += 360.0;
-  else if (*deg > 360.0)
+    TRACE_COUNT(TC_RANGE, 1);
+  } else if (*deg > 360.0) {
     *deg -= 360.0;
-  while (*deg < 0.0 || *deg > 360.0);
+    TRACE_COUNT(TC_RANGE, 1);
+  } while (*deg < 0.0 || *deg > 360.0);
 }
 
@@ -0,0 +1,127 @@
+/*
+** nbrgen.c - Generate the number names tables in nbrtab.h
+**
+** The number names used by nbrtxt() are assembled from a few phrases,
+** precomputed with their lengths: The cardinal and ordinal names of all
+** numbers from 0 to 99, and the names of the hundreds.
+** They're generated by the original recursive nbrtxt() algorithm, kept here
+** as the reference, so that the output of the table-driven version is the
+** same as it always was.
+**
+** The generated nbrtab.h is part of the sources, so that it's available for
+** all build systems. After changing this program, rebuild it with:
+**   make nbrtab.h
+**
+** Authors:
+**   JFL jf.larvoire@free.fr
+**
+** History:
+**   2026-10-19 JFL Created this program.
+*/
+
+#define VERSION "2026-10-19"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "versions.h"
+
+#define streq(s1, s2) (!strcmp(s1, s2))
+
+static char *cardinal[] = {
+	"zero", "one", "two", "three", "four", "five", "six", "seven",
+	"eight", "nine", "ten", "eleven", "twelve", "thirteen", "fourteen",
+	"fifteen", "sixteen", "seventeen", "eighteen", "nineteen"
+};
+
+static char *ordinal[] = {
+	"zeroth", "first", "second", "third", "fourth", "fifth", "sixth",
+	"seventh", "eighth", "ninth", "tenth", "eleventh", "twelfth"
+};
+
+static char *twenties[] = {
+	"twen", "thir", "for", "fif", "six", "seven", "eigh", "nine"
+};
+
+/* Copy a string. Return a pointer to the NUL at its end */
+static char *copyst(char *op, char *ip) {
+  while ((*op = *ip++) != '\0') op++;
+  return op;
+}
+
+/* The reference nbrtxt() algorithm, for values from 0 to 999 */
+static char *ref_nbrtxt(char *op, int value, int ordflag) {
+  if (value >= 100) {
+    op = copyst(op, cardinal[value/100]);
+    op = copyst(op, " hundred");
+    value = value % 100;
+    if (value == 0) goto exit;
+    op = copyst(op, " ");
+  }
+  if (value >= 20) {
+    if (value == 90 && ordflag)
+      return(copyst(op, "nintieth"));
+    op = copyst(op, twenties[(value-20) / 10]);
+    value = value % 10;
+    if (value == 0) {
+      return(copyst(op, (ordflag) ? "tieth" : "ty"));
+    }
+    op = copyst(op, "ty-");
+  }
+  if (value <= 12) {
+    return(copyst(op, (ordflag) ? ordinal[value] : cardinal[value]));
+  }
+  op = copyst(op, cardinal[value]);	/* fourteen, fourteenth */
+exit:
+  if (ordflag) op = copyst(op, "th");
+  return(op);
+}
+
+/* Output a table of n names, for the values from 0 to (n-1)*step */
+static void table(char *pszName, int n, int step, int ordflag) {
+  char buf[64];
+  int i;
+
+  printf("static const NBRNAME %s[%d] = {\n", pszName, n);
+  for (i = 0; i < n; i++) {
+    int l = (int)(ref_nbrtxt(buf, i * step, ordflag) - buf);
+    if (!i && (step == 100)) l = buf[0] = '\0';	/* No hundreds */
+    printf("  {%2d, \"%s\"}%s\n", l, buf, (i < (n-1)) ? "," : "");
+  }
+  printf("};\n\n");
+}
+
+int main(int argc, char *argv[]) {
+  int i;
+
+  for (i=1; i<argc; i++) {
+    char *arg = argv[i];
+    if (   streq(arg, "-?")
+        || streq(arg, "-h")
+        || streq(arg, "--help")) {
+      printf("nbrgen - Generate the number names tables in nbrtab.h\n\nUsage: nbrgen > nbrtab.h\n");
+      return 0;
+    }
+    if (   streq(arg, "-V")
+	|| streq(arg, "--version")) {
+      printf(VERSION " " EXE_OS_NAME "\n");
+      return 0;
+    }
+    fprintf(stderr, "Unexpected argument: %s\n", arg);
+    return 1;
+  }
+
+  printf("/*\n");
+  printf(" * nbrtab.h - Number names used by nbrtxt(), with their lengths\n");
+  printf(" *\n");
+  printf(" * Generated by nbrgen.c. Do not edit.\n");
+  printf(" */\n\n");
+  printf("typedef struct {\n");
+  printf("  unsigned char len;\n");
+  printf("  char *text;\n");
+  printf("} NBRNAME;\n\n");
+  table("nbr_cardinal", 100, 1, 0);
+  table("nbr_ordinal", 100, 1, 1);
+  table("nbr_hundreds", 10, 100, 0);
+  return 0;
+}
@@ -0,0 +1,230 @@
+/*
+ * nbrtab.h - Number names used by nbrtxt(), with their lengths
+ *
+ * Generated by nbrgen.c. Do not edit.
+ */
+
+typedef struct {
+  unsigned char len;
+  char *text;
+} NBRNAME;
+
+static const NBRNAME nbr_cardinal[100] = {
+  { 4, "zero"},
+  { 3, "one"},
+  { 3, "two"},
+  { 5, "three"},
+  { 4, "four"},
+  { 4, "five"},
+  { 3, "six"},
+  { 5, "seven"},
+  { 5, "eight"},
+  { 4, "nine"},
+  { 3, "ten"},
+  { 6, "eleven"},
+  { 6, "twelve"},
+  { 8, "thirteen"},
+  { 8, "fourteen"},
+  { 7, "fifteen"},
+  { 7, "sixteen"},
+  { 9, "seventeen"},
+  { 8, "eighteen"},
+  { 8, "nineteen"},
+  { 6, "twenty"},
+  {10, "twenty-one"},
+  {10, "twenty-two"},
+  {12, "twenty-three"},
+  {11, "twenty-four"},
+  {11, "twenty-five"},
+  {10, "twenty-six"},
+  {12, "twenty-seven"},
+  {12, "twenty-eight"},
+  {11, "twenty-nine"},
+  { 6, "thirty"},
+  {10, "thirty-one"},
+  {10, "thirty-two"},
+  {12, "thirty-three"},
+  {11, "thirty-four"},
+  {11, "thirty-five"},
+  {10, "thirty-six"},
+  {12, "thirty-seven"},
+  {12, "thirty-eight"},
+  {11, "thirty-nine"},
+  { 5, "forty"},
+  { 9, "forty-one"},
+  { 9, "forty-two"},
+  {11, "forty-three"},
+  {10, "forty-four"},
+  {10, "forty-five"},
+  { 9, "forty-six"},
+  {11, "forty-seven"},
+  {11, "forty-eight"},
+  {10, "forty-nine"},
+  { 5, "fifty"},
+  { 9, "fifty-one"},
+  { 9, "fifty-two"},
+  {11, "fifty-three"},
+  {10, "fifty-four"},
+  {10, "fifty-five"},
+  { 9, "fifty-six"},
+  {11, "fifty-seven"},
+  {11, "fifty-eight"},
+  {10, "fifty-nine"},
+  { 5, "sixty"},
+  { 9, "sixty-one"},
+  { 9, "sixty-two"},
+  {11, "sixty-three"},
+  {10, "sixty-four"},
+  {10, "sixty-five"},
+  { 9, "sixty-six"},
+  {11, "sixty-seven"},
+  {11, "sixty-eight"},
+  {10, "sixty-nine"},
+  { 7, "seventy"},
+  {11, "seventy-one"},
+  {11, "seventy-two"},
+  {13, "seventy-three"},
+  {12, "seventy-four"},
+  {12, "seventy-five"},
+  {11, "seventy-six"},
+  {13, "seventy-seven"},
+  {13, "seventy-eight"},
+  {12, "seventy-nine"},
+  { 6, "eighty"},
+  {10, "eighty-one"},
+  {10, "eighty-two"},
+  {12, "eighty-three"},
+  {11, "eighty-four"},
+  {11, "eighty-five"},
+  {10, "eighty-six"},
+  {12, "eighty-seven"},
+  {12, "eighty-eight"},
+  {11, "eighty-nine"},
+  { 6, "ninety"},
+  {10, "ninety-one"},
+  {10, "ninety-two"},
+  {12, "ninety-three"},
+  {11, "ninety-four"},
+  {11, "ninety-five"},
+  {10, "ninety-six"},
+  {12, "ninety-seven"},
+  {12, "ninety-eight"},
+  {11, "ninety-nine"}
+};
+
+static const NBRNAME nbr_ordinal[100] = {
+  { 6, "zeroth"},
+  { 5, "first"},
+  { 6, "second"},
+  { 5, "third"},
+  { 6, "fourth"},
+  { 5, "fifth"},
+  { 5, "sixth"},
+  { 7, "seventh"},
+  { 6, "eighth"},
+  { 5, "ninth"},
+  { 5, "tenth"},
+  { 8, "eleventh"},
+  { 7, "twelfth"},
+  {10, "thirteenth"},
+  {10, "fourteenth"},
+  { 9, "fifteenth"},
+  { 9, "sixteenth"},
+  {11, "seventeenth"},
+  {10, "eighteenth"},
+  {10, "nineteenth"},
+  { 9, "twentieth"},
+  {12, "twenty-first"},
+  {13, "twenty-second"},
+  {12, "twenty-third"},
+  {13, "twenty-fourth"},
+  {12, "twenty-fifth"},
+  {12, "twenty-sixth"},
+  {14, "twenty-seventh"},
+  {13, "twenty-eighth"},
+  {12, "twenty-ninth"},
+  { 9, "thirtieth"},
+  {12, "thirty-first"},
+  {13, "thirty-second"},
+  {12, "thirty-third"},
+  {13, "thirty-fourth"},
+  {12, "thirty-fifth"},
+  {12, "thirty-sixth"},
+  {14, "thirty-seventh"},
+  {13, "thirty-eighth"},
+  {12, "thirty-ninth"},
+  { 8, "fortieth"},
+  {11, "forty-first"},
+  {12, "forty-second"},
+  {11, "forty-third"},
+  {12, "forty-fourth"},
+  {11, "forty-fifth"},
+  {11, "forty-sixth"},
+  {13, "forty-seventh"},
+  {12, "forty-eighth"},
+  {11, "forty-ninth"},
+  { 8, "fiftieth"},
+  {11, "fifty-first"},
+  {12, "fifty-second"},
+  {11, "fifty-third"},
+  {12, "fifty-fourth"},
+  {11, "fifty-fifth"},
+  {11, "fifty-sixth"},
+  {13, "fifty-seventh"},
+  {12, "fifty-eighth"},
+  {11, "fifty-ninth"},
+  { 8, "sixtieth"},
+  {11, "sixty-first"},
+  {12, "sixty-second"},
+  {11, "sixty-third"},
+  {12, "sixty-fourth"},
+  {11, "sixty-fifth"},
+  {11, "sixty-sixth"},
+  {13, "sixty-seventh"},
+  {12, "sixty-eighth"},
+  {11, "sixty-ninth"},
+  {10, "seventieth"},
+  {13, "seventy-first"},
+  {14, "seventy-second"},
+  {13, "seventy-third"},
+  {14, "seventy-fourth"},
+  {13, "seventy-fifth"},
+  {13, "seventy-sixth"},
+  {15, "seventy-seventh"},
+  {14, "seventy-eighth"},
+  {13, "seventy-ninth"},
+  { 9, "eightieth"},
+  {12, "eighty-first"},
+  {13, "eighty-second"},
+  {12, "eighty-third"},
+  {13, "eighty-fourth"},
+  {12, "eighty-fifth"},
+  {12, "eighty-sixth"},
+  {14, "eighty-seventh"},
+  {13, "eighty-eighth"},
+  {12, "eighty-ninth"},
+  { 8, "nintieth"},
+  {12, "ninety-first"},
+  {13, "ninety-second"},
+  {12, "ninety-third"},
+  {13, "ninety-fourth"},
+  {12, "ninety-fifth"},
+  {12, "ninety-sixth"},
+  {14, "ninety-seventh"},
+  {13, "ninety-eighth"},
+  {12, "ninety-ninth"}
+};
+
+static const NBRNAME nbr_hundreds[10] = {
+  { 0, ""},
+  {11, "one hundred"},
+  {11, "two hundred"},
+  {13, "three hundred"},
+  {12, "four hundred"},
+  {12, "five hundred"},
+  {11, "six hundred"},
+  {13, "seven hundred"},
+  {13, "eight hundred"},
+  {12, "nine hundred"}
+};
+
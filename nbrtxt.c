@@ -8,6 +8,9 @@
  *      int     value;          -- The number to output
  *      int     ordinal;        -- Non-zero for ordinal number
  *
+ *      int nbrtxt_n(buffer, size, value, ordinal)
+ *      size_t  size;           -- The output buffer size
+ *
  *
  * The value is converted to a readable number and put in the output
  * buffer (null-terminated).  A pointer to the first free location
@@ -17,10 +20,15 @@
  *      nbrtxt(buffer, 1, 0) = "one"
  *      nbrtxt(buffer, 1, 1) = "first"
  *
+ * nbrtxt_n() writes at most size bytes, including the null, and returns
+ * the length of the full text, like snprintf().
+ *
  * The longest output string is:
  *
  *      Twenty-seven thousand, three hundred and seventy-seventh.
  *
+ * The text is assembled from the precomputed names of the numbers from
+ * 0 to 99, and of the hundreds, in nbrtab.h. (Generated by nbrgen.c)
  *
  *
  *              Copy a String
@@ -34,123 +42,131 @@
  * The input string is copied into the output string.  Copyst returns
  * a pointer to the null trailer.
  *
+ *
+ *              Append Text to a Bounded Buffer
+ *
+ * Synopsis
+ *
+ *      size_t txtadd(buffer, size, len, string, n)
+ *      size_t nbradd(buffer, size, len, value, ordinal)
+ *
+ * Append n bytes of string, or the text of value, at offset len in the
+ * buffer of the given size. The text is truncated if needed, and always
+ * null-terminated. Return the new offset, as if the buffer were large enough.
+ *
+ * History:
+ *   2026-10-19 JFL Use the precomputed names tables in nbrtab.h, instead of
+ *		    recursive string copies. Added the bounded nbrtxt_n(), and
+ *		    the txtadd() and nbradd() routines for building texts.
  */
 
+#include <string.h>
+
 #include "today.h"
+#include "nbrtab.h"
 
 /* Forward references to local routines */
 /* char *nbrtxt(char *buffer, int datum, int ordflag); // Defined in today.h */
 /* char *copyst(char *buffer, char *string); // Defined in today.h */
+static size_t nbradd_u(char *buffer, size_t size, size_t len, unsigned long value, int ordflag);
 
-static char *cardinal[] = {
-	"zero",
-	"one",
-	"two",
-	"three",
-	"four",
-	"five",
-	"six",
-	"seven",
-	"eight",
-	"nine",
-	"ten",
-	"eleven",
-	"twelve",
-	"thirteen",
-	"fourteen",
-	"fifteen",
-	"sixteen",
-	"seventeen",
-	"eighteen",
-	"nineteen"
-};
-
-static char *ordinal[] = {
-	"zeroth",
-	"first",
-	"second",
-	"third",
-	"fourth",
-	"fifth",
-	"sixth",
-	"seventh",
-	"eighth",
-	"ninth",
-	"tenth",
-	"eleventh",
-	"twelfth"
-};
-
-static char *twenties[] = {
-	"twen",
-	"thir",
-	"for",
-	"fif",
-	"six",
-	"seven",
-	"eigh",
-	"nine"
-};
+size_t txtadd(buffer, size, len, string, n)
+char    *buffer;                        /* Output buffer                */
+size_t  size;                           /* Its size                     */
+size_t  len;                            /* Length of the text in it     */
+const char *string;                     /* What to append               */
+size_t  n;                              /* Its length                   */
+/*
+ * Append a string to the text in a bounded buffer.
+ */
+{
+	if (len < size) {
+		size_t room = size - 1 - len;
+		if (n < room) room = n;
+		memcpy(buffer + len, string, room);
+		buffer[len + room] = '\0';
+	}
+	return(len + n);
+}
 
-char *nbrtxt(buffer, datum, ordflag)
-char    *buffer;                        /* Output string buffer         */
+size_t nbradd(buffer, size, len, datum, ordflag)
+char    *buffer;                        /* Output buffer                */
+size_t  size;                           /* Its size                     */
+size_t  len;                            /* Length of the text in it     */
 int     datum;                          /* what to translate            */
 int     ordflag;                        /* 0 if cardinal, 1 if ordinal  */
 /*
- * Translate a number to a readable text string, punctuation and all.
- * If ordflag is non-zero, ordinal numbers ("first, second") will
- * be generated, rather than cardinal ("one, two").
- * Note: nbrtxt() is recursive.
+ * Append a number to the text in a bounded buffer.
  */
 {
+	unsigned long value = (unsigned long)datum;
 
-	register int value;
-	register char   *op;
-
-	op = buffer;
-	value = datum;
-	if (value < 0) {
-		op = copyst(op, "minus ");
-		value = (-value);
-		if (value < 0) {                /* Hack -32768          */
-			op = copyst(op, twenties[1]);
-			value = 2768;
-		}
+	if (datum < 0) {
+		len = txtadd(buffer, size, len, "minus ", 6);
+		value = 0UL - value;            /* Works for INT_MIN too */
 	}
+	return(nbradd_u(buffer, size, len, value, ordflag));
+}
+
+static size_t nbradd_u(buffer, size, len, value, ordflag)
+char    *buffer;
+size_t  size;
+size_t  len;
+unsigned long value;
+int     ordflag;
+/*
+ * Append a positive number. Recursive only for the millions and above.
+ */
+{
+	const NBRNAME *pn;
+
 	if (value >= 1000) {
-		op = nbrtxt(op, value/1000, 0);
-		op = copyst(op, " thousand");
+		len = nbradd_u(buffer, size, len, value/1000, 0);
+		len = TXTADD(buffer, size, len, " thousand", 9);
 		value = value % 1000;
 		if (value == 0) goto exit;
-		op = copyst(op, (value >= 100) ? ", " : " and ");
+		len = (value >= 100) ? txtadd(buffer, size, len, ", ", 2)
+				     : txtadd(buffer, size, len, " and ", 5);
 	}
 	if (value >= 100) {
-		op = copyst(op, cardinal[value/100]);
-		op = copyst(op, " hundred");
+		pn = nbr_hundreds + value/100;  /* "one hundred", ...   */
+		len = txtadd(buffer, size, len, pn->text, pn->len);
 		value = value % 100;
 		if (value == 0) goto exit;
-		op = copyst(op, " ");
+		len = TXTADD(buffer, size, len, " ", 1);
 	}
-	if (value >= 20) {
-		if (value == 90 && ordflag)
-			return(copyst(op, "nintieth"));
-		op = copyst(op, twenties[(value-20) / 10]);
-		value = value % 10;
-		if (value == 0) {
-			return(copyst(op, (ordflag) ? "tieth" : "ty"));
-		}
-		op = copyst(op, "ty-");
-	}
-	if (value <= 12) {
-		return(copyst(op,
-			(ordflag) ? ordinal[value] : cardinal[value]));
-	}
-	op = copyst(op, cardinal[value]);       /* fourteen, fourteenth */
+	pn = (ordflag ? nbr_ordinal : nbr_cardinal) + value;
+	return(txtadd(buffer, size, len, pn->text, pn->len));
 	/*
 	 * Here on 100, 14000, etc.
 	 */
-exit:   if (ordflag) op = copyst(op, "th");
-	return(op);
+exit:   if (ordflag) len = TXTADD(buffer, size, len, "th", 2);
+	return(len);
+}
+
+int nbrtxt_n(buffer, size, datum, ordflag)
+char    *buffer;                        /* Output string buffer         */
+size_t  size;                           /* Its size                     */
+int     datum;                          /* what to translate            */
+int     ordflag;                        /* 0 if cardinal, 1 if ordinal  */
+/*
+ * Translate a number to a readable text string, punctuation and all.
+ * If ordflag is non-zero, ordinal numbers ("first, second") will
+ * be generated, rather than cardinal ("one, two").
+ */
+{
+	return((int)nbradd(buffer, size, 0, datum, ordflag));
+}
+
+char *nbrtxt(buffer, datum, ordflag)
+char    *buffer;                        /* Output string buffer         */
+int     datum;                          /* what to translate            */
+int     ordflag;                        /* 0 if cardinal, 1 if ordinal  */
+/*
+ * Same as nbrtxt_n(), for a buffer assumed to be large enough.
+ */
+{
+	return(buffer + nbradd(buffer, TXT_UNBOUNDED, 0, datum, ordflag));
 }
 
 #ifdef _MSC_VER
@@ -178,4 +194,3 @@ char    *string;
 #ifdef _MSC_VER
 #pragma warning(default:4706)
 #endif
-
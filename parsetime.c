@@ -11,29 +11,109 @@
  * 2019-01-20 JFL Allow entering just the time, in which case use today's date.
  *		  Added support for GMT times, when there's a Z suffix.
  * 2019-11-11 JFL Added support for dates in the ISO 8601 YYYY-DDD format.
+ * 2026-10-19 JFL Added days_from_civil() and civil_from_days().
+ *		  Rewrote parsetime() without mktime() and localtime(), using the
+ *		  TZif file of the system time zone, loaded once. Made it reentrant.
+ *		  Added parsetime_tz(), for parsing a time in any time zone.
+ *		  Added a fast path for the canonical YYYY-MM-DDTHH:MM:SS format.
+ *		  Added support for RFC 3339 UTC offsets, and fractional seconds.
+ *		  Added tm_normalize(), for date arithmetic in the system time zone.
+ *		  Made system_tz() and utc_to_tm() public, for use by threads.
+ *		  Added tm_normalize_tz(), for any time zone.
+ *		  Reject the malformed UTC offsets, instead of ignoring them.
+ *		  Added parsetime_nominal(), for the start of date ranges.
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 #include <string.h>
 #include <ctype.h>
 
 #include "today.h"
  
-char    *valptr;                        /* Needed for number converter  */
-int day_month[] = {			/* Needed for parsetime()      */
+static const int day_month[] = {	/* Needed for parsetime()      */
 	0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
 };
 
-static int getval(int flag, int low, int high);
-static int getvalN(int flag, int low, int high, int nDigits);
+typedef struct _PARSER {		/* Parser state, instead of a global */
+  const char *p;			/* Next character to parse	*/
+  const char *pEnd;			/* End of the text to parse	*/
+} PARSER;
+
+/* Character at offset i from the parser pointer, or '\0' beyond the end */
+#define PEEK(pp, i) (((pp)->p + (i) < (pp)->pEnd) ? (pp)->p[i] : '\0')
+
+/* 64-bit integers for decoding 8 characters at a time */
+#if defined(_MSC_VER) && (_MSC_VER < 1400)
+typedef unsigned __int64 SWAR64;
+#else
+typedef unsigned long long SWAR64;
+#endif
+#define LANES(b) ((SWAR64)(b) * 0x0101010101010101ULL)	/* Byte b in all 8 lanes */
+
+static int getval(PARSER *pp, int flag, int low, int high);
+static int getvalN(PARSER *pp, int flag, int low, int high, int nDigits);
+static time_t local_to_utc(const TZFILE *ptzf, time_t tLocal, long *pOffset, int *pIsDst);
+static int parse_fast(PARSER *pp, int *pYear, int *pMonth, int *pDay, int *pHour, int *pMinute, int *pSecond, int *pIsGMT, long *pOffset);
+static int parse_offset(const char *p, const char *pEnd, long *pOffset);
+static int parse_tm(const char *text, struct tm *ptm, const TZFILE *ptzf, int iNominal);
+
+/* The system time zone, loaded on first use. Same rules as the C library */
+static TZFILE tzfSystem;
+static int iSystemTz = 0;		/* 0=Not loaded; 1=tzfSystem OK; -1=Use the C library */
+
+const TZFILE *system_tz() {
+  if (!iSystemTz) {
+    const char *pszTZ = getenv("TZ");
+    if (!pszTZ) pszTZ = "/etc/localtime";
+    if (*pszTZ == ':') pszTZ++;
+    if (!*pszTZ) pszTZ = "UTC";
+    iSystemTz = tzfile_open(pszTZ, &tzfSystem) ? -1 : 1;
+    if (today_debug) printf("System time zone \"%s\": %s\n", pszTZ, (iSystemTz > 0) ? "Loaded" : "Using the C library");
+  }
+  return (iSystemTz > 0) ? &tzfSystem : NULL;
+}
 
 int parsetime(text, ptm)
-char    *text;                          /* Time text                    */
+const char *text;			/* Time text                    */
+struct tm *ptm;
+/*
+ * Parse a date/time in the system time zone. Return 0 if OK.
+ */
+{
+  return parsetime_tz(text, ptm, system_tz());
+}
+
+int parsetime_tz(text, ptm, ptzf)
+const char *text;			/* Time text                    */
 struct tm *ptm;
+const TZFILE *ptzf;			/* Time zone. NULL=The C library's */
 /*
- * Create the time values and print them, return 1 on error.
+ * Create the time values, return 1 + the offset of the error, or 0 if OK.
+ * Reentrant if ptzf is not NULL. The text is not modified.
  */
+{
+  return parse_tm(text, ptm, ptzf, 0);
+}
+
+int parsetime_nominal(text, ptm)
+const char *text;			/* Time text                    */
+struct tm *ptm;
+/*
+ * Same as parsetime(), but without normalizing a local time: A time in a
+ * DST gap, like 02:30 on the spring forward day, remains 02:30. For date
+ * arithmetic with tm_normalize(). Times with a UTC offset are converted.
+ */
+{
+  return parse_tm(text, ptm, system_tz(), 1);
+}
+
+static int parse_tm(text, ptm, ptzf, iNominal)
+const char *text;			/* Time text                    */
+struct tm *ptm;
+const TZFILE *ptzf;			/* Time zone. NULL=The C library's */
+int iNominal;				/* 1 = Keep the local time as entered */
 {
   int	epoch;                  /* Which century                */
   int	year;
@@ -44,54 +124,83 @@ struct tm *ptm;
   int	second;
   int	leapyear;
   int	hasCentury = 0;
-  int	isGMT = 0;
+  int	isGMT = 0;		/* 1 = The UTC offset is specified */
+  long	utcOffset = 0;		/* UTC offset, in seconds East */
   int	iLen;
+  const char *pColon, *pSign;
+  PARSER	parser;
   time_t  t;
 
-  if (debug) printf("parsetime(\"%s\");\n", text);
+  if (today_debug) printf("parsetime(\"%s\");\n", text);
+
+  parser.p = text;			/* Setup for getval()   */
+  while (*parser.p == ' ') parser.p++;	/* Leading blanks skip  */
 
-  valptr = text;                          /* Setup for getval()   */
-  while (*valptr == ' ') valptr++;        /* Leading blanks skip  */
+  iLen = (int)strlen(parser.p);
+  parser.pEnd = parser.p + iLen;
+  if (!parse_fast(&parser, &year, &month, &day, &hour, &minute, &second, &isGMT, &utcOffset)) {
+    goto got_time;			/* The usual canonical format */
+  }
 
-  iLen = (int)strlen(valptr);
-  if (iLen && ((valptr[iLen-1] | 0x20) == 'z')) {
+  if (iLen && ((parser.p[iLen-1] | 0x20) == 'z')) {
     isGMT = 1;
-    valptr[--iLen] = '\0';
+    iLen -= 1;				/* Stop parsing before the Z */
+  } else if ((iLen > 6) && memchr(parser.p, ':', iLen - 6)	/* There's a time before */
+	     && !parse_offset(parser.p + iLen - 6, parser.p + iLen, &utcOffset)) {
+    isGMT = 1;
+    iLen -= 6;				/* Stop parsing before the +hh:mm */
+  } else if ((iLen > 5) && memchr(parser.p, ':', iLen - 5)
+	     && !parse_offset(parser.p + iLen - 5, parser.p + iLen, &utcOffset)) {
+    isGMT = 1;
+    iLen -= 5;				/* Stop parsing before the +hhmm */
+  } else if ((pColon = memchr(parser.p, ':', iLen)) != NULL
+	     && (pSign = strpbrk(pColon, "+-")) != NULL) {
+    parser.p = pSign;			/* A malformed UTC offset, like +2:00 */
+    goto bad;
   }
+  parser.pEnd = parser.p + iLen;
 
-  if (*valptr == '+') {
-    valptr++;
+  if (PEEK(&parser, 0) == '+') {
+    parser.p++;
     hasCentury = 1;
-  } else if ((iLen > 4) && (valptr[4] == '-')) {
+  } else if ((iLen > 4) && (parser.p[4] == '-')) {
     hasCentury = 1;
-  } else if ((iLen > 2) && ((valptr[2] == ':') || ((valptr[2] | 0x20) == 'h'))) {
+  } else if ((iLen > 2) && ((parser.p[2] == ':') || ((parser.p[2] | 0x20) == 'h'))) {
     time_t now;
-    struct tm *ptmNow;
+    struct tm tmNow;
     time(&now);			/* get system time */
-    ptmNow = localtime(&now);	/* get ptr to gmt time struct */
-    year = ptmNow->tm_year + 1900;
-    month = ptmNow->tm_mon + 1;
-    day = ptmNow->tm_mday;
+    if (ptzf) {
+      long offset;
+      int isDst;
+      const char *pszAbbr;
+      if (tzfile_lookup(ptzf, now, &offset, &isDst, &pszAbbr)) offset = isDst = 0;
+      utc_to_tm(now, offset, isDst, &tmNow);
+    } else {
+      tmNow = *localtime(&now);
+    }
+    year = tmNow.tm_year + 1900;
+    month = tmNow.tm_mon + 1;
+    day = tmNow.tm_mday;
     goto get_time;
   }
   if (!hasCentury) {
     epoch = 1900;                   /* Default for now      */
   } else {
-    if ((epoch = getval(-1, 00, 99)) < 0) goto bad;
+    if ((epoch = getval(&parser, -1, 00, 99)) < 0) goto bad;
     epoch *= 100;		/* Make it a real epoch */
   }
 
-  if ((year = getval(-1, 00, 99)) < 0) goto bad;
+  if ((year = getval(&parser, -1, 00, 99)) < 0) goto bad;
   if ((!hasCentury) && (year < 70)) epoch = 2000;
   year += epoch;
   leapyear = ((year%4) == 0) && (((year%400) == 0) || (year%100 != 0));
-  if (*valptr == '-') valptr++;
-  if (   valptr[0] && isdigit(valptr[0])
-      && valptr[1] && isdigit(valptr[1])
-      && valptr[2] && isdigit(valptr[2])
-      && (!valptr[3] || !isdigit(valptr[3]))) { /* There are exactly 3 digits, so it's a DDD */
+  if (PEEK(&parser, 0) == '-') parser.p++;
+  if (   isdigit(PEEK(&parser, 0))
+      && isdigit(PEEK(&parser, 1))
+      && isdigit(PEEK(&parser, 2))
+      && !isdigit(PEEK(&parser, 3))) { /* There are exactly 3 digits, so it's a DDD */
     int m, day_month2[13];
-    if ((day = getvalN(-1, 1, leapyear ? 366 : 365, 3)) < 0) goto bad;
+    if ((day = getvalN(&parser, -1, 1, leapyear ? 366 : 365, 3)) < 0) goto bad;
     for (m=0; m<=12; m++) day_month2[m] = day_month[m];
     if (leapyear) day_month2[2] = 29;
     for (month=1; month<=12; month++) {
@@ -100,64 +209,239 @@ struct tm *ptm;
     }
     day -= day_month2[month-1];
   } else { /* It's a MMDD or MM-DD */
-    if ((month = getval(-1, 1, 12)) < 0) goto bad;
-    if (*valptr == '-') valptr++;
-    if ((day = getval(-1, 1,
+    if ((month = getval(&parser, -1, 1, 12)) < 0) goto bad;
+    if (PEEK(&parser, 0) == '-') parser.p++;
+    if ((day = getval(&parser, -1, 1,
 		      (month == 2 && leapyear) ? 29 : day_month[month])) < 0)
       goto bad;
   }
 get_time:
-  if ((hour = getval(-2, 0, 23)) == -1) goto bad;
-  if ((minute = getval(-2, 0, 59)) == -1) goto bad;
-  if ((second = getval(-2, 0, 59)) == -1) goto bad;
+  if ((hour = getval(&parser, -2, 0, 23)) == -1) goto bad;
+  if ((minute = getval(&parser, -2, 0, 59)) == -1) goto bad;
+  if ((second = getval(&parser, -2, 0, 59)) == -1) goto bad;
 
-  memset(ptm, '\0', sizeof(struct tm));
-  ptm->tm_year = year - 1900;
-  ptm->tm_mon  = month - 1;
-  ptm->tm_mday = day;
-  ptm->tm_hour = hour;
-  ptm->tm_min = minute;
-  ptm->tm_sec = second;
-  ptm->tm_isdst = -1; /* Let mktime find out if DST applies or not */
-  if (debug) printf("input tm = {%d, %d, %d, %d, %d, %d, %d};\n", ptm->tm_year, ptm->tm_mon, ptm->tm_mday, ptm->tm_hour, ptm->tm_min, ptm->tm_sec, ptm->tm_isdst);
+got_time:
+  if (today_debug) printf("input = %04d-%02d-%02d %02d:%02d:%02d%s%+lds;\n", year, month, day, hour, minute, second, isGMT ? " UTC" : "", utcOffset);
 
   /* To fill the rest of the structure tm, convert it to a Unix time, and back */
-  if (hour < 0) ptm->tm_hour = 12; /* If some of the entries are missing, enter a reasonable default */
-  if (minute < 0) ptm->tm_min = 0;
-  if (second < 0) ptm->tm_sec = 0;
-  t = mktime(ptm);
-  if (isGMT) {
-    time_t t2 = mktime(gmtime(&t));
-    time_t dt = t-t2;
-    if (debug) printf("Correcting for GMT offset: %s%lds\n", (((long)dt > 0) ? "+" : ""), (long)dt);
-    t += dt; /* Convert t to a local GMT time */
-  }
-  *ptm = *localtime(&t);
-  if (ptm->tm_isdst && isGMT) { /* GMT has no DST, so we must correct for the local time DST */
-    if (debug) printf("Correcting for DST offset: +3600s\n");
-    t += 3600;
+  t = (time_t)days_from_civil(year, month, day) * 86400
+    + (hour < 0 ? 12 : hour) * 3600L /* If some of the entries are missing, enter a reasonable default */
+    + (minute < 0 ? 0 : minute) * 60L
+    + (second < 0 ? 0 : second);
+  if (iNominal && !isGMT) {
+    utc_to_tm(t, 0, -1, ptm);		/* The local time fields as entered */
+  } else if (ptzf) {
+    long offset = 0;
+    int isDst = 0;
+    const char *pszAbbr;
+    if (isGMT) {
+      t -= utcOffset;
+      if (tzfile_lookup(ptzf, t, &offset, &isDst, &pszAbbr)) offset = isDst = 0;
+    } else {
+      t = local_to_utc(ptzf, t, &offset, &isDst);
+    }
+    if (today_debug) printf("UTC offset: %+lds\n", offset);
+    utc_to_tm(t, offset, isDst, ptm);
+  } else {
+    struct tm stm;
+    memset(&stm, '\0', sizeof(struct tm));
+    utc_to_tm(t, 0, -1, &stm); /* Let mktime find out if DST applies or not */
+    t = mktime(&stm);
+    if (isGMT) {
+      time_t t2 = mktime(gmtime(&t));
+      time_t dt = t-t2;
+      if (today_debug) printf("Correcting for GMT offset: %s%lds\n", (((long)dt > 0) ? "+" : ""), (long)dt);
+      t += dt; /* Convert t to a local GMT time */
+      t -= utcOffset;
+    }
     *ptm = *localtime(&t);
+    if (ptm->tm_isdst && isGMT) { /* GMT has no DST, so we must correct for the local time DST */
+      if (today_debug) printf("Correcting for DST offset: +3600s\n");
+      t += 3600;
+      *ptm = *localtime(&t);
+    }
   }
   if (hour < 0) ptm->tm_hour = hour; /* Flag again the missing entries */
   if (minute < 0) ptm->tm_min = minute;
   if (second < 0) ptm->tm_sec = second;
-  if (debug) printf("return tm = {%d, %d, %d, %d, %d, %d, %d};\n", ptm->tm_year, ptm->tm_mon, ptm->tm_mday, ptm->tm_hour, ptm->tm_min, ptm->tm_sec, ptm->tm_isdst);
+  if (today_debug) printf("return tm = {%d, %d, %d, %d, %d, %d, %d};\n", ptm->tm_year, ptm->tm_mon, ptm->tm_mday, ptm->tm_hour, ptm->tm_min, ptm->tm_sec, ptm->tm_isdst);
 
   return(0);				/* Normal exit		*/
 
  bad:
-  return ((int)(valptr - text) + 1);
+  return ((int)(parser.p - text) + 1);
+}
+
+/* Parse a whole RFC 3339 UTC offset +hh:mm, or ISO 8601 +hhmm. Return 0 if OK */
+static int parse_offset(p, pEnd, pOffset)
+const char *p;
+const char *pEnd;
+long *pOffset;
+{
+  int sign, h, m;
+
+  if ((p >= pEnd) || ((*p != '+') && (*p != '-'))) return 1;
+  sign = (*p++ == '-') ? -1 : 1;
+  if ((pEnd - p != 4) && ((pEnd - p != 5) || (p[2] != ':'))) return 1;
+  if (!isdigit((unsigned char)p[0]) || !isdigit((unsigned char)p[1])) return 1;
+  h = (p[0] - '0') * 10 + (p[1] - '0');
+  p += (pEnd - p == 5) ? 3 : 2;
+  if (!isdigit((unsigned char)p[0]) || !isdigit((unsigned char)p[1])) return 1;
+  m = (p[0] - '0') * 10 + (p[1] - '0');
+  if ((h > 23) || (m > 59)) return 1;
+  *pOffset = sign * (h * 3600L + m * 60L);
+  return 0;
+}
+
+/* Read 8 characters as a little-endian integer, whatever the CPU byte order.
+   Compilers turn this into a single load on little-endian CPUs */
+static SWAR64 load8(p)
+const char *p;
+{
+  SWAR64 v = 0;
+  int i;
+
+  for (i = 7; i >= 0; i--) v = (v << 8) | (unsigned char)p[i];
+  return v;
+}
+
+/* Check that the lanes in mask m of v all contain a digit, and convert them
+   to 2-digit numbers: Lane i of the result = 10 * digit i + digit i+1.
+   Return -1 if one of them is not a digit */
+static SWAR64 swar_pairs(v, m)
+SWAR64 v;
+SWAR64 m;
+{
+  SWAR64 d = v & m;
+
+  /* A digit is 0x30 to 0x39, so its high nibble is 3 before and after adding 6 */
+  if (   ((d & (m & LANES(0xF0))) != (m & LANES(0x30)))
+      || (((d + (m & LANES(0x06))) & (m & LANES(0xF0))) != (m & LANES(0x30)))) return (SWAR64)-1;
+  d -= m & LANES(0x30);			/* Digit values in all lanes, 0 elsewhere */
+  return d * 10 + (d >> 8);		/* No carry across lanes, as they're all <= 99 */
 }
 
-static int getvalN(flag, low, high, n)
+#define LANE(v, i) ((int)(((v) >> (8 * (i))) & 0xFF))
+
+/*
+ * Fast path for the canonical YYYY-MM-DDTHH:MM:SS format, as in logs,
+ * optionally followed by fractional seconds, and a Z or a +hh:mm offset.
+ * The first 16 characters are validated and decoded 8 at a time.
+ * Return 0 if OK, or 1 if the text has another format.
+ */
+static int parse_fast(pp, pYear, pMonth, pDay, pHour, pMinute, pSecond, pIsGMT, pOffset)
+PARSER *pp;
+int *pYear, *pMonth, *pDay, *pHour, *pMinute, *pSecond;
+int *pIsGMT;
+long *pOffset;
+{
+  const char *p = pp->p;
+  SWAR64 a, b;
+  int c, year, month, day, nDays;
+
+  if ((pp->pEnd - p) < 19) return 1;
+  a = load8(p);				/* YYYY-MM- */
+  b = load8(p + 8);			/* DDTHH:MM */
+  c = p[10] | 0x20;			/* T, t, or space */
+  if (   ((a & 0xFF0000FF00000000ULL) != 0x2D00002D00000000ULL)	/* The - in lanes 4 and 7 */
+      || ((b & 0x0000FF0000000000ULL) != 0x00003A0000000000ULL)	/* The : in lane 5 */
+      || ((c != 't') && (c != ' ')) || (p[16] != ':')
+      || !isdigit((unsigned char)p[17]) || !isdigit((unsigned char)p[18])) return 1;
+  a = swar_pairs(a, 0x00FFFF00FFFFFFFFULL);
+  b = swar_pairs(b, 0xFFFF00FFFF00FFFFULL);
+  if ((a == (SWAR64)-1) || (b == (SWAR64)-1)) return 1;
+  year = LANE(a, 0) * 100 + LANE(a, 2);
+  month = LANE(a, 5);
+  day = LANE(b, 0);
+  if ((month < 1) || (month > 12)) return 1;
+  nDays = day_month[month];
+  if ((month == 2) && ((year%4) == 0) && (((year%400) == 0) || (year%100 != 0))) nDays = 29;
+  if ((day < 1) || (day > nDays)) return 1;
+  *pHour = LANE(b, 3);
+  *pMinute = LANE(b, 6);
+  *pSecond = (p[17] - '0') * 10 + (p[18] - '0');
+  if ((*pHour > 23) || (*pMinute > 59) || (*pSecond > 59)) return 1;
+
+  p += 19;
+  if ((p < pp->pEnd) && ((*p == '.') || (*p == ','))) {	/* Fractional seconds. Ignored */
+    if (!(++p < pp->pEnd) || !isdigit((unsigned char)*p)) return 1;
+    while ((p < pp->pEnd) && isdigit((unsigned char)*p)) p++;
+  }
+  *pIsGMT = 0;
+  *pOffset = 0;
+  if (p < pp->pEnd) {
+    if ((*p | 0x20) == 'z') {
+      if (++p != pp->pEnd) return 1;
+    } else if (parse_offset(p, pp->pEnd, pOffset)) {
+      return 1;
+    }
+    *pIsGMT = 1;
+  }
+  *pYear = year;
+  *pMonth = month;
+  *pDay = day;
+  pp->p = pp->pEnd;
+  return 0;
+}
+
+time_t tm_normalize(ptm)
+struct tm *ptm;
+/*
+ * Normalize the date/time fields of a local time in the system time zone,
+ * like mktime() does, and compute the day of the week and of the year, and
+ * the DST flag. The missing time fields, flagged as < 0 by parsetime(),
+ * count as 12:00:00, and remain flagged as missing.
+ * Return the corresponding UTC time.
+ */
+{
+  return tm_normalize_tz(ptm, system_tz());
+}
+
+time_t tm_normalize_tz(ptm, ptzf)
+struct tm *ptm;
+const TZFILE *ptzf;			/* Time zone. NULL=The C library's */
+/*
+ * Same as tm_normalize(), in a given time zone. Reentrant if ptzf is not NULL.
+ */
+{
+  int hour = ptm->tm_hour;
+  int minute = ptm->tm_min;
+  int second = ptm->tm_sec;
+  long months = ptm->tm_year * 12L + ptm->tm_mon;
+  long years = (months >= 0 ? months : months - 11) / 12;	/* Round towards -infinity */
+  time_t t;
+
+  t = ((time_t)days_from_civil((int)years + 1900, (int)(months - years * 12) + 1, 1) + ptm->tm_mday - 1) * 86400
+    + (hour < 0 ? 12 : hour) * 3600L /* If some of the entries are missing, enter a reasonable default */
+    + (minute < 0 ? 0 : minute) * 60L
+    + (second < 0 ? 0 : second);
+  if (ptzf) {
+    long offset;
+    int isDst;
+    t = local_to_utc(ptzf, t, &offset, &isDst);
+    utc_to_tm(t, offset, isDst, ptm);
+  } else {
+    struct tm stm;
+    utc_to_tm(t, 0, -1, &stm); /* Let mktime find out if DST applies or not */
+    t = mktime(&stm);
+    *ptm = *localtime(&t);
+  }
+  if (hour < 0) ptm->tm_hour = hour; /* Flag again the missing entries */
+  if (minute < 0) ptm->tm_min = minute;
+  if (second < 0) ptm->tm_sec = second;
+  return t;
+}
+
+static int getvalN(pp, flag, low, high, n)
+PARSER  *pp;
 int     flag;
 int     low;
 int     high;
 int     n;
 /*
- * Global valptr points to a N-digit positive decimal integer.
+ * pp->p points to a N-digit positive decimal integer.
  * Skip over leading non-numbers and return the value.
- * Return flag if text[0] == '\0'. Return -1 if the text is bad,
+ * Return flag if at the end of the text. Return -1 if the text is bad,
  * or if the value is out of the low:high range.
  */
 {
@@ -165,21 +449,124 @@ int     n;
   register int i;
   register int temp;
 
-  while (*valptr && (*valptr < '0' || *valptr > '9')) valptr++;
-  if (*valptr == '\0') return(flag);        /* Default?             */
+  while ((pp->p < pp->pEnd) && (*pp->p < '0' || *pp->p > '9')) pp->p++;
+  if (pp->p == pp->pEnd) return(flag);        /* Default?             */
   /* The above allows for 78.04.22 format */
   for (value = i = 0; i < n; i++) {
-    temp = *valptr++ - '0';
+    temp = PEEK(pp, 0) - '0';
+    pp->p++;
     if (temp < 0 || temp > 9) return(-1);
     value = (value*10) + temp;
   }
   return((value >= low && value <= high) ? value : -1);
 }
 
-static int getval(flag, low, high)
+static int getval(pp, flag, low, high)
+PARSER  *pp;
 int     flag;
 int     low;
 int     high;
 {
-  return getvalN(flag, low, high, 2);
+  return getvalN(pp, flag, low, high, 2);
+}
+
+/* Convert a local time, counted like a UTC time, to a UTC time.
+   Also get the UTC offset and DST flag at that time */
+static time_t local_to_utc(ptzf, tLocal, pOffset, pIsDst)
+const TZFILE *ptzf;
+time_t tLocal;
+long *pOffset;
+int *pIsDst;
+{
+  long offBefore, offAfter, off1, off2, offset;
+  int isDst;
+  const char *pszAbbr;
+  time_t t;
+
+  /* The offsets in effect a day before and a day after. They differ if there's a transition */
+  *pOffset = *pIsDst = 0;
+  if (tzfile_lookup(ptzf, tLocal - 86400, &offBefore, &isDst, &pszAbbr)) return tLocal;
+  if (tzfile_lookup(ptzf, tLocal + 86400, &offAfter, pIsDst, &pszAbbr)) return tLocal;
+  if (offBefore == offAfter) {		/* The general case */
+    *pOffset = offBefore;
+    return tLocal - offBefore;
+  }
+  off1 = (offBefore < offAfter) ? offBefore : offAfter;
+  off2 = (offBefore < offAfter) ? offAfter : offBefore;
+  /* If both are valid, that local time occurs twice: Use the later one, like mktime() */
+  if (!tzfile_lookup(ptzf, tLocal - off1, &offset, &isDst, &pszAbbr) && (offset == off1)) {
+    t = tLocal - off1;
+  } else if (!tzfile_lookup(ptzf, tLocal - off2, &offset, &isDst, &pszAbbr) && (offset == off2)) {
+    t = tLocal - off2;
+  } else {	/* That local time was skipped: Use the offset before the transition, like mktime() */
+    t = tLocal - offBefore;
+  }
+  tzfile_lookup(ptzf, t, pOffset, pIsDst, &pszAbbr);
+  return t;
+}
+
+/* Fill a struct tm with the local time at UTC time t, given the UTC offset */
+void utc_to_tm(t, offset, isDst, ptm)
+time_t t;
+long offset;
+int isDst;
+struct tm *ptm;
+{
+  long days, secs;
+  int y, m, d;
+
+  memset(ptm, '\0', sizeof(struct tm));
+  t += offset;
+  days = (long)(t / 86400);
+  secs = (long)(t % 86400);
+  if (secs < 0) {			/* Round towards -infinity */
+    days -= 1;
+    secs += 86400;
+  }
+  civil_from_days(days, &y, &m, &d);
+  ptm->tm_year = y - 1900;
+  ptm->tm_mon = m - 1;
+  ptm->tm_mday = d;
+  ptm->tm_hour = (int)(secs / 3600);
+  ptm->tm_min = (int)((secs / 60) % 60);
+  ptm->tm_sec = (int)(secs % 60);
+  ptm->tm_wday = (int)(((days % 7) + 11) % 7);	/* 1970-01-01 was a Thursday */
+  ptm->tm_yday = (int)(days - days_from_civil(y, 1, 1));
+  ptm->tm_isdst = isDst;
+}
+
+/* Number of days from 1970-01-01 to a proleptic Gregorian date. (H. Hinnant's algorithm) */
+long days_from_civil(y, m, d)
+int y;
+int m;
+int d;
+{
+  long era, yoe, doy, doe;
+
+  y -= (m <= 2);
+  era = (y >= 0 ? (long)y : (long)y - 399) / 400;
+  yoe = (long)y - era * 400;				/* [0, 399] */
+  doy = (153L * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;	/* [0, 365] */
+  doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;		/* [0, 146096] */
+  return era * 146097L + doe - 719468L;
+}
+
+/* Proleptic Gregorian date of a number of days from 1970-01-01. (H. Hinnant's algorithm) */
+void civil_from_days(z, py, pm, pd)
+long z;
+int *py;
+int *pm;
+int *pd;
+{
+  long era, doe, yoe, doy, mp;
+
+  z += 719468L;
+  era = (z >= 0 ? z : z - 146096L) / 146097L;
+  doe = z - era * 146097L;				/* [0, 146096] */
+  yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;	/* [0, 399] */
+  doy = doe - (365 * yoe + yoe / 4 - yoe / 100);	/* [0, 365] */
+  mp = (5 * doy + 2) / 153;				/* [0, 11] */
+  *pd = (int)(doy - (153 * mp + 2) / 5 + 1);
+  *pm = (int)(mp < 10 ? mp + 3 : mp - 9);
+  *py = (int)(yoe + era * 400 + (*pm <= 2));
 }
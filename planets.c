@@ -0,0 +1,186 @@
+/*
+ * planets.c
+ *
+ * Positions, rise, transit, and set times of the planets Mercury to Saturn.
+ *
+ * The heliocentric positions are computed from the mean Keplerian elements
+ * and their secular rates, in E. M. Standish "Keplerian Elements for
+ * Approximate Positions of the Major Planets" (JPL), table 1, valid from 1800
+ * to 2050. The errors are below 1 arc minute for the inner planets, and a few
+ * arc minutes for Jupiter and Saturn. That's less than a minute of time on the
+ * rise and set times, well within the uncertainty due to the refraction.
+ *
+ * All planets, and the Earth, are evaluated together in one sweep of the
+ * elements table. The results are cached per date, so that computing the
+ * rise and set times for consecutive days, which needs the positions at the
+ * beginning and end of each day, costs just one sweep per day.
+ *
+ * The rise and set times are computed like those of the Sun in sun.c:
+ * rise_set_n() gives the sidereal times of rise and set at the start and
+ * end of the day, which are then interpolated.
+ *
+ * Authors:
+ *   JFL jf.larvoire@free.fr
+ *
+ * History:
+ *   2026-10-19 JFL Created this module.
+ *                  Made the cache thread-private, for today -x.
+ *                  planets_day() fails for dates outside of the range where
+ *                  the table 1 elements are valid.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#include "today.h"
+
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+
+#define J2000		2451545.0	/* JDE of 2000-01-01 12:00 TT */
+#define OBLIQUITY2000	23.43928	/* Obliquity of the ecliptic at J2000 */
+#define H0_PLANET	(-0.5667)	/* Planet altitude at rise & set, due to the refraction */
+#define SOLAR_PER_SIDEREAL 0.9972695663	/* Solar hours per sidereal hour */
+#define EARTH		NPLANETS	/* Index of the Earth-Moon barycenter in the tables */
+#define NCACHE		4		/* Number of dates cached */
+
+const char * const today_planet_names[NPLANETS] = {"Mercury", "Venus", "Mars", "Jupiter", "Saturn"};
+
+/* Keplerian elements at J2000, and their rates per Julian century */
+static const double a0[NPLANETS+1] = { 0.38709927,  0.72333566,  1.52371034,  5.20288700,  9.53667594,  1.00000261};
+static const double a1[NPLANETS+1] = { 0.00000037,  0.00000390,  0.00001847, -0.00011607, -0.00125060,  0.00000562};
+static const double e0[NPLANETS+1] = { 0.20563593,  0.00677672,  0.09339410,  0.04838624,  0.05386179,  0.01671123};
+static const double e1[NPLANETS+1] = { 0.00001906, -0.00004107,  0.00007882, -0.00013253, -0.00050991, -0.00004392};
+static const double i0[NPLANETS+1] = { 7.00497902,  3.39467605,  1.84969142,  1.30439695,  2.48599187, -0.00001531};
+static const double i1[NPLANETS+1] = {-0.00594749, -0.00078890, -0.00813131, -0.00183714,  0.00193609, -0.01294668};
+static const double L0[NPLANETS+1] = {252.25032350, 181.97909950, -4.55343205, 34.39644051, 49.95424423, 100.46457166};
+static const double L1[NPLANETS+1] = {149472.67411175, 58517.81538729, 19140.30268499, 3034.74612775, 1222.49362201, 35999.37244981};
+static const double w0[NPLANETS+1] = {77.45779628, 131.60246718, -23.94362959, 14.72847983, 92.59887831, 102.93768193};
+static const double w1[NPLANETS+1] = { 0.16047689,  0.00268329,  0.44441088,  0.21252668, -0.41897216,  0.32327364};
+static const double N0[NPLANETS+1] = {48.33076593, 76.67984255, 49.55953891, 100.47390909, 113.66242448, 0.0};
+static const double N1[NPLANETS+1] = {-0.12534081, -0.27769418, -0.29257343,  0.20469106, -0.28867794, 0.0};
+
+static PLANETPOS cache[NCACHE];
+static double cacheJd[NCACHE];
+static int nCached = 0;
+static int iNextCache = 0;
+#ifdef _OPENMP
+#pragma omp threadprivate(cache, cacheJd, nCached, iNextCache)
+#endif
+
+/* Heliocentric ecliptic J2000 coordinates of all bodies in the table, in AU */
+static void sweep(double T, double x[NPLANETS+1], double y[NPLANETS+1], double z[NPLANETS+1]) {
+  int i;
+  for (i = 0; i <= NPLANETS; i++) {
+    double a = a0[i] + a1[i] * T;
+    double e = e0[i] + e1[i] * T;
+    double I = dtor(i0[i] + i1[i] * T);
+    double L = L0[i] + L1[i] * T;
+    double w = w0[i] + w1[i] * T;	/* Longitude of the perihelion */
+    double N = N0[i] + N1[i] * T;	/* Longitude of the ascending node */
+    double M = dtor(fmod(L - w, 360.0));	/* Mean anomaly */
+    double o = dtor(w - N);		/* Argument of the perihelion */
+    double E = M + e * sin(M);		/* Eccentric anomaly */
+    double xp, yp, cosO, sinO, cosN, sinN, cosI;
+    int j;
+    for (j = 0; j < 10; j++) {		/* Solve Kepler's equation */
+      double dE = (M - E + e * sin(E)) / (1 - e * cos(E));
+      E += dE;
+      if (fabs(dE) < 1e-12) break;
+    }
+    xp = a * (cos(E) - e);
+    yp = a * sqrt(1 - e * e) * sin(E);
+    cosO = cos(o); sinO = sin(o);
+    cosN = cos(dtor(N)); sinN = sin(dtor(N));
+    cosI = cos(I);
+    x[i] = (cosO * cosN - sinO * sinN * cosI) * xp + (-sinO * cosN - cosO * sinN * cosI) * yp;
+    y[i] = (cosO * sinN + sinO * cosN * cosI) * xp + (-sinO * sinN + cosO * cosN * cosI) * yp;
+    z[i] = sinO * sin(I) * xp + cosO * sin(I) * yp;
+  }
+}
+
+/* Geocentric positions of all planets at a given JD (UT). The result is cached */
+PLANETPOS *planet_positions(double jd) {
+  double x[NPLANETS+1], y[NPLANETS+1], z[NPLANETS+1];
+  double T, eps, lambdaSun, prec;
+  PLANETPOS *pp;
+  int i;
+
+  for (i = 0; i < nCached; i++) if (cacheJd[i] == jd) return cache + i;
+  pp = cache + iNextCache;
+  cacheJd[iNextCache] = jd;
+  iNextCache = (iNextCache + 1) % NCACHE;
+  if (nCached < NCACHE) nCached += 1;
+
+  T = (jd + delta_t(jd) / 86400.0 - J2000) / 36525.0;
+  sweep(T, x, y, z);
+  prec = 1.396971 * T;			/* General precession in longitude since J2000 */
+  eps = dtor(OBLIQUITY2000 - 0.0130042 * T);
+  lambdaSun = atan2(-y[EARTH], -x[EARTH]) * 180.0 / PI;
+  for (i = 0; i < NPLANETS; i++) {
+    double gx = x[i] - x[EARTH];
+    double gy = y[i] - y[EARTH];
+    double gz = z[i] - z[EARTH];
+    double r = sqrt(gx * gx + gy * gy + gz * gz);
+    double l = atan2(gy, gx) * 180.0 / PI;
+    double b = asin(gz / r);
+    double dl = fmod(l - lambdaSun + 540.0, 360.0) - 180.0;
+    double cosElong = -(gx * x[EARTH] + gy * y[EARTH] + gz * z[EARTH])
+		      / (r * sqrt(x[EARTH] * x[EARTH] + y[EARTH] * y[EARTH] + z[EARTH] * z[EARTH]));
+    double ra;
+    l = dtor(l + prec);
+    ra = atan2(sin(l) * cos(eps) - tan(b) * sin(eps), cos(l)) * 12.0 / PI;
+    pp->ra[i] = (ra < 0.0) ? ra + 24.0 : ra;
+    pp->dec[i] = asin(sin(b) * cos(eps) + cos(b) * sin(eps) * sin(l)) * 180.0 / PI;
+    pp->dist[i] = r;
+    pp->elong[i] = acos(cosElong) * 180.0 / PI;
+    if (dl < 0.0) pp->elong[i] = -pp->elong[i];
+  }
+  return pp;
+}
+
+/* Interpolate a sidereal time between the start and the end of the day */
+static double lst_interp(double st1, double st2, double m1) {
+  double d = fmod(st2 - st1 + 36.0, 24.0) - 12.0;	/* In [-12, 12) */
+  double ratio = fmod(st1 - m1 + 24.0, 24.0) / 24.07;	/* How far into the day */
+  double st = fmod(st1 + ratio * d + 24.0, 24.0);
+  return fmod(st - m1 + 24.0, 24.0) * SOLAR_PER_SIDEREAL;	/* Local time */
+}
+
+/* Rise, transit, and set local times of all planets on a given local date.
+   Returns 0 if OK, or 1 if the date is outside of the valid range */
+int planets_day(struct tm *pt, PLANETDAY pd[NPLANETS]) {
+  struct tm stm = *pt;
+  double jd, m1;
+  double alpha[2*NPLANETS], delta[2*NPLANETS];
+  double lstr[2*NPLANETS], lsts[2*NPLANETS], ar[2*NPLANETS];
+  int state[2*NPLANETS];
+  PLANETPOS p1, *pp2;
+  int i;
+
+  if (   (pt->tm_year + 1900 < PLANETS_MIN_YEAR)
+      || (pt->tm_year + 1900 > PLANETS_MAX_YEAR)) return 1;
+  stm.tm_hour = stm.tm_min = stm.tm_sec = 0;
+  jd = tm_to_jd(&stm);
+  p1 = *planet_positions(jd);	/* Copy it, as the next call may evict it from the cache */
+  pp2 = planet_positions(jd + 1.0);
+  for (i = 0; i < NPLANETS; i++) {
+    alpha[i] = p1.ra[i];
+    delta[i] = p1.dec[i];
+    alpha[NPLANETS+i] = pp2->ra[i];
+    delta[NPLANETS+i] = pp2->dec[i];
+  }
+  rise_set_n(2*NPLANETS, alpha, delta, H0_PLANET, lstr, lsts, ar, state);
+  m1 = midnight_lst(pt);
+  for (i = 0; i < NPLANETS; i++) {
+    int j = NPLANETS + i;
+    pd[i].state = (state[i] == state[j]) ? state[i] : RS_RISES;
+    pd[i].rise = lst_interp(lstr[i], lstr[j], m1);
+    pd[i].transit = lst_interp(alpha[i], alpha[j], m1);
+    pd[i].set = lst_interp(lsts[i], lsts[j], m1);
+    pd[i].elong = p1.elong[i];
+  }
+  return 0;
+}
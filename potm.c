@@ -19,47 +19,143 @@
 **   2019-11-01 JFL Added support for dates in the ISO 8601 YYYY-DDD format.
 **   2019-11-17 JFL Added option /? for Windows.
 **   2019-11-18 JFL Use the new versions.h instead of include/debugm.h.
+**   2026-10-18 JFL Added option -p to use the more precise ELP-2000/82 engine.
+**		    Added option --eclipses to list the eclipses in a period.
+**   2026-10-19 JFL Accept ISO 8601 date ranges and repeats, displaying every date.
+**		    Added option --format, for JSON Lines or CSV output.
+**		    Rename main() and usage() when built into todaybox.
 */
 
-#define VERSION "2019-11-18"
+#define VERSION "2026-10-19"
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
 
 #include "today.h"
 #include "moontx.h"
 #include "versions.h"
 
-static	char	potm[64];
+#ifdef MULTICALL		/* Linked into the todaybox multi-call program */
+#define main potm_main
+#define usage potm_usage
+#endif
 
-int debug = 0;
+static	char	szPotm[64];
 
 #define streq(s1, s2) (!strcmp(s1, s2))
 
+/* Fields of the --format records */
+static const char * const fields[] = {
+  "date", "time", "illumination", "waxing", "phase", NULL
+};
+static const char * const eclipse_fields[] = {
+  "time", "body", "type", "gamma", "magnitude", NULL
+};
+
 void usage() {
   printf("\
 potm - Print out the phase of the moon as text, and as Ascii Art\n\
 \n\
 Usage: potm [OPTIONS] [DATE]\n\
+       potm [OPTIONS] --eclipses FROM TO\n\
 \n\
 Options:\n\
   -?|-h|--help  Display this help screen\n\
+  -e|--eclipses FROM TO  List the solar & lunar eclipses in that period\n\
+  --format=FORMAT  Output one record per date or eclipse. FORMAT = jsonl or csv\n\
   -i|--inverse  It's an inverse video terminal (black text on white background)\n\
+  -p|--precise  Use the ELP-2000/82 lunar theory. Slower, but more accurate\n\
   -V|--version  Display the program version\n\
 \n\
 Date: YYYY-MM-DD or YYYY-DDD, with - optional, default: today\n\
+      Or a range, like 2025-01-01/2025-12-31, R/2025-01-01/P1W, or 2025-W10\n\
+From, To: YYYY, or a date as above. Both bounds are included. Times are UT.\n\
 \n\
 ");
 }
 
+/* Parse an eclipse search bound: A year, or a date. Return 0 if OK */
+int parse_bound(char *arg, int isEnd, double *pjd) {
+  struct tm stm;
+  int i;
+
+  for (i=0; arg[i] && isdigit(arg[i]); i++) ;
+  if ((!arg[i]) && (i > 0) && (i <= 4)) { /* It's a year */
+    *pjd = jd_jan0(atoi(arg) + isEnd) + 1.0;
+    return 0;
+  }
+  if (parsetime(arg, &stm)) return 1;
+  *pjd = tm_to_jd(&stm);
+  if (isEnd && (stm.tm_hour < 0)) *pjd += 1.0; /* Include that whole day */
+  return 0;
+}
+
+/* List the eclipses between two dates */
+int list_eclipses(char *pszFrom, char *pszTo, int iFormat) {
+  static char *kinds[] = {"", "Penumbral", "Partial", "Annular", "Total"};
+  RECORD rec;
+  double jdFrom, jdTo;
+  ECLIPSE *pList;
+  int i, n;
+
+  if (parse_bound(pszFrom, 0, &jdFrom)) {
+    fprintf(stderr, "Error: Invalid date: \"%s\"\n", pszFrom);
+    return 1;
+  }
+  if (parse_bound(pszTo, 1, &jdTo)) {
+    fprintf(stderr, "Error: Invalid date: \"%s\"\n", pszTo);
+    return 1;
+  }
+  n = eclipses(jdFrom, jdTo, &pList);
+  if (n < 0) {
+    fprintf(stderr, "Error: Out of memory\n");
+    return 1;
+  }
+  if (iFormat) {
+    record_init(&rec, iFormat, eclipse_fields);
+    fwrite(rec.szBuf, 1, record_header(&rec), stdout);
+  } else {
+    printf("Date       Time UT  Eclipse Type       Gamma Magnitude\n");
+  }
+  for (i=0; i<n; i++) {
+    ECLIPSE *pe = pList + i;
+    struct tm stm;
+    jd_to_tm(pe->jd, &stm);
+    if (iFormat) {
+      record_begin(&rec);
+      record_time(&rec, stm.tm_year+1900, stm.tm_mon+1, stm.tm_mday,
+		  (stm.tm_hour * 60L + stm.tm_min) * 60 + stm.tm_sec, 0);
+      record_str(&rec, (pe->type & ECL_SOLAR) ? "solar" : "lunar");
+      record_str(&rec, kinds[pe->type & 0x0F]);
+      record_num(&rec, pe->gamma, 4);
+      record_num(&rec, pe->mag, 4);
+      fwrite(rec.szBuf, 1, record_end(&rec), stdout);
+      continue;
+    }
+    printf("%04d-%02d-%02d %02d:%02d:%02d %-7s %-9s %7.4f %9.4f\n",
+	   stm.tm_year+1900, stm.tm_mon+1, stm.tm_mday, stm.tm_hour, stm.tm_min, stm.tm_sec,
+	   (pe->type & ECL_SOLAR) ? "Solar" : "Lunar", kinds[pe->type & 0x0F],
+	   pe->gamma, pe->mag);
+  }
+  free(pList);
+  return 0;
+}
+
 int main(int argc, char *argv[]) {
   int i;
   struct tm stm;
   int iErr;
   struct tm *ptm = NULL;
+  DATERANGE dr;
+  int iRange = 0;
   char *pBuf;
   int inverse = 0;
+  char *pszFrom = NULL;
+  char *pszTo = NULL;
+  int iFormat = FMT_TEXT;
+  RECORD rec;
 
   for (i=1; i<argc; i++) {
     char *arg = argv[i];
@@ -77,7 +173,24 @@ int main(int argc, char *argv[]) {
       }
       if (   streq(opt, "d")	/* -d = Debug mode */
 	  || streq(opt, "-debug")) {
-	debug = 1;
+	today_debug = 1;
+	continue;
+      }
+      if (   (   streq(opt, "e")	/* -e = List eclipses */
+	      || streq(opt, "-eclipses"))
+	  && ((i+2)<argc)) {
+	pszFrom = argv[++i];
+	pszTo = argv[++i];
+	continue;
+      }
+      if (   (streq(opt, "-format") && ((i+1)<argc)) /* --format = Output format */
+	  || !strncmp(opt, "-format=", 8)) {
+	char *pszFormat = opt[7] ? opt+8 : argv[++i];
+	iFormat = record_format(pszFormat);
+	if (iFormat < 0) {
+	  fprintf(stderr, "Error: Unsupported format: %s\n", pszFormat);
+	  return 1;
+	}
 	continue;
       }
       if (   streq(opt, "i")	/* -i = Inverse video mode */
@@ -85,6 +198,11 @@ int main(int argc, char *argv[]) {
 	inverse = 1;
 	continue;
       }
+      if (   streq(opt, "p")	/* -p = Precise mode */
+	  || streq(opt, "-precise")) {
+	today_potm = potm_elp;
+	continue;
+      }
       if (   streq(opt, "V")     /* -V: Display the version */
 	  || streq(opt, "-version")) {
 	printf(VERSION " " EXE_OS_NAME "\n");
@@ -94,28 +212,70 @@ int main(int argc, char *argv[]) {
       return 1;
     }
     /* Else this is an argument */
-    if (!ptm) {
-      iErr = parsetime(arg, &stm);
+    if (!iRange) {
+      iErr = daterange_parse(arg, &dr);
       if (iErr) {
 	fprintf(stderr, "Error at offset %d parsing date/time \"%s\".\n", iErr-1, arg);
 	return 1;
       };
-      ptm = &stm;
+      iRange = 1;
       continue;
     }
     fprintf(stderr, "Unexpected argument: %s\n", arg);
     return 1;
   }
 
-  /* Display the phase of the moon as text */
-  moontxt(potm, ptm);
-  printf("Phase-of-the-Moon:%s\n", potm+11);
+  if (pszFrom) return list_eclipses(pszFrom, pszTo, iFormat);
+
+  if (iFormat) {
+    record_init(&rec, iFormat, fields);
+    fwrite(rec.szBuf, 1, record_header(&rec), stdout);
+  }
+
+  do {
+    if (iRange) {
+      if (!daterange_next(&dr, &stm)) break;
+      ptm = &stm;
+    }
+
+    if (iFormat) {		/* Machine-readable output */
+      double phase;
+      int waxing;
+      if (!ptm) {
+	utc_to_tm(time(NULL), 0, 0, &stm);	/* Now, in GMT */
+	ptm = &stm;
+      }
+      phase = moon_illum(ptm, &waxing);
+      record_begin(&rec);
+      record_date(&rec, ptm->tm_year+1900, ptm->tm_mon+1, ptm->tm_mday);
+      if (ptm->tm_hour < 0) {	/* No time specified */
+	record_null(&rec);
+      } else {
+	record_time(&rec, ptm->tm_year+1900, ptm->tm_mon+1, ptm->tm_mday,
+		    ptm->tm_hour * 3600L + ((ptm->tm_min > 0) ? ptm->tm_min * 60L : 0)
+		    + ((ptm->tm_sec > 0) ? ptm->tm_sec : 0), 0);
+      }
+      record_num(&rec, phase / 100, 4);
+      record_bool(&rec, waxing);
+      record_str(&rec, moon_phase_name(phase, waxing));
+      fwrite(rec.szBuf, 1, record_end(&rec), stdout);
+      continue;
+    }
+
+    if (iRange) {
+      if (dr.nCount != 1) printf("%04d-%02d-%02d ", ptm->tm_year+1900, ptm->tm_mon+1, ptm->tm_mday);
+    }
+
+    /* Display the phase of the moon as text */
+    moontxt(szPotm, ptm);
+    printf("Phase-of-the-Moon:%s\n", szPotm+11);
 
-  /* Display the phase of the moon as Ascii Art */
-  pBuf = moonaa(20, 38, inverse, ptm);
-  if (!pBuf) return 1;
-  fputs(pBuf, stdout);
-  free(pBuf);
+    /* Display the phase of the moon as Ascii Art */
+    pBuf = moonaa(20, 38, inverse, ptm);
+    if (!pBuf) return 1;
+    fputs(pBuf, stdout);
+    free(pBuf);
+  } while (iRange);
 
   return 0;
 }
@@ -0,0 +1,374 @@
+/*
+ * record.c
+ *
+ * Machine-readable output records, in the JSON Lines or CSV formats.
+ *
+ * Each program defines the names of its fields once, in a NULL-terminated
+ * array, and then appends the values of each record in that order:
+ *   static const char * const fields[] = {"date", "time", NULL};
+ *   RECORD rec;
+ *   record_init(&rec, FMT_JSONL, fields);
+ *   fwrite(rec.szBuf, 1, record_header(&rec), stdout);	// The CSV header
+ *   record_begin(&rec);
+ *   record_date(&rec, 2025, 1, 1);
+ *   record_null(&rec);
+ *   fwrite(rec.szBuf, 1, record_end(&rec), stdout);
+ *
+ * The text is built in the fixed buffer in the RECORD structure, which is
+ * reused for every record. Nothing is allocated.
+ * Numbers are formatted here, and not by printf(), so that the output does
+ * not depend on the locale, and is as fast as possible for long date ranges.
+ * A record too long for the buffer is truncated, but still terminated.
+ *
+ * Authors:
+ *   JFL jf.larvoire@free.fr
+ *
+ * History:
+ *   2026-10-19 JFL Created this module.
+ *		    Added the binary day rows.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "today.h"
+
+#define RECORD_ROOM (RECORD_SIZE - 3)	/* Leave room for the final "}\n" */
+
+#define streq(s1, s2) (!strcmp(s1, s2))
+
+/* Append text, dropping whatever does not fit */
+static void rec_add(RECORD *pr, const char *p, size_t n) {
+  if (pr->nLen + n > RECORD_ROOM) n = (pr->nLen < RECORD_ROOM) ? RECORD_ROOM - pr->nLen : 0;
+  memcpy(pr->szBuf + pr->nLen, p, n);
+  pr->nLen += n;
+}
+
+/* Append an unsigned number, with at least nDigits digits */
+static void rec_uint(RECORD *pr, unsigned long ul, int nDigits) {
+  char buf[24];
+  char *p = buf + sizeof(buf);
+  do {
+    *(--p) = (char)('0' + (ul % 10));
+    ul /= 10;
+    nDigits--;
+  } while ((ul || (nDigits > 0)) && (p > buf));
+  rec_add(pr, p, buf + sizeof(buf) - p);
+}
+
+/* Append a quoted JSON string, or a CSV field, escaping special characters */
+static void rec_quote(RECORD *pr, const char *psz) {
+  size_t n;
+
+  if (pr->iFormat == FMT_CSV) {
+    if (!psz[strcspn(psz, ",\"\r\n")]) {	/* Nothing to escape */
+      rec_add(pr, psz, strlen(psz));
+      return;
+    }
+    rec_add(pr, "\"", 1);
+    while (*psz) {
+      n = strcspn(psz, "\"");
+      rec_add(pr, psz, n);
+      psz += n;
+      if (*psz) {
+	rec_add(pr, "\"\"", 2);
+	psz++;
+      }
+    }
+    rec_add(pr, "\"", 1);
+    return;
+  }
+  rec_add(pr, "\"", 1);
+  while (*psz) {
+    for (n = 0; psz[n] && (psz[n] != '"') && (psz[n] != '\\') && ((unsigned char)psz[n] >= ' '); n++) ;
+    rec_add(pr, psz, n);
+    psz += n;
+    if (*psz) {
+      char esc[7] = "\\u00";
+      esc[4] = "0123456789abcdef"[(*psz >> 4) & 0x0F];
+      esc[5] = "0123456789abcdef"[*psz & 0x0F];
+      if ((*psz == '"') || (*psz == '\\')) {
+	esc[1] = *psz;
+	rec_add(pr, esc, 2);
+      } else {
+	rec_add(pr, esc, 6);
+      }
+      psz++;
+    }
+  }
+  rec_add(pr, "\"", 1);
+}
+
+/* Start the next field: The separator, and the JSON key */
+static void rec_field(RECORD *pr) {
+  const char *pszName = pr->ppNames[pr->iField];
+
+  if (pr->iField++) rec_add(pr, ",", 1);
+  if (pr->iFormat == FMT_JSONL) {
+    rec_quote(pr, pszName ? pszName : "");
+    rec_add(pr, ":", 1);
+  }
+}
+
+/* Get the format code for a --format name. Return -1 if unknown */
+int record_format(const char *pszName) {
+  if (streq(pszName, "jsonl")) return FMT_JSONL;
+  if (streq(pszName, "csv")) return FMT_CSV;
+  return -1;
+}
+
+void record_init(RECORD *pr, int iFormat, const char * const *ppNames) {
+  pr->iFormat = iFormat;
+  pr->ppNames = ppNames;
+  pr->iField = 0;
+  pr->nLen = 0;
+  pr->szBuf[0] = '\0';
+}
+
+/* Build the CSV header line. Return its length, or 0 for JSON Lines */
+size_t record_header(RECORD *pr) {
+  int i;
+
+  pr->nLen = 0;
+  if (pr->iFormat == FMT_CSV) {
+    for (i = 0; pr->ppNames[i]; i++) {
+      if (i) rec_add(pr, ",", 1);
+      rec_quote(pr, pr->ppNames[i]);
+    }
+    pr->szBuf[pr->nLen++] = '\n';
+  }
+  pr->szBuf[pr->nLen] = '\0';
+  return pr->nLen;
+}
+
+void record_begin(RECORD *pr) {
+  pr->iField = 0;
+  pr->nLen = 0;
+  if (pr->iFormat == FMT_JSONL) rec_add(pr, "{", 1);
+}
+
+/* Terminate the record line. Return its length */
+size_t record_end(RECORD *pr) {
+  if (pr->iFormat == FMT_JSONL) pr->szBuf[pr->nLen++] = '}';
+  pr->szBuf[pr->nLen++] = '\n';
+  pr->szBuf[pr->nLen] = '\0';
+  return pr->nLen;
+}
+
+/* Missing value: null in JSON, an empty field in CSV */
+void record_null(RECORD *pr) {
+  rec_field(pr);
+  if (pr->iFormat == FMT_JSONL) rec_add(pr, "null", 4);
+}
+
+void record_str(RECORD *pr, const char *psz) {
+  if (!psz) {
+    record_null(pr);
+    return;
+  }
+  rec_field(pr);
+  rec_quote(pr, psz);
+}
+
+/* Append a JSON number, true, false, or null token as is */
+void record_raw(RECORD *pr, const char *psz) {
+  rec_field(pr);
+  rec_add(pr, psz, strlen(psz));
+}
+
+void record_int(RECORD *pr, long l) {
+  rec_field(pr);
+  if (l < 0) rec_add(pr, "-", 1);
+  rec_uint(pr, (l < 0) ? 0UL - (unsigned long)l : (unsigned long)l, 1);
+}
+
+/* Append a number with nDecimals decimals. null if it's not a finite number */
+void record_num(RECORD *pr, double d, int nDecimals) {
+  unsigned long scale = 1;
+  unsigned long ul;
+  int i;
+
+  for (i = 0; i < nDecimals; i++) scale *= 10;
+  if (!(fabs(d) * scale < 4e9)) {	/* NaN, infinite, or beyond 32-bit longs */
+    record_null(pr);
+    return;
+  }
+  ul = (unsigned long)(fabs(d) * scale + 0.5);
+  rec_field(pr);
+  if ((d < 0) && ul) rec_add(pr, "-", 1);
+  rec_uint(pr, ul / scale, 1);
+  if (nDecimals) {
+    rec_add(pr, ".", 1);
+    rec_uint(pr, ul % scale, nDecimals);
+  }
+}
+
+void record_bool(RECORD *pr, int i) {
+  rec_field(pr);
+  if (i) {
+    rec_add(pr, "true", 4);
+  } else {
+    rec_add(pr, "false", 5);
+  }
+}
+
+/* Append the YYYY-MM-DD digits of a date */
+static void rec_ymd(RECORD *pr, int y, int m, int d) {
+  char buf[6];
+
+  if (y < 0) {
+    rec_add(pr, "-", 1);
+    y = -y;
+  }
+  rec_uint(pr, (unsigned long)y, 4);
+  buf[0] = '-';
+  buf[1] = (char)('0' + m / 10);
+  buf[2] = (char)('0' + m % 10);
+  buf[3] = '-';
+  buf[4] = (char)('0' + d / 10);
+  buf[5] = (char)('0' + d % 10);
+  rec_add(pr, buf, 6);
+}
+
+/* Append a YYYY-MM-DD date */
+void record_date(RECORD *pr, int y, int m, int d) {
+  rec_field(pr);
+  if (pr->iFormat == FMT_JSONL) rec_add(pr, "\"", 1);
+  rec_ymd(pr, y, m, d);
+  if (pr->iFormat == FMT_JSONL) rec_add(pr, "\"", 1);
+}
+
+/*
+ * Append a YYYY-MM-DDTHH:MM:SS+HH:MM local time, from the local date and the
+ * number of seconds since its midnight, which may be outside of that day.
+ * offset = The UTC offset, in seconds East. 0 is output as Z.
+ */
+void record_time(RECORD *pr, int y, int m, int d, long secs, long offset) {
+  long days = days_from_civil(y, m, d) + secs / 86400;
+  char buf[16];
+  char *p = buf;
+  unsigned long ul;
+
+  secs %= 86400;
+  if (secs < 0) {
+    secs += 86400;
+    days -= 1;
+  }
+  civil_from_days(days, &y, &m, &d);
+  rec_field(pr);
+  if (pr->iFormat == FMT_JSONL) rec_add(pr, "\"", 1);
+  rec_ymd(pr, y, m, d);
+  *(p++) = 'T';
+  *(p++) = (char)('0' + secs / 36000);
+  *(p++) = (char)('0' + (secs / 3600) % 10);
+  *(p++) = ':';
+  *(p++) = (char)('0' + (secs / 600) % 6);
+  *(p++) = (char)('0' + (secs / 60) % 10);
+  *(p++) = ':';
+  *(p++) = (char)('0' + (secs / 10) % 6);
+  *(p++) = (char)('0' + secs % 10);
+  if (!offset) {
+    *(p++) = 'Z';
+  } else {
+    *(p++) = (offset < 0) ? '-' : '+';
+    ul = (unsigned long)((offset < 0) ? -offset : offset) / 60;
+    *(p++) = (char)('0' + (ul / 600) % 10);
+    *(p++) = (char)('0' + (ul / 60) % 10);
+    *(p++) = ':';
+    *(p++) = (char)('0' + (ul % 60) / 10);
+    *(p++) = (char)('0' + ul % 10);
+  }
+  if (pr->iFormat == FMT_JSONL) *(p++) = '"';
+  rec_add(pr, buf, p - buf);
+}
+
+/*
+ * Binary day rows, for large runs: A header describing the columns, then
+ * fixed-width rows of little-endian columns, so that the file can be mapped
+ * in memory and used as is. The number of rows is
+ * (file size - header size) / row size.
+ */
+
+static const struct {		/* The day row columns */
+  char *pszName;
+  char type;			/* 'i'=Signed int; 'u'=Unsigned int; 'f'=IEEE float */
+  unsigned char size;		/* In bytes */
+  unsigned short offset;	/* In the row */
+} daybin_cols[] = {
+  {"day",          'i', 4,  0},	/* Days since 1970-01-01 */
+  {"rise",         'i', 4,  4},	/* Seconds since the local midnight. -1=None */
+  {"noon",         'i', 4,  8},
+  {"set",          'i', 4, 12},
+  {"utc_offset",   'i', 4, 16},	/* Seconds East */
+  {"illumination", 'f', 4, 20},	/* 0 to 1 */
+  {"status",       'i', 1, 24},	/* sun() result */
+  {"waxing",       'u', 1, 25},
+};
+#define DAYBIN_NCOLS (sizeof(daybin_cols) / sizeof(daybin_cols[0]))
+
+static void put_le(unsigned char *p, unsigned long ul, int n) {
+  while (n--) {
+    *(p++) = (unsigned char)ul;
+    ul >>= 8;
+  }
+}
+
+/* Copy the bytes of a host float or double, in the little-endian order */
+static void put_le_bytes(unsigned char *p, const void *pv, int n) {
+  unsigned short one = 1;
+  const unsigned char *pc = (const unsigned char *)pv;
+  int i;
+
+  for (i = 0; i < n; i++) p[i] = *(unsigned char *)&one ? pc[i] : pc[n - 1 - i];
+}
+
+/* Build the header. lonEast = Longitude, +=East */
+size_t daybin_header(unsigned char *buf, double lat, double lonEast, const char *pszCity) {
+  unsigned char *p;
+  size_t n;
+  int i;
+
+  memset(buf, 0, DAYBIN_HEADER_SIZE);
+  memcpy(buf, DAYBIN_MAGIC, 8);
+  put_le(buf + 8, DAYBIN_VERSION, 2);
+  put_le(buf + 10, DAYBIN_NCOLS, 2);
+  put_le(buf + 12, DAYBIN_HEADER_SIZE, 2);
+  put_le(buf + 14, DAYBIN_ROW_SIZE, 2);
+  put_le_bytes(buf + 16, &lat, 8);
+  put_le_bytes(buf + 24, &lonEast, 8);
+  n = strlen(pszCity);
+  memcpy(buf + 32, pszCity, (n < 63) ? n : 63);
+  for (i = 0, p = buf + 96; i < (int)DAYBIN_NCOLS; i++, p += 20) {
+    memcpy(p, daybin_cols[i].pszName, strlen(daybin_cols[i].pszName));
+    p[16] = (unsigned char)daybin_cols[i].type;
+    p[17] = daybin_cols[i].size;
+    put_le(p + 18, daybin_cols[i].offset, 2);
+  }
+  return DAYBIN_HEADER_SIZE;
+}
+
+/* Convert local hours to seconds */
+static unsigned long hours_to_secs(double h) {
+  return (unsigned long)(long)(h * 3600 + 0.5);
+}
+
+/* Build one row. psd = The sun_day() results, or NULL if it failed */
+size_t daybin_row(unsigned char *buf, long day, const SUNDAY *psd,
+		  long offset, double illum, int waxing) {
+  int iStatus = !psd ? 1 : (psd->state == RS_RISES) ? 0
+	      : (psd->state == RS_CIRCUMPOLAR) ? SUN_ALWAYS_UP : SUN_ALWAYS_DOWN;
+  float f = (float)illum;
+
+  put_le(buf, (unsigned long)day, 4);
+  put_le(buf + 4, iStatus ? 0xFFFFFFFFUL : hours_to_secs(psd->rise), 4);
+  put_le(buf + 8, psd ? hours_to_secs(psd->noon) : 0xFFFFFFFFUL, 4);
+  put_le(buf + 12, iStatus ? 0xFFFFFFFFUL : hours_to_secs(psd->set), 4);
+  put_le(buf + 16, (unsigned long)offset, 4);
+  put_le_bytes(buf + 20, &f, 4);
+  buf[24] = (unsigned char)iStatus;
+  buf[25] = (unsigned char)(waxing != 0);
+  buf[26] = buf[27] = 0;
+  return DAYBIN_ROW_SIZE;
+}
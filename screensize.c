@@ -9,6 +9,8 @@
 *   History                                                                   *
 *    2019-01-11 JFL For Windows, query CONOUT$ instead of stdout, to avoid    *
 *                   getting witdth 1 when the output is redirected to a pipe. *
+*    2026-10-19 JFL For Unix, use the TIOCGWINSZ ioctl if available, instead *
+*                   of running tput in a subshell.                            *
 *                                                                             *
 *                                                                             *
 \*****************************************************************************/
@@ -113,6 +115,7 @@ int GetScreenColumns(void) {
 #ifdef __unix__
 
 #include <unistd.h>
+#include <sys/ioctl.h>	/* For TIOCGWINSZ */
 
 #if defined(USE_TERMCAP) && USE_TERMCAP
 
@@ -197,11 +200,28 @@ char *Exec(char *pszCmd) {
   return pszBuf; /* Must be freed by the caller */
 }
 
+#ifdef TIOCGWINSZ
+/* Get the terminal size from the first standard handle that is a terminal */
+static int GetWinSize(struct winsize *pws) {
+  int fd;
+  for (fd = 1; fd <= 3; fd++) {
+    if (!ioctl(fd % 3, TIOCGWINSZ, pws) && pws->ws_col) return 1;
+  }
+  return 0;
+}
+#endif
+
 int GetScreenRows(void) {
   int nRows = 25; /* Default for VGA screens */
   /* char *pszRows = getenv("LINES"); */
   /* if (pszRows) nRows = atoi(pszRows); */
-  char *pszBuf = Exec("tput lines");
+  char *pszBuf;
+#ifdef TIOCGWINSZ
+  struct winsize ws;
+  if (GetWinSize(&ws)) return ws.ws_row;
+  return nRows;		/* No terminal. Don't run tput for nothing */
+#endif
+  pszBuf = Exec("tput lines");
   if (pszBuf) {
     nRows = atoi(pszBuf);
     free(pszBuf);
@@ -213,7 +233,13 @@ int GetScreenColumns(void) {
   int nCols = 80; /* Default for VGA screens */
   /* char *pszCols = getenv("COLUMNS"); */
   /* if (pszCols) nCols = atoi(pszCols); */
-  char *pszBuf = Exec("tput cols");
+  char *pszBuf;
+#ifdef TIOCGWINSZ
+  struct winsize ws;
+  if (GetWinSize(&ws)) return ws.ws_col;
+  return nCols;		/* No terminal. Don't run tput for nothing */
+#endif
+  pszBuf = Exec("tput cols");
   if (pszBuf) {
     nCols = atoi(pszBuf);
     free(pszBuf);
@@ -0,0 +1,89 @@
+/*
+ * seasons.c
+ *
+ * Find the equinoxes and solstices, i.e. the instants when the Sun apparent
+ * ecliptic longitude crosses 0, 90, 180, or 270 degrees.
+ *
+ * The solar longitude used is the one from sun_meeus() in moonelp.c, which
+ * takes into account the precession of the perigee, and the secular changes
+ * of the Earth orbit. It's corrected for the aberration, the nutation, and
+ * the main planetary perturbations. solar_lon() in sun.c uses fixed 1980
+ * orbital elements, and no corrections. That's fine for sunrise and sunset,
+ * but it puts the equinoxes about 20 hours off.
+ *
+ * Each instant is first bracketed from its mean date, then refined with
+ * Newton's method, falling back to bisection if a step leaves the bracket.
+ * The results are within a few minutes of the published instants.
+ *
+ * Authors:
+ *   JFL jf.larvoire@free.fr
+ *
+ * History:
+ *   2026-10-18 JFL Created this module.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#include "today.h"
+
+#define J2000		2451545.0	/* JDE of 2000-01-01 12:00 TT */
+#define TROPICAL	365.242189	/* Mean tropical year, in days */
+#define EQUINOX2000	2451623.80984	/* JDE of the mean March equinox of 2000 (Meeus 27.1) */
+
+/* Sun apparent ecliptic longitude in degrees, at a given JDE */
+double solar_lon_apparent(double jde) {
+  double lambda, r, T, omega, pert;
+
+  sun_meeus(jde, &lambda, &r);
+  T = (jde - J2000) / 36525.0;
+  omega = 125.04 - 1934.136 * T;	/* Moon ascending node, for the nutation */
+  /* Main perturbations by Venus, Jupiter, and the Moon (Meeus, Astronomical formulae, ch. 18) */
+  T += 1.0;	/* These arguments are counted from 1900 */
+  pert = 0.00134 * cos(dtor(153.23 + 22518.7541 * T))
+       + 0.00154 * cos(dtor(216.57 + 45037.5082 * T))
+       + 0.00200 * cos(dtor(312.69 + 32964.3577 * T))
+       + 0.00179 * sin(dtor(350.74 + 445267.1142 * T))
+       + 0.00178 * sin(dtor(231.19 + 20.20 * T));
+  lambda += pert - 0.00569 - 0.00478 * sin(dtor(omega));
+  lambda = fmod(lambda, 360.0);
+  if (lambda < 0.0) lambda += 360.0;
+  return lambda;
+}
+
+/* Signed angular difference a - b, in [-180, 180) */
+static double diff180(double a, double b) {
+  double d = fmod(a - b + 540.0, 360.0);
+  if (d < 0.0) d += 360.0;
+  return d - 180.0;
+}
+
+/* Find the JD (UT) when the Sun apparent longitude is angle, within 10 days from jdGuess */
+double solar_lon_jd(double jdGuess, double angle) {
+  double lo = jdGuess - 10.0, hi = jdGuess + 10.0;
+  double t = jdGuess;
+  double rate = 360.0 / TROPICAL;	/* Mean rate, in degrees/day */
+  int i;
+
+  for (i = 0; i < 50; i++) {
+    double f = diff180(solar_lon_apparent(t), angle);
+    double tNext;
+    if (f < 0.0) lo = t; else hi = t;	/* Keep the root bracketed */
+    if (fabs(f) < 1e-7) break;		/* ~1/100th of a second */
+    tNext = t - f / rate;		/* Newton step */
+    if ((tNext <= lo) || (tNext >= hi)) tNext = (lo + hi) / 2;	/* Bisection step */
+    t = tNext;
+  }
+  return t - delta_t(t) / 86400.0;
+}
+
+/* Get the JD (UT) of the 4 equinoxes and solstices of a given year, in date order */
+void seasons(int year, double jd[4]) {
+  int i;
+  double jdMean = EQUINOX2000 + TROPICAL * (year - 2000);
+
+  for (i = 0; i < 4; i++) {
+    jd[i] = solar_lon_jd(jdMean + i * TROPICAL / 4, i * 90.0);
+  }
+}
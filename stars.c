@@ -0,0 +1,298 @@
+/*
+** stars.c - Display the rise, transit, and set times of the stars in a catalog
+**
+** The catalog is a text file with one star per line, with 4 comma-separated
+** fields: Name, Right ascension, Declination, Magnitude. The coordinates are
+** J2000, as decimal hours and degrees, or as sexagesimal hh:mm:ss and
+** dd:mm:ss. Empty lines, and lines beginning with a #, are ignored.
+** See stars.csv for an example.
+**
+** The catalog is loaded into a structure of arrays. The positions are
+** precessed to the date, then the rise and set of all stars are computed in a
+** single call to rise_set_n(), and all sidereal times are converted to local
+** times relative to the same local sidereal time of midnight.
+** Circumpolar stars, and those that never rise, are reported as such.
+**
+** Authors:
+**   JFL jf.larvoire@free.fr
+**
+** History:
+**   2026-10-19 JFL Created this program.
+**		    Rename main() and usage() when built into todaybox.
+*/
+
+#define VERSION "2026-10-19"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "today.h"
+#include "versions.h"
+
+#ifdef MULTICALL		/* Linked into the todaybox multi-call program */
+#define main stars_main
+#define usage stars_usage
+#endif
+
+#define streq(s1, s2) (!strcmp(s1, s2))
+
+#define H0_STAR		(-0.5667)	/* Star altitude at rise & set, due to the refraction */
+#define SOLAR_PER_SIDEREAL 0.9972695663	/* Solar hours per sidereal hour */
+
+typedef struct _CATALOG {	/* Star catalog, as a structure of arrays */
+  int n;
+  int nAlloc;
+  char **ppszName;
+  double *ra;			/* Right ascension, in hours */
+  double *dec;			/* Declination, in degrees */
+  double *mag;			/* Visual magnitude */
+} CATALOG;
+
+void usage() {
+  char namebuf[256];
+  char *pName = defaultSysConfFile(namebuf, sizeof(namebuf));
+#if !defined(_MSDOS)
+  char namebufU[256];
+  char *pNameU = defaultUserConfFile(namebufU, sizeof(namebufU));
+  if (pNameU) {
+    strcat(pName, " or ");
+    strcat(pName, pNameU);
+  }
+#endif
+  printf("\
+stars - Display the rise, transit, and set times of the stars in a catalog\n\
+\n\
+Usage: stars [OPTIONS] CATALOG [DATE]\n\
+\n\
+Options:\n\
+  -?|-h|--help      Display this help screen\n\
+  -c PATHNAME       Configuration file name. Default: See below\n\
+  -V|--version      Display the program version\n\
+\n\
+Catalog: A text file with one star per line, with comma-separated fields:\n\
+  Name, RA (J2000, hh:mm:ss or hours), Dec (J2000, dd:mm:ss or degrees), Mag\n\
+\n\
+Date: YYYY-MM-DD or YYYY-DDD, with - optional, default: today\n\
+\n\
+Configuration file: This program has built-in settings for %s.\n\
+See the today program help for the configuration file format.\n\
+Default file names: %s\n\
+"
+#ifdef __unix__
+"\n"
+#endif
+, today_city, pName);
+}
+
+/* Parse a decimal or sexagesimal angle. Return 0 if OK */
+int parse_angle(char *psz, double *pValue) {
+  double d = 0.0, m = 0.0, s = 0.0;
+  int neg;
+  int n;
+
+  while ((*psz == ' ') || (*psz == '\t')) psz++;
+  neg = (*psz == '-');
+  if ((*psz == '-') || (*psz == '+')) psz++;
+  n = sscanf(psz, "%lf:%lf:%lf", &d, &m, &s);
+  if (n < 1) return 1;
+  d += m / 60.0 + s / 3600.0;
+  *pValue = neg ? -d : d;
+  return 0;
+}
+
+/* Append a star to the catalog. Return 0 if OK */
+int add_star(CATALOG *pc, char *pszName, double ra, double dec, double mag) {
+  if (pc->n == pc->nAlloc) {
+    int nAlloc = pc->nAlloc ? 2 * pc->nAlloc : 256;
+    char **ppszName = realloc(pc->ppszName, nAlloc * sizeof(char *));
+    double *pRa = realloc(pc->ra, nAlloc * sizeof(double));
+    double *pDec = realloc(pc->dec, nAlloc * sizeof(double));
+    double *pMag = realloc(pc->mag, nAlloc * sizeof(double));
+    if (ppszName) pc->ppszName = ppszName;
+    if (pRa) pc->ra = pRa;
+    if (pDec) pc->dec = pDec;
+    if (pMag) pc->mag = pMag;
+    if (!(ppszName && pRa && pDec && pMag)) return 1;
+    pc->nAlloc = nAlloc;
+  }
+  pc->ppszName[pc->n] = malloc(strlen(pszName) + 1);
+  if (!pc->ppszName[pc->n]) return 1;
+  strcpy(pc->ppszName[pc->n], pszName);
+  pc->ra[pc->n] = ra;
+  pc->dec[pc->n] = dec;
+  pc->mag[pc->n] = mag;
+  pc->n += 1;
+  return 0;
+}
+
+/* Load a catalog file. Return 0 if OK */
+int load_catalog(char *pszFile, CATALOG *pc) {
+  FILE *f;
+  char line[1024];
+  int iLine = 0;
+
+  f = fopen(pszFile, "r");
+  if (!f) {
+    fprintf(stderr, "Error: Can't open \"%s\"\n", pszFile);
+    return 1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    char *pszName, *pszRa, *pszDec, *pszMag;
+    double ra, dec, mag;
+    int l;
+    iLine += 1;
+    pszName = line;
+    while ((*pszName == ' ') || (*pszName == '\t')) pszName++;
+    if ((*pszName == '#') || (*pszName == '\r') || (*pszName == '\n') || !*pszName) continue;
+    pszRa = strchr(pszName, ',');
+    pszDec = pszRa ? strchr(pszRa + 1, ',') : NULL;
+    pszMag = pszDec ? strchr(pszDec + 1, ',') : NULL;
+    if (!pszMag) goto bad_line;
+    *(pszRa++) = *(pszDec++) = *(pszMag++) = '\0';
+    for (l = (int)strlen(pszName); l && strchr(" \t", pszName[l-1]); l--) ;
+    pszName[l] = '\0';
+    if (parse_angle(pszRa, &ra) || parse_angle(pszDec, &dec) || (sscanf(pszMag, "%lf", &mag) != 1)) goto bad_line;
+    if (add_star(pc, pszName, ra, dec, mag)) {
+      fprintf(stderr, "Error: Out of memory\n");
+      fclose(f);
+      return 1;
+    }
+    continue;
+bad_line:
+    fprintf(stderr, "Warning: %s(%d): Invalid star definition ignored\n", pszFile, iLine);
+  }
+  fclose(f);
+  return 0;
+}
+
+/* Convert a local sidereal time to a local time string, relative to the LST of midnight */
+char *lst_to_str(char *buf, double lst, double m1) {
+  double h = fmod(lst - m1 + 24.0, 24.0) * SOLAR_PER_SIDEREAL;
+  int mn = (int)(h * 60.0 + 0.5);
+  sprintf(buf, "%02d:%02d", (mn / 60) % 24, mn % 60);
+  return buf;
+}
+
+int main(int argc, char *argv[]) {
+  int i;
+  char *pszCatalog = NULL;
+  char *pszDate = NULL;
+  char *pszCfgFile = NULL;
+  struct tm stm;
+  struct tm *pt;
+  CATALOG cat = {0};
+  double *ra, *dec, *lstr, *lsts, *ar;
+  int *state;
+  double years, m1;
+  clock_t t0, t1;
+
+  for (i=1; i<argc; i++) {
+    char *arg = argv[i];
+    if (   streq(arg, "-?")
+#if defined(_MSDOS) || defined(_WIN32)
+        || streq(arg, "/?")
+#endif
+        || streq(arg, "-h")
+        || streq(arg, "--help")) {
+      usage();
+      return 0;
+    }
+    if (streq(arg, "-c") && ((i+1)<argc)) {
+      pszCfgFile = argv[++i];
+      continue;
+    }
+    if (streq(arg, "-d")) {
+      today_debug = 1;
+      continue;
+    }
+    if (   streq(arg, "-V")
+	|| streq(arg, "--version")) {
+      printf(VERSION " " EXE_OS_NAME "\n");
+      return 0;
+    }
+    if ((arg[0] == '-') && arg[1]) {
+      fprintf(stderr, "Unexpected option: %s\n", arg);
+      return 1;
+    }
+    if (!pszCatalog) {
+      pszCatalog = arg;
+      continue;
+    }
+    if (!pszDate) {
+      pszDate = arg;
+      continue;
+    }
+    fprintf(stderr, "Unexpected argument: %s\n", arg);
+    return 1;
+  }
+  if (!pszCatalog) {
+    usage();
+    return 1;
+  }
+
+  if (get_location(pszCfgFile)) return 1;
+  if (pszDate) {
+    if (parsetime(pszDate, &stm)) {
+      fprintf(stderr, "Error: Invalid date: %s\n", pszDate);
+      return 1;
+    }
+    pt = &stm;
+  } else {
+    time_t sec_1970;
+    time(&sec_1970);
+    pt = loc_localtime(sec_1970, &stm);
+  }
+
+  if (load_catalog(pszCatalog, &cat)) return 1;
+  if (!cat.n) return 0;
+  ra = malloc(cat.n * sizeof(double));
+  dec = malloc(cat.n * sizeof(double));
+  lstr = malloc(cat.n * sizeof(double));
+  lsts = malloc(cat.n * sizeof(double));
+  ar = malloc(cat.n * sizeof(double));
+  state = malloc(cat.n * sizeof(int));
+  if (!(ra && dec && lstr && lsts && ar && state)) {
+    fprintf(stderr, "Error: Out of memory\n");
+    return 1;
+  }
+
+  t0 = clock();
+  /* Precess the J2000 positions to the date, with the annual precession rates */
+  stm = *pt;
+  stm.tm_hour = 12;
+  stm.tm_min = stm.tm_sec = 0;
+  years = (tm_to_jd(&stm) - 2451545.0) / 365.25;
+  for (i = 0; i < cat.n; i++) {
+    double a = dtor(cat.ra[i] * 15.0);
+    double d = dtor(cat.dec[i]);
+    ra[i] = cat.ra[i] + years * (3.075 + 1.336 * sin(a) * tan(d)) / 3600.0;
+    dec[i] = cat.dec[i] + years * 20.04 * cos(a) / 3600.0;
+  }
+  rise_set_n(cat.n, ra, dec, H0_STAR, lstr, lsts, ar, state);
+  m1 = midnight_lst(pt);
+  t1 = clock();
+  if (today_debug) printf("Computed %d stars in %.3f ms\n", cat.n, 1000.0 * (double)(t1 - t0) / CLOCKS_PER_SEC);
+
+  printf("%04d-%02d-%02d in %s\n", pt->tm_year + 1900, pt->tm_mon + 1, pt->tm_mday, today_city);
+  printf("%-20s %5s  %5s  %5s  %5s  %s\n", "Star", "Mag", "Rise", "Trans", "Set", "Rise azimuth");
+  for (i = 0; i < cat.n; i++) {
+    char szRise[8], szTransit[8], szSet[8];
+    printf("%-20s %5.2f  ", cat.ppszName[i], cat.mag[i]);
+    switch (state[i]) {
+      case RS_CIRCUMPOLAR:
+	printf("  -    %s    -    Circumpolar\n", lst_to_str(szTransit, ra[i], m1));
+	break;
+      case RS_NEVER_RISES:
+	printf("  -      -      -    Never rises\n");
+	break;
+      default:
+	printf("%s  %s  %s  %3.0f\n", lst_to_str(szRise, lstr[i], m1), lst_to_str(szTransit, ra[i], m1),
+	       lst_to_str(szSet, lsts[i], m1), ar[i]);
+	break;
+    }
+  }
+  return 0;
+}
@@ -55,6 +55,33 @@
 *    2022-06-21 JFL Fixed a bug introduced on 2019-01-14: If we were given no date, use the local time. (As was done before)
 *		    - The local date may actually be different from the GMT date.
 *                   - This also makes sure that the DST variable is set correctly.
+*    2026-10-18 JFL Moved the location configuration loading to new routine get_location().
+*		    It's done only once, so that sun() can be called repeatedly.
+*		    Bugfix: sun() decremented tz every time it was called in summer.
+*    2026-10-19 JFL Added rise_set_n(), computing the rise and set of arrays of
+*		    objects, and reporting circumpolar objects instead of exiting.
+*		    Added midnight_lst(), to share the local sidereal time of midnight.
+*		    Added the TIMEZONE configuration, with the location time zone
+*		    read from the tz database. Added routines loc_tz_hours(),
+*		    loc_tz_abbr(), and loc_localtime() using it.
+*		    Made sun() and loc_localtime() thread-safe, for today -x.
+*		    sun() returns SUN_ALWAYS_UP or SUN_ALWAYS_DOWN on polar days
+*		    and nights, instead of exiting. Added loc_utc_offset() and
+*		    sun_status(), for the machine-readable outputs.
+*		    Split sun() into sun_day(), returning the sun events in a
+*		    SUNDAY structure, with the solar noon, and fractional hours.
+*		    Added reentrant routines location_load(), sun_day_at(), and
+*		    location_xxx(), using a LOCATION structure instead of the
+*		    global variables, for libtoday. The routines using the global
+*		    location are now wrappers around them.
+*    2026-10-19 JFL Replaced the debug output of the hot routines by TRACE()
+*		    events, compiled in only with make TRACE=1. Added the Kepler
+*		    iterations, range loops, and config files counters.
+*		    Flag the configured locations, which use the system time
+*		    zone DST rules if they have no TIMEZONE.
+*		    Renamed the global location variables today_xxx, and made
+*		    the other globals static, so that they never collide with
+*		    the symbols of the applications linking with libtoday.a.
 */
 
 #include <stdio.h>
@@ -110,40 +137,39 @@ double sin_deg(double x);
 double cos_deg(double x);
 double tan_deg(double x);
 void lon_to_eq(double lambda, double *alpha, double *delta);
-void rise_set(double alpha, double delta, double *lstr, double *lsts, double *ar, double *as);
-void lst_to_hm(double lst, double jd, int *h, int *m);
+int rise_set(double lat, double alpha, double delta, double *lstr, double *lsts, double *ar, double *as);
+static void rise_set_lat(double lat, int n, const double *alpha, const double *delta, double h0,
+			 double *lstr, double *lsts, double *ar, int *state);
+double lst_to_h(double lst, double jd, double tzd, int yr, double lon);
 void dh_to_hm(double dh, int *h, int *m);
-void eq_to_altaz(double r, double d, double t, double *alt, double *az);
+void eq_to_altaz(double r, double d, double t, double lat, double lon, double *alt, double *az);
 double gmst(double j, double f);
 
 struct tm *localtime();
 
-int th;
-int tm;
-int ts;
-int mo;
-int day;
-int yr;
+int today_tz = TZ;		/* Default time zone */
+char today_tzs[8]  = TZS;	/* Default time zone string */
+char today_dtzs[8] = DTZS;	/* Default daylight savings time string */
+char today_tzid[64] = "";	/* Time zone ID in the tz database. Ex: Europe/Paris */
 
-int tz = TZ;			/* Default time zone */
-char tzs[8]  = TZS;		/* Default time zone string */
-char dtzs[8] = DTZS;		/* Default daylight savings time string */
+double today_lat = LAT;		/* Default latitude */
+double today_lon = LON;		/* Default Longitude */
+char today_city[256] = CITY;	/* City name*/
 
-double lat = LAT;		/* Default latitude */
-double lon = LON;		/* Default Longitude */
-char city[256] = CITY;		/* City name*/
+/* The location used by the routines without a LOCATION argument, with its time zone */
+static LOCATION here = {LAT, LON, TZ, TZS, DTZS, "", CITY};
 
-int popt = 0;
+static int popt = 0;
 
 /* Directory separator */
 #if defined(_MSDOS) || defined(_WIN32) || defined(_OS2)
-  char sep = '\\';
-  char *systemFile = "location.inf";
-  char *userFile = "location.inf";
+  static const char sep = '\\';
+  static const char *systemFile = "location.inf";
+  static const char *userFile = "location.inf";
 #else
-  char sep = '/';
-  char *systemFile = "location.conf";
-  char *userFile = ".location";
+  static const char sep = '/';
+  static const char *systemFile = "location.conf";
+  static const char *userFile = ".location";
 #endif
 
 /* Check if a path refers to an existing directory */
@@ -197,19 +223,13 @@ char *strncpyz(char *s1, const char *s2, size_t n) {
   return result;
 }
 
-int sun(sunrh, sunrm, sunsh, sunsm, pt, pFile)
-int *sunrh, *sunrm, *sunsh, *sunsm;
-struct tm *pt;
+/* Load a location from the configuration files and the environment. Return 0 if OK.
+   pFile = The configuration file name, or NULL to search the default files. */
+int location_load(pFile, ploc)
 char *pFile;
+LOCATION *ploc;
 {
-    double ed, jd;
-    double alpha1, delta1, alpha2, delta2, st1r, st1s, st2r, st2s;
-    double a1r, a1s, a2r, a2s, dt, dh, x, y;
-    double trise, tset, ar, as, alpha, delta, tri, da;
-    double lambda1, lambda2;
-    double alt, az, gst, m1;
-    double hsm, ratio;
-    int h, m;
+    static const LOCATION defLoc = {LAT, LON, TZ, TZS, DTZS, "", CITY};
     char nameBuf[256] = "";
     char buf[1024];
     char rc[8] = "";		/* Region code */
@@ -217,25 +237,26 @@ char *pFile;
     char country[128] = "";	/* Country name */
     char *pValue;
 
-    if (debug) printf("sun(%p, %p, %p, %p, %p);\n",
-      			sunrh, sunrm, sunsh, sunsm, pt);
+    *ploc = defLoc;
+    ploc->iSysTz = 1;		/* Without TIMEZONE, use the system DST rules */
 
     /* Check if we have a config file with location information */
     if (!pFile) {
       pFile = defaultUserConfFile(nameBuf, sizeof(nameBuf));
-      if (debug) printf("Trying \"%s\"\n", pFile);
+      if (today_debug) printf("Trying \"%s\"\n", pFile);
       if (pFile && !accessible(pFile, R_OK)) pFile = NULL;
     }
     if (!pFile) {
       pFile = defaultSysConfFile(nameBuf, sizeof(nameBuf));
-      if (debug) printf("Trying \"%s\"\n", pFile);
+      if (today_debug) printf("Trying \"%s\"\n", pFile);
       if (pFile && !accessible(pFile, R_OK)) pFile = NULL;
     }
     if (pFile) {
       FILE *f;
-      if (debug) printf("Opening \"%s\"\n", pFile);
+      if (today_debug) printf("Opening \"%s\"\n", pFile);
       f = fopen(pFile, "r");
       if (f) { /* The ~/.location configuration file exists */
+	TRACE_COUNT(TC_CONFIG, 1);
 	while ((fgets(buf, sizeof(buf), f))) { /* Parse every line in the file */
 	  char *tag = strtok(buf, " \t=");
 	  char *value;
@@ -254,13 +275,13 @@ char *pFile;
 	    if (!strchr(" \t\r\n", value[l-1])) break; /* This is the last valid character in value */
 	  }
 	  value[l] = '\0';
-	  if (debug) printf("Read %s = \"%s\"\n", tag, value);
+	  if (today_debug) printf("Read %s = \"%s\"\n", tag, value);
 	  if (!strcasecmp(tag, "LATITUDE")) {
-	    sscanf(value, "%lf", &lat);
+	    sscanf(value, "%lf", &ploc->lat);
 	  } else if (!strcasecmp(tag, "LONGITUDE")) {
-	    if (sscanf(value, "%lf", &lon)) lon = -lon; /* Longitudes are inverted! */
+	    if (sscanf(value, "%lf", &ploc->lon)) ploc->lon = -ploc->lon; /* Longitudes are inverted! */
 	  } else if (!strcasecmp(tag, "CITY")) {
-	    strncpyz(city, value, sizeof(city));
+	    strncpyz(ploc->city, value, sizeof(ploc->city));
 	  } else if (!strcasecmp(tag, "REGIONCODE")) {
 	    strncpyz(rc, value, sizeof(rc));
 	  } else if (!strcasecmp(tag, "COUNTRYCODE")) {
@@ -268,9 +289,11 @@ char *pFile;
 	  } else if (!strcasecmp(tag, "COUNTRYNAME")) {
 	    strncpyz(country, value, sizeof(country));
 	  } else if (!strcasecmp(tag, "TZABBR")) {
-	    strncpyz(tzs, value, sizeof(tzs));
+	    strncpyz(ploc->tzs, value, sizeof(ploc->tzs));
 	  } else if (!strcasecmp(tag, "DSTZABBR")) {
-	    strncpyz(dtzs, value, sizeof(dtzs));
+	    strncpyz(ploc->dtzs, value, sizeof(ploc->dtzs));
+	  } else if (!strcasecmp(tag, "TIMEZONE")) {
+	    strncpyz(ploc->tzid, value, sizeof(ploc->tzid));
 	  }
 	}
 	fclose(f);
@@ -281,31 +304,96 @@ char *pFile;
     }
 
     /* Check if we have environment variables to override that */
-    if ((pValue = getenv("LATITUDE")) != 0)      sscanf(pValue, "%lf", &lat);
-    if ((pValue = getenv("LONGITUDE")) != 0) if (sscanf(pValue, "%lf", &lon)) lon = -lon; /* Longitudes are inverted! */
-    if ((pValue = getenv("CITY")) != 0)        strncpyz(city, pValue, sizeof(city));
+    if ((pValue = getenv("LATITUDE")) != 0)      sscanf(pValue, "%lf", &ploc->lat);
+    if ((pValue = getenv("LONGITUDE")) != 0) if (sscanf(pValue, "%lf", &ploc->lon)) ploc->lon = -ploc->lon; /* Longitudes are inverted! */
+    if ((pValue = getenv("CITY")) != 0)        strncpyz(ploc->city, pValue, sizeof(ploc->city));
     if ((pValue = getenv("REGIONCODE")) != 0)  strncpyz(rc, pValue, sizeof(rc));
     if ((pValue = getenv("COUNTRYCODE")) != 0) strncpyz(cc, pValue, sizeof(cc));
     if ((pValue = getenv("COUNTRYNAME")) != 0) strncpyz(country, pValue, sizeof(country));
-    if ((pValue = getenv("TZABBR")) != 0)      strncpyz(tzs, pValue, sizeof(tzs));
-    if ((pValue = getenv("DSTZABBR")) != 0)    strncpyz(dtzs, pValue, sizeof(dtzs));
+    if ((pValue = getenv("TZABBR")) != 0)      strncpyz(ploc->tzs, pValue, sizeof(ploc->tzs));
+    if ((pValue = getenv("DSTZABBR")) != 0)    strncpyz(ploc->dtzs, pValue, sizeof(ploc->dtzs));
+    if ((pValue = getenv("TIMEZONE")) != 0)    strncpyz(ploc->tzid, pValue, sizeof(ploc->tzid));
+
+    /* If the tz database is available, use it for the location time zone.
+       Else use tz, and the C library DST flag, as before. */
+    if (*ploc->tzid && tzfile_open(ploc->tzid, &ploc->tzf) && today_debug) {
+      printf("Can't load time zone \"%s\". Using the default time zone.\n", ploc->tzid);
+    }
 
     if (!strcasecmp(cc, "US")) {
       if (*rc) {
-	sprintf(city+strlen(city), ", %s, USA", rc);
+	sprintf(ploc->city+strlen(ploc->city), ", %s, USA", rc);
       } else {
-	strcat(city, ", USA");
+	strcat(ploc->city, ", USA");
       }
     } else {
-      if (*country) sprintf(city+strlen(city), ", %s", country);
+      if (*country) sprintf(ploc->city+strlen(ploc->city), ", %s", country);
     }
+    return 0;
+}
+
+/* Free the resources used by a location */
+void location_free(ploc)
+LOCATION *ploc;
+{
+    tzfile_close(&ploc->tzf);
+}
+
+/* Load the location used by the programs. Return 0 if OK.
+   Done only once. Subsequent calls return the result of the first call. */
+int get_location(pFile)
+char *pFile;
+{
+    static int iDone = 0;
+    static int iResult = 0;
+
+    if (iDone) return iResult;
+    iDone = 1;
+
+    TRACE_STAGE(TS_CONFIG, iResult = location_load(pFile, &here));
+    /* Copy it to the global variables used by the programs */
+    today_lat = here.lat;
+    today_lon = here.lon;
+    today_tz = here.tz;
+    strcpy(today_tzs, here.tzs);
+    strcpy(today_dtzs, here.dtzs);
+    strcpy(today_tzid, here.tzid);
+    strcpy(today_city, here.city);
+    return iResult;
+}
+
+/*
+ * Sun events at a location on the local date *pt. NULL = today.
+ * For polar days and nights, only psd->state and psd->noon are set.
+ * Reentrant. Returns 0.
+ */
+int sun_day_at(ploc, pt, psd)
+const LOCATION *ploc;
+struct tm *pt;
+SUNDAY *psd;
+{
+    double ed, jd;
+    double alpha1, delta1, alpha2, delta2, st1r, st1s, st2r, st2s;
+    double a1r, a1s, a2r, a2s, dt, dh, x, y;
+    double trise, tset, ar, as, alpha, delta, tri, da;
+    double lambda1, lambda2;
+    double alt, az, gst, m1;
+    double hsm, ratio;
+    int h, m;
+    int th, tm, ts, yr, mo, day;
+    double tzd;			/* Time zone, corrected for DST */
+    double lat = ploc->lat;
+    struct tm stmNow;
+
+    TRACE(("fn=sun_day_at ploc=%p pt=%p psd=%p", ploc, pt, psd));
 
     if (!pt) {	/* If we were given no date, use now */
 	time_t sec_1970;	/* used by time calls */
 	time(&sec_1970);	/* get system time */
-	pt = localtime(&sec_1970);	/* get ptr to local time struct. Don't use GMT, as it might be another day there. */
+	pt = location_localtime(ploc, sec_1970, &stmNow); /* Don't use GMT, as it might be another day there. */
     }
-    if (debug) printf("pt = {%d, %d, %d, %d, %d, %d, %d};\n", pt->tm_year, pt->tm_mon, pt->tm_mday, pt->tm_hour, pt->tm_min, pt->tm_sec, pt->tm_isdst);
+    TRACE(("fn=sun_day_at tm_year=%d tm_mon=%d tm_mday=%d tm_hour=%d tm_min=%d tm_sec=%d tm_isdst=%d",
+	   pt->tm_year, pt->tm_mon, pt->tm_mday, pt->tm_hour, pt->tm_min, pt->tm_sec, pt->tm_isdst));
 
     th = pt->tm_hour;
     tm = pt->tm_min;
@@ -313,13 +401,10 @@ char *pFile;
     yr = pt->tm_year + 1900;
     mo = pt->tm_mon + 1;
     day = pt->tm_mday;
-    if (pt->tm_isdst) {		/* convert tz to daylight savings time */
-	tz--;
-    }
+    tzd = location_tz_hours(ploc, pt);
 
-    if (debug)
-        printf("Date: %d/%d/%d,  Time: %d:%d:%d, Tz: %d, Lat: %lf, Lon: %lf \n",
-	    mo,day,yr,th,tm,ts,tz,lat,lon);
+    TRACE(("fn=sun_day_at date=%d-%02d-%02d time=%02d:%02d:%02d tz=%g lat=%f lon=%f",
+	   yr, mo, day, th, tm, ts, tzd, lat, ploc->lon));
 
     jd = julian_date(mo,day,yr);
     ed = jd - JDE;
@@ -330,52 +415,51 @@ char *pFile;
     lon_to_eq(lambda1, &alpha1, &delta1);
     lon_to_eq(lambda2, &alpha2, &delta2);
 
-    rise_set(alpha1, delta1, &st1r, &st1s, &a1r, &a1s);
-    rise_set(alpha2, delta2, &st2r, &st2s, &a2r, &a2s);
+    m1 = location_midnight_lst(ploc, pt);
 
-    m1 = adj24(gmst(jd - 0.5, 0.5 + tz / 24.0) - lon / 15); /* lst midnight */
+    TRACE(("fn=sun_day_at midnight_lst=%f", m1));
 
-    if (debug)
-	printf ("local sidereal time of midnight is %lf \n", m1);
+    /* The sun transits when the local sidereal time is its right ascension */
+    alpha = alpha2;
+    if (alpha < alpha1)
+	alpha += 24.0;
+    ratio = adj24(alpha1 - m1) / 24.07;
+    psd->noon = lst_to_h(adj24((1.0 - ratio) * alpha1 + ratio * alpha), jd, tzd, yr, ploc->lon);
 
-    hsm = adj24(st1r - m1);
+    psd->state = rise_set(lat, alpha1, delta1, &st1r, &st1s, &a1r, &a1s);
+    if (psd->state == RS_RISES) psd->state = rise_set(lat, alpha2, delta2, &st2r, &st2s, &a2r, &a2s);
+    if (psd->state != RS_RISES) {
+	TRACE(("fn=sun_day_at state=%d", psd->state));
+	return 0;
+    }
 
-    if (debug)
-	printf ("about %lf hours from midnight to dawn \n", hsm);
+    hsm = adj24(st1r - m1);
 
     ratio = hsm / 24.07;
 
-    if (debug)
-	printf("%lf is how far dawn is into the day \n", ratio);
+    TRACE(("fn=sun_day_at dawn_h=%f dawn_ratio=%f", hsm, ratio));
 
     if (fabs(st2r - st1r) > 1.0) {
 	st2r += 24.0;
-	if (debug)
-	    printf("st2r corrected from %lf to %lf \n", st2r-24.0, st2r);
+	TRACE(("fn=sun_day_at st2r_from=%f st2r=%f", st2r-24.0, st2r));
     }
 
     trise = adj24((1.0 - ratio) * st1r + ratio * st2r);
 
     hsm = adj24(st1s - m1);
 
-    if (debug)
-	printf ("about %lf hours from midnight to sunset \n", hsm);
-
     ratio = hsm / 24.07;
 
-    if (debug)
-	printf("%lf is how far sunset is into the day \n", ratio);
+    TRACE(("fn=sun_day_at sunset_h=%f sunset_ratio=%f", hsm, ratio));
 
     if (fabs(st2s - st1s) > 1.0) {
 	st2s += 24.0;
-	if (debug)
-	    printf("st2s corrected from %lf to %lf \n", st2s-24.0, st2s);
+	TRACE(("fn=sun_day_at st2s_from=%f st2s=%f", st2s-24.0, st2s));
     }
 
     tset = adj24((1.0 - ratio) * st1s + ratio * st2s);
 
-    if (debug)
-	printf("Uncorrected rise = %lf, set = %lf \n", trise, tset);
+    TRACE(("fn=sun_day_at uncorrected_rise=%f uncorrected_set=%f", trise, tset));
 
     ar = a1r * 360.0 / (360.0 + a1r - a2r);
     as = a1s * 360.0 / (360.0 + a1s - a2s);
@@ -388,21 +472,16 @@ char *pFile;
     da = asin_deg(tan_deg(x)/tan_deg(tri));
     dt = 240.0 * y / cos_deg(delta) / 3600;
 
-    if (debug)
-	printf("Corrections: dt = %lf, da = %lf \n", dt, da);
+    TRACE(("fn=sun_day_at dt=%f da=%f", dt, da));
 
-    lst_to_hm(trise - dt, jd, &h, &m);
-    *sunrh = h;
-    *sunrm = m;
+    psd->rise = lst_to_h(trise - dt, jd, tzd, yr, ploc->lon);
 
     if (popt) {
         dh_to_hm(ar - da, &h, &m);
         printf("Azimuth: %3d %02d'\n", h, m);
     }
 
-    lst_to_hm(tset + dt, jd, &h, &m);
-    *sunsh = h;
-    *sunsm = m;
+    psd->set = lst_to_h(tset + dt, jd, tzd, yr, ploc->lon);
 
     if (popt) {
         dh_to_hm(as + da, &h, &m);
@@ -420,7 +499,7 @@ char *pFile;
 	if (alpha > 24.0)
 	    alpha -= 24.0;
 
-	dh = (hms_to_dh(th, tm, ts) + tz) / 24.0;
+	dh = (hms_to_dh(th, tm, ts) + tzd) / 24.0;
 	if (dh > 0.5) {
 	    dh -= 0.5;
 	    jd += 0.5;
@@ -431,7 +510,7 @@ char *pFile;
 
 	gst = gmst(jd, dh);
 
-	eq_to_altaz(alpha, delta, gst, &alt, &az);
+	eq_to_altaz(alpha, delta, gst, lat, ploc->lon, &alt, &az);
 
 	printf	 ("The sun is at:   ");
 	dh_to_hm (az, &h, &m);
@@ -442,6 +521,37 @@ char *pFile;
     return 0;
 }
 
+/*
+ * Sun events at the configured location on the local date *pt. NULL = today.
+ * Returns 0 if OK, or 1 if the location configuration can't be loaded.
+ */
+int sun_day(pt, pFile, psd)
+struct tm *pt;
+char *pFile;
+SUNDAY *psd;
+{
+    if (get_location(pFile)) return 1;
+    return sun_day_at(&here, pt, psd);
+}
+
+int sun(sunrh, sunrm, sunsh, sunsm, pt, pFile)
+int *sunrh, *sunrm, *sunsh, *sunsm;
+struct tm *pt;
+char *pFile;
+{
+    SUNDAY sd;
+
+    if (today_debug) printf("sun(%p, %p, %p, %p, %p);\n",
+      			sunrh, sunrm, sunsh, sunsm, pt);
+
+    if (sun_day(pt, pFile, &sd)) return 1;
+    if (sd.state != RS_RISES)
+	return (sd.state == RS_CIRCUMPOLAR) ? SUN_ALWAYS_UP : SUN_ALWAYS_DOWN;
+    dh_to_hm(sd.rise, sunrh, sunrm);
+    dh_to_hm(sd.set, sunsh, sunsm);
+    return 0;
+}
+
 #if defined(_MSC_VER) && (_MSC_VER < 1400)
 /* The MSVC 1.5 register optimizer chokes on the routine below!
    Microsoft docs report a similar bug for VS 2003 = _MSC_VER 1310 */
@@ -460,10 +570,14 @@ double
 adj360(deg)
 double deg;
 {
-    while (deg < 0.0)
+    while (deg < 0.0) {
 	deg += 360.0;
-    while (deg > 360.0)
+	TRACE_COUNT(TC_RANGE, 1);
+    }
+    while (deg > 360.0) {
 	deg -= 360.0;
+	TRACE_COUNT(TC_RANGE, 1);
+    }
     return(deg);
 }
 
@@ -471,10 +585,14 @@ double
 adj24(hrs)
 double hrs;
 {
-    while (hrs < 0.0)
+    while (hrs < 0.0) {
 	hrs += 24.0;
-    while (hrs > 24.0)
+	TRACE_COUNT(TC_RANGE, 1);
+    }
+    while (hrs > 24.0) {
 	hrs -= 24.0;
+	TRACE_COUNT(TC_RANGE, 1);
+    }
     return(hrs);
 }
 
@@ -498,8 +616,7 @@ julian_date(m, d, y) int m, d, y;
     b += (long)(30.6001 * ((double)m + 1.0));
     jd = (double)d + (double)b + 1720994.5;
 
-    if (debug)
-	printf("Julian date for %d/%d/%d is %lf \n", m, d, y, jd);
+    TRACE(("fn=julian_date m=%d d=%d y=%d jd=%f", m, d, y, jd));
 
     return(jd);
 }
@@ -510,8 +627,7 @@ hms_to_dh(h, m, s) int h, m, s;
     double rv;
     rv = h + m / 60.0 + s / 3600.0;
 
-    if (debug)
-	printf("For time %d:%d:%d frac hours are: %lf \n", h, m, s, rv);
+    TRACE(("fn=hms_to_dh h=%d m=%d s=%d dh=%f", h, m, s, rv));
 
     return rv;
 }
@@ -528,13 +644,14 @@ double ed;
     m = adj360(m);
     m = dtor(m);
     e = m; ect = 0.016718;
-    while ((errt = e - ect * sin(e) - m) > 0.0000001)
+    while ((errt = e - ect * sin(e) - m) > 0.0000001) {
         e = e - errt / (1 - ect * cos(e));
+	TRACE_COUNT(TC_KEPLER, 1);
+    }
     v = 2 * atan(1.0168601 * tan(e/2));
     v = adj360(v * 180.0 / PI + 282.596403);
 
-    if (debug)
-	printf("Solar Longitude for %lf days is %lf \n", ed, v);
+    TRACE(("fn=solar_lon ed=%f lon=%f", ed, v));
 
     return(v);
 }
@@ -610,43 +727,197 @@ double *delta;
     *alpha = atan_q_deg((sin(tlam))*cos(epsilon),cos(tlam)) / 15.0;
     *delta = asin_deg(sin(epsilon)*sin(tlam));
 
-    if (debug)
-	printf("Right ascension, declination for lon %lf is %lf, %lf \n",
-	    lambda, *alpha, *delta);
+    TRACE(("fn=lon_to_eq lon=%f ra=%f decl=%f", lambda, *alpha, *delta));
 }
 
-void rise_set(alpha, delta, lstr, lsts, ar, as)
-double alpha, delta, *lstr, *lsts, *ar, *as;
+int rise_set(lat, alpha, delta, lstr, lsts, ar, as)
+double lat, alpha, delta, *lstr, *lsts, *ar, *as;
 {
-    double tar;
-    double h;
+    int state;
 
-    tar = sin_deg(delta)/cos_deg(lat);
-    if (tar < -1.0 || tar > 1.0) {
-	fprintf(stderr, "The object is circumpolar\n");
-	exit (1);
-    }
-    *ar = acos_deg(tar);
+    rise_set_lat(lat, 1, &alpha, &delta, 0.0, lstr, lsts, ar, &state);
+    if (state != RS_RISES) return state;
     *as = 360.0 - *ar;
 
-    h = acos_deg(-tan_deg(lat) * tan_deg(delta)) / 15.0;
-    *lstr = 24.0 + alpha - h;
-    if (*lstr > 24.0)
-	*lstr -= 24.0;
-    *lsts = alpha + h;
-    if (*lsts > 24.0)
-	*lsts -= 24.0;
-
-    if (debug) {
-	printf("For ra, decl. of %lf, %lf: \n", alpha, delta);
-	printf("lstr = %lf, lsts = %lf, \n", *lstr, *lsts);
-	printf("ar =   %lf, as =   %lf \n", *ar, *as);
+    TRACE(("fn=rise_set ra=%f decl=%f lstr=%f lsts=%f ar=%f as=%f",
+	   alpha, delta, *lstr, *lsts, *ar, *as));
+    return state;
+}
+
+/*
+ * Rise and set of n objects at fixed positions, in a single pass.
+ * alpha[] = Right ascensions, in hours. delta[] = Declinations, in degrees.
+ * h0 = Altitude of the object center at rise and set, in degrees.
+ * Outputs the local sidereal times of rise and set, in hours; the rise
+ * azimuths, in degrees (The set azimuths are 360 - ar); and the states.
+ * For circumpolar objects, the times are those of the lower transit.
+ * For objects that never rise, they're those of the upper transit.
+ */
+void rise_set_n(n, alpha, delta, h0, lstr, lsts, ar, state)
+int n;
+const double *alpha, *delta;
+double h0;
+double *lstr, *lsts, *ar;
+int *state;
+{
+    rise_set_lat(here.lat, n, alpha, delta, h0, lstr, lsts, ar, state);
+}
+
+/* Same as rise_set_n(), at a given latitude */
+static void rise_set_lat(lat, n, alpha, delta, h0, lstr, lsts, ar, state)
+double lat;
+int n;
+const double *alpha, *delta;
+double h0;
+double *lstr, *lsts, *ar;
+int *state;
+{
+    double sinLat = sin_deg(lat);
+    double cosLat = cos_deg(lat);
+    double sinH0 = sin_deg(h0);
+    double cosH0 = cos_deg(h0);
+    int i;
+
+    for (i = 0; i < n; i++) {
+	double sinD = sin_deg(delta[i]);
+	double cosD = cos_deg(delta[i]);
+	double cosH = (sinH0 - sinLat * sinD) / (cosLat * cosD);
+	double cosA = (sinD - sinLat * sinH0) / (cosLat * cosH0);
+	double h;
+
+	state[i] = (cosH < -1.0) ? RS_CIRCUMPOLAR : (cosH > 1.0) ? RS_NEVER_RISES : RS_RISES;
+	if (cosH < -1.0) cosH = -1.0;
+	if (cosH > 1.0) cosH = 1.0;
+	if (cosA < -1.0) cosA = -1.0;
+	if (cosA > 1.0) cosA = 1.0;
+	h = acos(cosH) * 12.0 / PI;
+	lstr[i] = fmod(alpha[i] - h + 24.0, 24.0);
+	lsts[i] = fmod(alpha[i] + h, 24.0);
+	ar[i] = acos(cosA) * 180.0 / PI;
+    }
+}
+
+/* Local sidereal time of the local midnight starting the day *pt, in hours */
+double location_midnight_lst(ploc, pt)
+const LOCATION *ploc;
+struct tm *pt;
+{
+    return adj24(gmst(julian_date(pt->tm_mon + 1, pt->tm_mday, pt->tm_year + 1900) - 0.5,
+		      0.5 + location_tz_hours(ploc, pt) / 24.0) - ploc->lon / 15);
+}
+
+double midnight_lst(pt)
+struct tm *pt;
+{
+    return location_midnight_lst(&here, pt);
+}
+
+/* Location time zone on the local date *pt, corrected for DST, in hours West */
+double location_tz_hours(ploc, pt)
+const LOCATION *ploc;
+struct tm *pt;
+{
+    long offset;
+    int isDst;
+    const char *pszAbbr;
+    time_t t = (time_t)days_from_civil(pt->tm_year + 1900, pt->tm_mon + 1, pt->tm_mday) * 86400 + 43200;
+
+    if (!tzfile_lookup(&ploc->tzf, t, &offset, &isDst, &pszAbbr)) return -offset / 3600.0;
+    return ploc->tz - ((pt->tm_isdst > 0) ? 1 : 0);
+}
+
+double loc_tz_hours(pt)
+struct tm *pt;
+{
+    return location_tz_hours(&here, pt);
+}
+
+/* Location UTC offset on the local date *pt, in seconds East */
+long location_utc_offset(ploc, pt)
+const LOCATION *ploc;
+struct tm *pt;
+{
+    long offset;
+    int isDst;
+    const char *pszAbbr;
+    time_t t = (time_t)days_from_civil(pt->tm_year + 1900, pt->tm_mon + 1, pt->tm_mday) * 86400 + 43200;
+
+    if (!tzfile_lookup(&ploc->tzf, t, &offset, &isDst, &pszAbbr)) return offset;
+    return -3600L * (ploc->tz - ((pt->tm_isdst > 0) ? 1 : 0));
+}
+
+long loc_utc_offset(pt)
+struct tm *pt;
+{
+    return location_utc_offset(&here, pt);
+}
+
+/* Name of a sun() result, for the machine-readable outputs */
+char *sun_status(iErr)
+int iErr;
+{
+    switch (iErr) {
+	case 0: return "ok";
+	case SUN_ALWAYS_UP: return "polar_day";
+	case SUN_ALWAYS_DOWN: return "polar_night";
+	default: return "error";
+    }
+}
+
+/* Location time zone abbreviation on the local date *pt */
+const char *location_tz_abbr(ploc, pt)
+const LOCATION *ploc;
+struct tm *pt;
+{
+    long offset;
+    int isDst;
+    const char *pszAbbr;
+    time_t t = (time_t)days_from_civil(pt->tm_year + 1900, pt->tm_mon + 1, pt->tm_mday) * 86400 + 43200;
+
+    if (!tzfile_lookup(&ploc->tzf, t, &offset, &isDst, &pszAbbr)) return pszAbbr;
+    return (pt->tm_isdst > 0) ? ploc->dtzs : ploc->tzs;
+}
+
+char *loc_tz_abbr(pt)
+struct tm *pt;
+{
+    return (char *)location_tz_abbr(&here, pt);
+}
+
+/* Location local time at a given time */
+struct tm *location_localtime(ploc, t, ptm)
+const LOCATION *ploc;
+time_t t;
+struct tm *ptm;
+{
+    long offset;
+    int isDst;
+    const char *pszAbbr;
+
+    if (!tzfile_lookup(&ploc->tzf, t, &offset, &isDst, &pszAbbr)) {
+	utc_to_tm(t, offset, isDst, ptm);
+    } else {
+#ifdef __unix__
+	localtime_r(&t, ptm);	/* The C library localtime() is not reentrant */
+#else
+	*ptm = *localtime(&t);	/* MSVC's uses a per-thread buffer */
+#endif
     }
+    return ptm;
 }
 
-void lst_to_hm(lst, jd, h, m)
+struct tm *loc_localtime(t, ptm)
+time_t t;
+struct tm *ptm;
+{
+    return location_localtime(&here, t, ptm);
+}
+
+double lst_to_h(lst, jd, tzd, yr, lon)
 double lst, jd;
-int *h, *m;
+double tzd;
+int yr;
+double lon;
 {
     double ed, gst, jzjd, t, r, b, t0, gmt;
 
@@ -664,10 +935,12 @@ int *h, *m;
     gmt = gst-t0;
     if (gmt<0)
 	gmt += 24.0;
-    gmt = gmt * 0.99727 - tz;;
+    gmt = gmt * 0.99727 - tzd;
     if (gmt < 0)
 	gmt +=24.0;
-    dh_to_hm(gmt, h, m);
+    if (gmt >= 24.0)
+	gmt -= 24.0;
+    return gmt;
 }
 
 void dh_to_hm(dh, h, m)
@@ -690,8 +963,9 @@ int *h, *m;
     }
 }
 
-void eq_to_altaz(r, d, t, alt, az)
+void eq_to_altaz(r, d, t, lat, lon, alt, az)
 double r, d, t;
+double lat, lon;
 double *alt, *az;
 {
     double p = 3.14159265;
@@ -700,8 +974,7 @@ double *alt, *az;
     double l = (360 - lon) * r1;
     double t5, s1, c1, c2, s2, a, h;
 
-    if (debug)
-	printf("Given R. A. = %lf, DECL. = %lf, gmt = %lf \n", r, d, t);
+    TRACE(("fn=eq_to_altaz ra=%f decl=%f gst=%f", r, d, t));
 
     r = r * 15.0 * r1;
     d = d * r1;
@@ -729,8 +1002,7 @@ double *alt, *az;
     *alt = h / r1;
     *az = a / r1;
 
-    if (debug)
-	printf("alt = %lf, az = %lf \n",*alt,*az);
+    TRACE(("fn=eq_to_altaz alt=%f az=%f", *alt, *az));
 }
 
 double
@@ -756,8 +1028,7 @@ double j,f;
     if (s > 24.0)
 	s -= 24.0;
 
-    if (debug)
-	printf("For jd = %lf, f = %lf, gst = %lf \n", j, f, s);
+    TRACE(("fn=gmst jd=%f f=%f gst=%f", j, f, s));
 
     return(s);
 }
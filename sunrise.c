@@ -19,9 +19,14 @@
 **                  Added option -c to set the config file name.
 **   2019-11-17 JFL Added system & user config files, and environment variables.
 **   2019-11-18 JFL Use the new versions.h instead of include/debugm.h.
+**   2026-10-19 JFL Use the configured TIMEZONE, if any, for the local date and the
+**		    time zone abbreviation.
+**		    Accept ISO 8601 date ranges and repeats, displaying one line per date.
+**		    Added option --format, for JSON Lines or CSV output.
+**		    Rename main() and usage() when built into todaybox.
 */
 
-#define VERSION "2022-06-21"
+#define VERSION "2026-10-19"
 
 #include <stdio.h>
 #include <string.h>
@@ -30,12 +35,20 @@
 #include "today.h"
 #include "versions.h"
 
+#ifdef MULTICALL		/* Linked into the todaybox multi-call program */
+#define main sunrise_main
+#define usage sunrise_usage
+#endif
+
 #define streq(s1, s2) (!strcmp(s1, s2))
 
 #define FALSE 0
 #define TRUE 1
 
-int debug = 0;
+/* Fields of the --format records */
+static const char * const fields[] = {
+  "date", "sunrise", "sunrise_min", "tz", "status", "city", NULL
+};
 
 void usage() {
   char namebuf[256];
@@ -59,10 +72,12 @@ Options:\n\
   +N[:M]            Display time N hours and M minutes after sunrise\n\
   -c PATHNAME       Configuration file name. Default: See below\n\
   -f|--full         Display the full date/time in the canonic ISO 8601 format\n\
+  --format=FORMAT   Output one record per date. FORMAT = jsonl or csv\n\
   -v|--verbose      Display the full date/time and location information\n\
   -V|--version      Display the program version\n\
 \n\
 Date: YYYY-MM-DD or YYYY-DDD, with - optional, default: today\n\
+      Or a range, like 2025-01-01/2025-12-31, R/2025-01-01/P1W, or 2025-W10\n\
 \n\
 Configuration file: This program has built-in settings for %s.\n\
 This can be overridden by creating a configuration file w. these definitions:\n\
@@ -71,6 +86,7 @@ LONGITUDE = -122.407498             # Longitude. +=East. Required.\n\
 CITY = San Francisco                # City name. Required.\n\
 TZABBR = PST                        # Time Zone Abbreviation. Required.\n\
 DSTZABBR = PDT                      # TZ DST Abbreviation. Required if exists.\n\
+TIMEZONE = America/Los_Angeles      # Time zone ID in the tz database. Optional.\n\
 COUNTRYCODE = US                    # Two-letter country code. Optional.\n\
 COUNTRYNAME = United States         # Country name. Optional.\n\
 REGIONCODE = CA                     # Region or state code. Optional.\n\
@@ -82,7 +98,7 @@ All the above can be overridden with environment variables with the same names.\
 #ifdef __unix__
 "\n"
 #endif
-, city, pName);
+, today_city, pName);
 }
 
 int main(int argc, char *argv[]) {
@@ -91,10 +107,14 @@ int main(int argc, char *argv[]) {
   int nHours = 0, nMinutes = 0;
   struct tm stm;
   struct tm *ptm = NULL;
+  DATERANGE dr;
+  int iRange = FALSE;
   int iErr;
   int iFull = FALSE;
   int iVerbose = FALSE;
   char *pszCfgFile = NULL;
+  int iFormat = FMT_TEXT;
+  RECORD rec;
 
   for (i=1; i<argc; i++) {
     char *arg = argv[i];
@@ -115,7 +135,7 @@ int main(int argc, char *argv[]) {
     }
     if (   streq(arg, "-d")	/* -d = Debug mode */
         || streq(arg, "--debug")) {
-      debug = 1;
+      today_debug = 1;
       continue;
     }
     if (   streq(arg, "-f")	/* -f = Full date/time mode */
@@ -123,6 +143,16 @@ int main(int argc, char *argv[]) {
       iFull = 1;
       continue;
     }
+    if (   (streq(arg, "--format") && ((i+1)<argc)) /* --format = Output format */
+        || !strncmp(arg, "--format=", 9)) {
+      char *pszFormat = arg[8] ? arg+9 : argv[++i];
+      iFormat = record_format(pszFormat);
+      if (iFormat < 0) {
+	fprintf(stderr, "Error: Unsupported format: %s\n", pszFormat);
+	return 1;
+      }
+      continue;
+    }
     if (   streq(arg, "-v")	/* -v = Verbose mode */
         || streq(arg, "--verbose")) {
       iFull = 1;
@@ -144,63 +174,97 @@ int main(int argc, char *argv[]) {
     if ((arg[0] == '+') && (sscanf(arg+1, "%d:%d", &nHours, &nMinutes))) {
       continue;
     }
-    /* Try parsing another date/time */
-    iErr = parsetime(arg, &stm);
+    /* Try parsing another date/time, or a range of dates */
+    iErr = daterange_parse(arg, &dr);
     if (!iErr) {
-      ptm = &stm;
+      iRange = TRUE;
+      if (dr.nCount != 1) iFull = TRUE; /* Display which date each time is for */
       continue;
     }
     fprintf(stderr, "Error: Invalid argument: '%s'\n", arg);
     return 1;
   }
 
-  iErr = sun(&sunrh, &sunrm, &sunsh, &sunsm, ptm, pszCfgFile);
-  if (iErr) return 1;
-
-  sunrm += nMinutes;
-  if (sunrm < 0) {
-    sunrm += 60;
-    sunrh -= 1;
-  } else if (sunrm >= 60) {
-    sunrm -= 60;
-    sunrh += 1;
-  }
-  sunrh += nHours;
-  
-  if (iFull || iVerbose) {
-    if (iVerbose) printf("Sunrise in %s, on ", city);
-    if (!ptm) {
-      time_t now;
-      time(&now);			/* get system time */
-      ptm = localtime(&now);		/* get ptr to gmt time struct */
-    }
-    printf("%04d-%02d-%02d", ptm->tm_year+1900, ptm->tm_mon+1, ptm->tm_mday);
-    if (iVerbose) printf(", is at");
-    printf(" ");
+  if (iFormat) {
+    record_init(&rec, iFormat, fields);
+    fwrite(rec.szBuf, 1, record_header(&rec), stdout);
   }
 
-  printf("%02d:%02d", sunrh, sunrm);
-
-  if (iVerbose) {
-    /* In Linux, strftime() displays the timezone abbreviation as I wanted.
-       But in Windows, it displays the full time zone name from
-       HKEY_LOCAL_MACHINE\SYSTEM\CurrentControlSet\Control\TimeZoneInformation\TimeZoneKeyName
-       If needed, see:
-       HKEY_LOCAL_MACHINE\SOFTWARE\Microsoft\Windows NT\CurrentVersion\Time Zones
-       https://github.com/unicode-org/cldr/blob/master/common/supplemental/windowsZones.xml
-    char tzName[32] = "";
-    strftime(tzName, sizeof(tzName), "%Z", ptm);
-    printf(" %s", tzName);
-    */
-    /* So instead, use the configured values */
-    printf(" %s", ptm->tm_isdst ? dtzs : tzs); /* See today.h */
-    /* TODO: The above time zone is wrong when using a configuration file
-       for another location, as the above time is in local time always.
-       So either fix the time to be in the configured time zone,
-       or fix the TZ string to show the local TZ */
-  }
+  do {
+    if (iRange) {
+      if (!daterange_next(&dr, &stm)) break;
+      ptm = &stm;
+    }
+    iErr = sun(&sunrh, &sunrm, &sunsh, &sunsm, ptm, pszCfgFile);
+    if ((iErr == 1) || (iErr && !iFormat)) {
+      if (iErr > 1) fprintf(stderr, "Error: The sun does not %s that day\n", (iErr == SUN_ALWAYS_UP) ? "set" : "rise");
+      return 1;
+    }
+
+    sunrm += nMinutes;
+    if (sunrm < 0) {
+      sunrm += 60;
+      sunrh -= 1;
+    } else if (sunrm >= 60) {
+      sunrm -= 60;
+      sunrh += 1;
+    }
+    sunrh += nHours;
+
+    if (iFormat) {		/* Machine-readable output */
+      if (!ptm) {
+        time_t now;
+        time(&now);			/* get system time */
+        ptm = loc_localtime(now, &stm);	/* Local time at the configured location */
+      }
+      record_begin(&rec);
+      record_date(&rec, ptm->tm_year+1900, ptm->tm_mon+1, ptm->tm_mday);
+      if (iErr) {
+        record_null(&rec);
+        record_null(&rec);
+      } else {
+        record_time(&rec, ptm->tm_year+1900, ptm->tm_mon+1, ptm->tm_mday,
+		    (sunrh * 60L + sunrm) * 60, loc_utc_offset(ptm));
+        record_int(&rec, sunrh * 60L + sunrm);
+      }
+      record_str(&rec, loc_tz_abbr(ptm));
+      record_str(&rec, sun_status(iErr));
+      record_str(&rec, today_city);
+      fwrite(rec.szBuf, 1, record_end(&rec), stdout);
+      continue;
+    }
+
+    if (iFull || iVerbose) {
+      if (iVerbose) printf("Sunrise in %s, on ", today_city);
+      if (!ptm) {
+        time_t now;
+        time(&now);			/* get system time */
+        ptm = loc_localtime(now, &stm);	/* Local time at the configured location */
+      }
+      printf("%04d-%02d-%02d", ptm->tm_year+1900, ptm->tm_mon+1, ptm->tm_mday);
+      if (iVerbose) printf(", is at");
+      printf(" ");
+    }
+
+    printf("%02d:%02d", sunrh, sunrm);
+
+    if (iVerbose) {
+      /* In Linux, strftime() displays the timezone abbreviation as I wanted.
+         But in Windows, it displays the full time zone name from
+         HKEY_LOCAL_MACHINE\SYSTEM\CurrentControlSet\Control\TimeZoneInformation\TimeZoneKeyName
+         If needed, see:
+         HKEY_LOCAL_MACHINE\SOFTWARE\Microsoft\Windows NT\CurrentVersion\Time Zones
+         https://github.com/unicode-org/cldr/blob/master/common/supplemental/windowsZones.xml
+      char tzName[32] = "";
+      strftime(tzName, sizeof(tzName), "%Z", ptm);
+      printf(" %s", tzName);
+      */
+      /* So instead, use the configured values */
+      printf(" %s", loc_tz_abbr(ptm)); /* See today.h */
+    }
   
-  printf("\n");
+    printf("\n");
+  } while (iRange);
   
   return 0;
 }
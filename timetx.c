@@ -16,6 +16,12 @@
  * Timetxt converts the time to a null-trailed string.  It returns a pointer
  * to the first free byte (i.e. the null);
  *
+ *      int     timetxt_n(buffer, size, hour, minute, second, daylight);
+ *      size_t  size;           -- Output buffer size
+ *
+ * Same, writing at most size bytes, including the null. Returns the length
+ * of the full text, like snprintf().
+ *
  * The output follows the syntax of Robert J. Lurtsema, and includes:
  *
  *      In twenty-five seconds, the time will be ten minutes before noon.
@@ -23,19 +29,31 @@
  *
  * External routines called:
  *
- *      nbrtxt          (Number to ascii conversion)
- *      copyst          (String copy routine)
+ *      nbradd          (Number to ascii conversion)
+ *      txtadd          (Bounded string copy routine)
+ *
+ * History:
+ *   2026-10-19 JFL Added timetxt_n(), assembling the text with bounded
+ *		    copies of precomputed strings.
+ *		    Never output two consecutive spaces. today's output()
+ *		    removed them, but not the libtoday and todayd outputs.
  */
 
+#include <string.h>
+
 #include "params.h"
 #include "today.h"
 
 /* Forward references to local routines */
 /* char *timetxt(char *buffer, int hour, int minute, int second, int daylight); // Defined in today.h */
-char *stuff(char *buffer, int value, int flag, char *leading, char *trailing);
+static size_t stuff(char *buffer, size_t size, size_t len, int value, int flag, char *leading, char *trailing);
 
-char *timetxt(buffer, hour, minute, second, daylight)
+/* Append a string literal */
+#define ADDLIT(s) len = TXTADD(buffer, size, len, s, sizeof(s) - 1)
+
+int timetxt_n(buffer, size, hour, minute, second, daylight)
 char    *buffer;                        /* Output buffer                */
+size_t  size;                           /* Output buffer size           */
 int     hour;                           /* Hours 00 - 23                */
 int     minute;                         /* Minutes                      */
 int     second;                         /* Seconds                      */
@@ -44,21 +62,21 @@ int     daylight;                       /* Non-zero if savings time     */
  * Output time of day.
  */
 {
-	char            *op;            /* Output pointer               */
+	size_t          len = 0;        /* Output length                */
 	register int    late = 0;       /* after hour or afternoon      */
 	register int	sec = 0;	/* Seconds temp			*/
 
-	op = buffer;                    /* Setup buffer pointer         */
 	if (hour < 0) {			/* If it's a dummy call,	*/
-		*op = 0;		/* Return a null string		*/
-		return(op);
+		if (size) *buffer = 0;	/* Return a null string		*/
+		return(0);
 	}
 	if (daylight == 0101010) {      /* Secret flag                  */
-		op = copyst(op, "The big hand is on the ");
-		op = nbrtxt(op, (((minute + 2 + second/30)/5 + 11)%12)+1, 0);
-		op = copyst(op," and the little hand is on the ");
-		op = nbrtxt(op, ((hour + 11) % 12) + 1, 0);
-		return(copyst(op, ".  "));
+		ADDLIT("The big hand is on the ");
+		len = nbradd(buffer, size, len, (((minute + 2 + second/30)/5 + 11)%12)+1, 0);
+		ADDLIT(" and the little hand is on the ");
+		len = nbradd(buffer, size, len, ((hour + 11) % 12) + 1, 0);
+		ADDLIT(".  ");
+		return((int)len);
 	}
 	/*
 	 * Check if the time is more than 30 minutes past the hour.
@@ -87,54 +105,80 @@ int     daylight;                       /* Non-zero if savings time     */
 	 *	  59	  59	In one second, the time will be noon
 	 */
 	if (late > 0 && second > 0) {
-		op = stuff(op, second, 1, "In ", " second");
-		op = copyst(op, ", the time will be ");
+		len = stuff(buffer, size, len, second, 1, "In ", " second");
+		ADDLIT(", the time will be");
 		sec = -2;		/* We've done seconds already	*/
 	}
 	else if (daylight != -1) {
-		op = copyst(op, "The time is ");
+		ADDLIT("The time is");
 		sec = second;		/* Seconds still to be done	*/
 	}
+	/*
+	 * Each part below begins with its separating space, so that the
+	 * text never has two consecutive spaces.
+	 */
 	if (sec == 0) {
-		op = copyst(op, "exactly ");
+		if (len) ADDLIT(" ");
+		ADDLIT("exactly");
 		if (minute == 30)
-			op = copyst(op, "half past ");
-		else	op = stuff(op, minute, 1, " ", " minute");
+			ADDLIT(" half past");
+		else	len = stuff(buffer, size, len, minute, 1, " ", " minute");
 	}
 	else {				/* Non exact or missing seconds	*/
-		op = stuff(op, minute, 0, " ",     " minute");
+		len = stuff(buffer, size, len, minute, 1, " ",     " minute");
 		if(second > 0)
-	        op = stuff(op, sec, (sec > 0),  " and ", " second");
+	        len = stuff(buffer, size, len, sec, (sec > 0),  " and ", " second");
 	}
-	op = copyst(op, (minute < 0 || (minute == 0 && late)
+	if (minute < 0 || (minute == 0 && late)
 			|| (second == 0
 				&& ((minute == 0 && late == 0)
-					|| minute == 30))) ? " "
-		: (late) ? " before " : " after ");
+					|| minute == 30)))
+		ADDLIT(" ");
+	else if (late)
+		ADDLIT(" before ");
+	else	ADDLIT(" after ");
 	/*
 	 * Hours are not quite so bad
 	 */
 	if (hour == 0 || hour == 24)
-		op = copyst(op, "midnight");
+		ADDLIT("midnight");
 	else if (hour == 12)
-		op = copyst(op, "noon");
+		ADDLIT("noon");
 	else {
 	  	late = (hour > 12);
 		if (late) hour = hour - 12;
-		op = nbrtxt(op, hour, 0);
-		op = copyst(op, (late) ? " PM" : " AM");
+		len = nbradd(buffer, size, len, hour, 0);
+		if (late) ADDLIT(" PM");
+		else	  ADDLIT(" AM");
 	}
 	if (daylight != -1) {
-	    op = copyst(op, " (");
-	    op = copyst(op, (daylight) ? dtzs : tzs); /* See today.h */
-	    op = copyst(op, ")");
+	    char *tzname = (daylight) ? today_dtzs : today_tzs; /* See today.h */
+	    ADDLIT(" (");
+	    len = txtadd(buffer, size, len, tzname, strlen(tzname));
+	    ADDLIT(")");
 	}
-	return(op);
+	if (!len && size) *buffer = 0;	/* Nothing output */
+	return((int)len);
+}
+
+char *timetxt(buffer, hour, minute, second, daylight)
+char    *buffer;                        /* Output buffer                */
+int     hour;                           /* Hours 00 - 23                */
+int     minute;                         /* Minutes                      */
+int     second;                         /* Seconds                      */
+int     daylight;                       /* Non-zero if savings time     */
+/*
+ * Same as timetxt_n(), for a buffer assumed to be large enough.
+ */
+{
+	return(buffer + timetxt_n(buffer, TXT_UNBOUNDED, hour, minute, second, daylight));
 }
 
-char *
-stuff(buffer, value, flag, leading, trailing)
+static size_t
+stuff(buffer, size, len, value, flag, leading, trailing)
 char    *buffer;                        /* Output goes here             */
+size_t  size;                           /* Output buffer size           */
+size_t  len;                            /* Output length so far         */
 int     value;                          /* The value to print if > 0    */
 int     flag;                           /* flag is set to print leading */
 char    *leading;                       /* preceeded by ...             */
@@ -145,17 +189,14 @@ char    *trailing;                      /* and followed by ...          */
  * If value is not one, output an "s", too.
  */
 {
-	register char   *op;            /* Output pointer               */
-
-	op = buffer;                    /* Setup buffer pointer         */
 	if (value > 0) {
 		if (flag)
-			op = copyst(op, leading);
-		op = nbrtxt(op, value, 0);
-		op = copyst(op, trailing);
+			len = txtadd(buffer, size, len, leading, strlen(leading));
+		len = nbradd(buffer, size, len, value, 0);
+		len = txtadd(buffer, size, len, trailing, strlen(trailing));
 		if (value != 1)
-			op = copyst(op, "s");
+			ADDLIT("s");
 	}
-	return(op);
+	return(len);
 }
 
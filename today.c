@@ -27,9 +27,39 @@
  *                  Added option -c to set the config file name.
  *   2019-11-17 JFL Added system & user config files, and environment variables.
  *   2019-11-18 JFL Use the new versions.h instead of include/debugm.h.
+ *   2026-10-18 JFL Added option --precise to use the ELP-2000/82 moon engine.
+ *		    Added option --seasons to list the equinoxes and solstices.
+ *   2026-10-19 JFL Added options --dark, --max-illum, and --format, to list
+ *		    the astronomical darkness windows.
+ *		    Option -a also prints the planets rise and set times.
+ *		    Use the configured TIMEZONE, if any, for the current time.
+ *		    Accept ISO 8601 date ranges and repeats, processing every date.
+ *		    Rewrote output() to copy whole words into a large output
+ *		    buffer, written with fwrite(). Words of any length are
+ *		    supported. Option -w 0 now disables the word wrapping.
+ *		    When built with OpenMP, -x processes files and pipes in
+ *		    parallel, in chunks of lines output in the input order.
+ *		    Use the bounded datetxt_n(), timetxt_n(), and nbradd().
+ *		    Option --format=jsonl|csv outputs one record per date.
+ *		    Report polar days and nights, instead of exiting.
+ *		    Option --format=bin outputs binary day rows.
+ *		    Added option --ics, to output an iCalendar feed.
+ *		    Added option --serve-stdio, to answer JSON requests.
+ *		    Rename main() and usage() when built into todaybox.
+ *		    Query the screen width only when wrapping text.
+ *		    Added option --stats, to output the counters and stage
+ *		    times at exit, in the builds with tracing compiled in.
+ *		    Option -a prints the planets only from 1800 to 2050, where
+ *		    their positions are valid.
+ *		    Reject option --format=json without --dark.
+ *		    Write "one degree", not "one degrees", for the planets.
+ *		    Option --stats fails in the builds without tracing.
+ *		    The --dark records have local times with their UTC offset.
+ *		    Check the parsed --dark option for --format=json.
+ *		    Option --serve-stdio echoes the numeric request ids as is.
  */
 
-#define VERSION "2022-06-21"
+#define VERSION "2026-10-19"
 
 /*)BUILD	$(PROGRAM)	= today
 		$(FILES)	= { today datetx timetx nbrtxt moontx }
@@ -91,16 +121,43 @@ bugs
 int	__narg	=	1;		/* No prompt if no args		*/
 #define LINEWIDTH       72              /* Width of line                */
 #define MAXLINEWIDTH    256             /* Width of line                */
+#define OUTBUFSIZE      65536           /* Size of the output buffer    */
 
 #include <stdio.h>
 #include <time.h>
 #include <ctype.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
+
+#if defined(_MSDOS) || defined(_WIN32)	/* For reading stdin in blocks */
+#include <io.h>
+#define read _read
+#define isatty _isatty
+#else
+#include <unistd.h>
+#endif
+#ifdef _OPENMP			/* For reading stdin in the parallel mode */
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+#endif
+#if defined(_MSDOS) || defined(_WIN32)	/* For the binary output */
+#include <io.h>
+#include <fcntl.h>
+#endif
 
 #include "today.h"
+#include "libtoday.h"
 #include "versions.h"
 
+#ifdef MULTICALL		/* Linked into the todaybox multi-call program */
+#define main today_main
+#define usage today_usage
+#endif
+
 #include "screensize.c" /* Define the OS-specific function GetScreenColumns() */
 
 #define streq(s1, s2) (!strcmp(s1, s2))
@@ -115,26 +172,61 @@ int	__narg	=	1;		/* No prompt if no args		*/
 int     ccpos;                          /* Current line position        */
 char    lastbyte;                       /* Memory for output()          */
 char    line[100];                      /* Data line for input function */
-char    wordbuffer[MAXLINEWIDTH];       /* Buffer for output function   */
-char    *wordptr = wordbuffer;          /* Free byte in wordbuffer      */
-char	linebuffer[MAXLINEWIDTH+2];	/* Output text buffer		*/
-char	*lineptr = linebuffer;		/* Free byte in linebuffer	*/
+char    *wordbuffer = NULL;         	/* Word continued across output() calls */
+size_t  wordlen = 0;			/* Length of that partial word	*/
+size_t  wordsize = 0;			/* Size of the wordbuffer	*/
+char	outbuf[OUTBUFSIZE];		/* Output text buffer		*/
+size_t	outlen = 0;			/* Bytes used in outbuf		*/
+typedef struct {			/* Growable buffer for one output chunk */
+  char *pBuf;
+  size_t nLen;
+  size_t nSize;
+} OUTCHUNK;
+OUTCHUNK *pCapture = NULL;		/* If set, output goes there	*/
 int     polish;                         /* Funny mode flag              */
 int	sunrise;			/* Sunrise print flag		*/
 int	moon;				/* Sunrise print flag		*/
+int	planets;			/* Planets print flag		*/
 int	quiet;				/* Quiet mode flag		*/
-int     lineWidth = LINEWIDTH;		/* Output width			*/
+int     lineWidth = -1;			/* Output width. -1 = Screen width, queried when needed */
 static	char    outline[500];		/* Output buffer                */
-int     debug = 0;
 static  char *pszCfgFile = NULL;
+static  char *pszFormat = NULL;	/* --format: Output format for lists */
+static  int iFormat = FMT_TEXT;	/* --format: Output format for dates */
+#define FMT_JSON	4	/* A JSON array. Only for --dark */
+static  int iHeader = 0;	/* 1 = The CSV header has been output */
+static  const char * const fields[] = {	/* Fields of the --format records */
+  "date", "time", "sunrise", "sunset", "sunrise_min", "sunset_min", "tz",
+  "status", "city", "illumination", "waxing", "phase", NULL
+};
+static  double maxIllum = 0.0;	/* --max-illum: Ignore the moon below that % */
+#ifdef _OPENMP			/* The output state of each thread */
+#pragma omp threadprivate(ccpos, wordbuffer, wordlen, wordsize, pCapture, outline)
+#endif
 
 /* Forward references to local routines */
 void dotime(void);
 int dotexttime(char *text);
 void process(struct tm *ptm);
+static void out_record(struct tm *ptm);
+static void out_header(void);
 void output(char *text);
-void put(register char c);
+void out_flush(void);
+static void out_write(const char *p, size_t n);
 int getLine(void);
+static void init_line_width(void);
+#ifdef _OPENMP
+int doparallel(void);
+#endif
+int doseasons(int yFrom, int yTo);
+int dodark(char *pszFrom, char *pszTo);
+int doics(char *pszFrom, char *pszTo);
+int doserve(void);
+static int json_no_dark(void);
+#ifdef TRACING
+static int iStats = 0;		/* --stats: Output the statistics at exit */
+static void dump_stats(void);
+#endif
 
 
 void usage() {
@@ -155,11 +247,28 @@ Usage: today [OPTIONS] [DATE [...]]\n\
 \n\
 Options:\n\
   -?|-h|--help          Display this help screen\n\
-  -a                    Print all details. Implies -m and -s\n\
+  -a                    Print all details. Implies -m and -s, and the planets\n\
+                        (For the years 1800 to 2050)\n\
   -c PATHNAME           Configuration file name. Default: See below\n\
+  --dark FROM TO        List the astronomical darkness windows for the nights\n\
+                        starting on dates FROM to TO\n\
+  --format=jsonl|csv    Output one record per date, or per night with --dark.\n\
+                        With --dark, json is also supported. Default: Text\n\
+  --format=bin          Output binary day rows, with fixed-width columns\n\
+  --ics FROM TO         Output an iCalendar feed with the sunrise, sunset, and\n\
+                        moon phases events for the dates FROM to TO\n\
   -m                    Also print the moon phase\n\
+  --max-illum PCT       With --dark, ignore the moon if illuminated < PCT %%\n\
   -p|p|P                Polish joke mode\n\
+  --precise             Use the more accurate ELP-2000/82 moon phase engine\n\
   -q                    Quiet mode. Print just the bare date\n\
+  --seasons FROM TO     List the equinoxes and solstices for years FROM to TO\n\
+  --serve-stdio         Answer JSON requests read from stdin, one per line.\n\
+                        Ex: {\"id\":1,\"date\":\"2026-06-21\",\"outputs\":[\"sun\",\"text\"]}\n\
+                        Optional: \"lat\", \"lon\" (+=East), \"tz\", and \"city\"\n\
+                        Outputs: sun, moon, text. Default: sun and moon\n\
+  --stats               Output the counters and stage times to stderr at exit.\n\
+                        Needs a build with tracing. Ex: make TRACE=1\n\
   -v|-s|s|S             Also print sunrise and sunset\n\
   -V                    Display the program version\n\
   -w WIDTH              Set the line width. 0=unlimited. Default=Screen width\n\
@@ -168,6 +277,9 @@ Options:\n\
 Date:                   Prints the day, and optional time, in plain English.\n\
   YYYY-MM-DD[THH:MM:SS] ISO format. Ex: 2018-12-25T23:59 or \"2018-12-25 23h59m\"\n\
                         The date can also be formatted as YYYY-DDD\n\
+  START/END             ISO 8601 range of dates, processed in turn. Also\n\
+                        START/PERIOD, R[N]/START/PERIOD, or YYYY-Www weeks.\n\
+                        Ex: 2025-01-01/2025-12-31, R/2025-01-01/P1W, 2025-W10\n\
   [+CC]YYMMDD[HHMMSS]   Compacted ISO format.\n\
 \n\
 Default: Print date & time, today's sunrise & sunset, followed by a cookie.\n\
@@ -179,6 +291,7 @@ LONGITUDE = -122.407498             # Longitude. +=East. Required.\n\
 CITY = San Francisco                # City name. Required.\n\
 TZABBR = PST                        # Time Zone Abbreviation. Required.\n\
 DSTZABBR = PDT                      # TZ DST Abbreviation. Required if exists.\n\
+TIMEZONE = America/Los_Angeles      # Time zone ID in the tz database. Optional.\n\
 COUNTRYCODE = US                    # Two-letter country code. Optional.\n\
 COUNTRYNAME = United States         # Country name. Optional.\n\
 REGIONCODE = CA                     # Region or state code. Optional.\n\
@@ -190,7 +303,7 @@ All the above can be overridden with environment variables with the same names.\
 #ifdef __unix__
 "\n"
 #endif
-, city, pName);
+, today_city, pName);
 
 }
 
@@ -204,14 +317,16 @@ char    *argv[];
 {
   int i;
   int done = 0;
+  char *pszDarkFrom = NULL;
+  char *pszIcsFrom = NULL;
+  char *pszIcsTo = NULL;
+  char *pszDarkTo = NULL;
 
   ccpos = 0;                    /* New line now                 */
-  wordptr = wordbuffer;         /* Nothing buffered             */
-  lineptr = linebuffer;		/* Nothing in output buffer too	*/
+  wordlen = 0;                  /* Nothing buffered             */
+  outlen = 0;			/* Nothing in output buffer too	*/
   polish = 0;			/* Normal mode			*/
 
-  lineWidth = GetScreenColumns() - 1;
-  if (lineWidth > MAXLINEWIDTH) lineWidth = MAXLINEWIDTH;
   sunrise = 0;
 
   for (i=1; i<argc; i++) {
@@ -235,20 +350,66 @@ char    *argv[];
       if (cOpt == 'a') {	/* -a = Display all available information */
 	sunrise = 1;
 	moon = 1;
+	planets = 1;
 	continue;
       }
       if ((cOpt == 'c') && ((i+1)<argc)) {	/* -c = Config file name */
 	pszCfgFile = argv[++i];
 	continue;
       }
+      if (streq(opt, "-dark") && ((i+2)<argc)) { /* --dark = List darkness windows */
+	pszDarkFrom = argv[++i];
+	pszDarkTo = argv[++i];
+	continue;
+      }
       if (cOpt == 'd') {	/* -d = Debug mode */
-	debug = 1;
+	today_debug = 1;
+	continue;
+      }
+      if (   (streq(opt, "-format") && ((i+1)<argc)) /* --format = Output format */
+	  || !strncmp(opt, "-format=", 8)) {
+	pszFormat = opt[7] ? opt+8 : argv[++i];
+	iFormat = streq(pszFormat, "json") ? FMT_JSON
+		: streq(pszFormat, "bin") ? FMT_BIN : record_format(pszFormat);
+	if (iFormat < 0) {
+	  fprintf(stderr, "Error: Unsupported format: %s\n", pszFormat);
+	  return 1;
+	}
+	continue;
+      }
+      if (streq(opt, "-ics") && ((i+2)<argc)) { /* --ics = iCalendar feed */
+	pszIcsFrom = argv[++i];
+	pszIcsTo = argv[++i];
+	continue;
+      }
+      if (streq(opt, "-max-illum") && ((i+1)<argc)) { /* --max-illum = Moon threshold */
+	maxIllum = atof(argv[++i]);
 	continue;
       }
       if (cOpt == 'm') {	/* -m = Display moon phase */
 	moon = 1;
 	continue;
       }
+      if (streq(opt, "-precise")) {	/* --precise = Use the ELP moon engine */
+	today_potm = potm_elp;
+	continue;
+      }
+      if (streq(opt, "-seasons") && ((i+2)<argc)) { /* --seasons = List seasons */
+	return doseasons(atoi(argv[i+1]), atoi(argv[i+2]));
+      }
+      if (streq(opt, "-serve-stdio")) {	/* --serve-stdio = Co-process mode */
+	return doserve();
+      }
+      if (streq(opt, "-stats")) {	/* --stats = Output the statistics at exit */
+#ifdef TRACING
+	if (!iStats) atexit(dump_stats);
+	iStats = 1;
+	continue;
+#else
+	fprintf(stderr, "Error: Option --stats is not available. Rebuild with make TRACE=1\n");
+	return 1;
+#endif
+      }
       if (cOpt == 'p') {	/* -p = Polish joke mode */
 optionP:
 	polish = 1;
@@ -275,12 +436,19 @@ optionS:
       }
       if ((cOpt == 'w') && ((i+1)<argc)) { /* -w = Set output width */
       	lineWidth = atoi(argv[++i]);
-	if ((lineWidth <= 0) || (lineWidth > MAXLINEWIDTH)) lineWidth = MAXLINEWIDTH;
+	if (lineWidth < 0) lineWidth = 0;	/* 0 = Unlimited */
 	continue;
       }
       if ((cOpt == 'x') || (!opt[0])) { /* - = Process data from stdin */
 optionX:
-	while (!getLine()) {	/* Read and print times */
+	if (iFormat == FMT_JSON) return json_no_dark();
+	if (iFormat) out_header();	/* Before the parallel threads start */
+	else init_line_width();
+	out_flush();
+#ifdef _OPENMP
+	if (!isatty(0)) return doparallel();	/* Files and pipes */
+#endif
+	while (out_flush(), !getLine()) {	/* Read and print times */
 	  dotexttime(line);
 	}
 	return 0;
@@ -294,17 +462,28 @@ optionX:
     if (cArg == 's') goto optionS;
     if (cArg == 'x') goto optionX;  /* "today x" is needed for vms. */
     /* Else this is supposed to be a date. Process it */
+    if (iFormat == FMT_JSON) return json_no_dark();
     if (dotexttime(arg) == 0) done = 1;
   }
 
+  out_flush();
+  if (pszDarkFrom) return dodark(pszDarkFrom, pszDarkTo);
+  if (iFormat == FMT_JSON) return json_no_dark();
+  if (pszIcsFrom) return doics(pszIcsFrom, pszIcsTo);
+
   /*
    * Here if no parameters or an error in the parameter field.
    */
   if (!done) dotime();		/* Print the time.              */
 
 #ifdef	UNIX
-  if (!quiet) {
+  if (!quiet && !iFormat) {
     output("\n");           	/* Space before cookie          */
+    out_flush();
+    fflush(stdout);		/* Or the pipe contents would be lost */
+#ifdef TRACING
+    dump_stats();		/* The atexit() routines don't run after execl() */
+#endif
     execl(COOKIEPROGRAM, "cookie", 0);
   }
 #endif
@@ -317,13 +496,14 @@ void dotime()
  */
 {
   time_t  tvec;                   /* Buffer for time function     */
-  struct  tm *localtime();	/* Unix time decompile function */
+  struct  tm stm;
   struct  tm *p;			/* Local pointer to time of day */
 
-  if (debug) printf("dotime();\n");
+  if (today_debug) printf("dotime();\n");
 
+  get_location(pszCfgFile);	/* Get the location time zone, if any */
   time(&tvec);                     /* Get the time of day          */
-  p = localtime(&tvec);           /* Make it more understandable  */
+  p = loc_localtime(tvec, &stm);  /* Make it more understandable  */
 
 #ifdef	APRIL_FOOLS
   {
@@ -343,15 +523,22 @@ char    *text;                          /* Time text                    */
  */
 {
   struct tm stm;
+  DATERANGE dr;
   int iErr;
   
-  iErr = parsetime(text, &stm);
+  TRACE_STAGE(TS_PARSE, iErr = daterange_parse(text, &dr)); /* A date, or a range of dates */
   if (iErr) goto bad;
-  process(&stm);
+  while (daterange_next(&dr, &stm)) {
+    process(&stm);
+  }
   return(0);				/* Normal exit		*/
 
 bad:
-  if (debug) printf("Error at offset %d in text\n", iErr - 1);
+  if (today_debug) printf("Error at offset %d in text\n", iErr - 1);
+  if (iFormat) {		/* Keep the records stream clean */
+    fprintf(stderr, "Error: Bad date at offset %d in \"%s\"\n", iErr - 1, text);
+    return(1);
+  }
   output("Bad parameters or date out of range in \"");
   output(text);
   output("\" after scanning \"");
@@ -362,6 +549,775 @@ bad:
 
 }
 
+int doseasons(yFrom, yTo)
+int yFrom;
+int yTo;
+/*
+ * List the equinoxes and solstices instants, in UT, one year per line.
+ */
+{
+  int year, i;
+
+  if ((yFrom < 1583) || (yTo < yFrom)) {
+    fprintf(stderr, "Error: Invalid years range %d to %d\n", yFrom, yTo);
+    return 1;
+  }
+  printf("Year %-16s %-16s %-16s %s (UT)\n", "March equinox", "June solstice", "Sept. equinox", "Dec. solstice");
+  for (year = yFrom; year <= yTo; year++) {
+    double jd[4];
+    seasons(year, jd);
+    printf("%04d", year);
+    for (i = 0; i < 4; i++) {
+      struct tm stm;
+      jd_to_tm(jd[i], &stm);
+      printf(" %04d-%02d-%02d %02d:%02d", stm.tm_year+1900, stm.tm_mon+1, stm.tm_mday, stm.tm_hour, stm.tm_min);
+    }
+    printf("\n");
+  }
+  return 0;
+}
+
+typedef struct _DARKCTX {	/* dodark() state passed to the dark_windows() callback */
+  int iFormat;			/* FMT_TEXT, FMT_CSV, FMT_JSONL, or FMT_JSON */
+  int nWindows;			/* Number of windows output so far */
+  RECORD rec;			/* CSV and JSON Lines records */
+} DARKCTX;
+
+static const char * const dark_fields[] = {	/* Fields of the --dark records */
+  "night", "start", "end", "hours", NULL
+};
+
+static void fmtjd(char *buf, double jd)	/* Format a JD as an ISO UTC date/time */
+{
+  struct tm stm;
+  jd_to_tm(jd + 0.5 / 86400, &stm);	/* Round to the nearest second */
+  sprintf(buf, "%04d-%02d-%02dT%02d:%02d:%02dZ", stm.tm_year+1900, stm.tm_mon+1,
+	  stm.tm_mday, stm.tm_hour, stm.tm_min, stm.tm_sec);
+}
+
+static void dark_time(RECORD *pr, double jd)	/* Append a JD as a local time */
+{
+  struct tm stm;
+  long days, secs;
+  time_t t;
+
+  jd_to_tm(jd + 0.5 / 86400, &stm);	/* Rounded like fmtjd() */
+  t = (time_t)days_from_civil(stm.tm_year+1900, stm.tm_mon+1, stm.tm_mday) * 86400
+      + stm.tm_hour * 3600L + stm.tm_min * 60L + stm.tm_sec;
+  loc_localtime(t, &stm);
+  days = days_from_civil(stm.tm_year+1900, stm.tm_mon+1, stm.tm_mday);
+  secs = stm.tm_hour * 3600L + stm.tm_min * 60L + stm.tm_sec;
+  record_time(pr, stm.tm_year+1900, stm.tm_mon+1, stm.tm_mday, secs,
+	      (long)((time_t)days * 86400 + secs - t));
+}
+
+static int put_dark(double jdStart, double jdEnd, void *pRef)
+{
+  DARKCTX *pCtx = (DARKCTX *)pRef;
+  char szNight[16], szStart[32], szEnd[32];
+  double hours = (jdEnd - jdStart) * 24;
+  size_t n;
+
+  /* The night is named after the local mean date of the previous noon */
+  fmtjd(szNight, jdStart - 0.5 - today_lon / 360);
+  szNight[10] = '\0';
+  switch (pCtx->iFormat) {
+    case FMT_CSV:
+    case FMT_JSONL:
+    case FMT_JSON:	/* Local times with their UTC offset, like the dates records */
+      record_begin(&pCtx->rec);
+      record_str(&pCtx->rec, szNight);
+      dark_time(&pCtx->rec, jdStart);
+      dark_time(&pCtx->rec, jdEnd);
+      record_num(&pCtx->rec, hours, 3);
+      n = record_end(&pCtx->rec);
+      if (pCtx->iFormat == FMT_JSON) {
+	pCtx->rec.szBuf[n - 1] = '\0';	/* Remove the new line */
+	printf("%s  %s", pCtx->nWindows ? ",\n" : "", pCtx->rec.szBuf);
+      } else {
+	fwrite(pCtx->rec.szBuf, 1, n, stdout);
+      }
+      break;
+    default:
+      fmtjd(szStart, jdStart);
+      fmtjd(szEnd, jdEnd);
+      printf("%-10s  %-20s  %-20s  %5.2f\n", szNight, szStart, szEnd, hours);
+      break;
+  }
+  pCtx->nWindows += 1;
+  return 0;
+}
+
+int dodark(pszFrom, pszTo)
+char *pszFrom;
+char *pszTo;
+/*
+ * List the astronomical darkness windows for the nights starting on FROM
+ * to TO, at the configured location. Times are in UT in the text output,
+ * and in local time with their UTC offset in the CSV and JSON outputs.
+ */
+{
+  struct tm stm;
+  double jdFrom, jdTo;
+  DARKCTX ctx;
+
+  if (iFormat == FMT_BIN) {
+    fprintf(stderr, "Error: Unsupported format for --dark: %s\n", pszFormat);
+    return 1;
+  }
+  ctx.nWindows = 0;
+  ctx.iFormat = iFormat;
+  /* The JSON array elements are JSON Lines records, without their new line */
+  record_init(&ctx.rec, (iFormat == FMT_JSON) ? FMT_JSONL : iFormat, dark_fields);
+  if (get_location(pszCfgFile)) {
+    fprintf(stderr, "Error: Can't read the location from %s\n", pszCfgFile);
+    return 1;
+  }
+  /* Scan from the local mean noon of FROM, to the local mean noon after TO */
+  if (parsetime(pszFrom, &stm)) {
+    fprintf(stderr, "Error: Invalid date: %s\n", pszFrom);
+    return 1;
+  }
+  stm.tm_hour = stm.tm_min = stm.tm_sec = 0;
+  jdFrom = tm_to_jd(&stm) + 0.5 + today_lon / 360;
+  if (parsetime(pszTo, &stm)) {
+    fprintf(stderr, "Error: Invalid date: %s\n", pszTo);
+    return 1;
+  }
+  stm.tm_hour = stm.tm_min = stm.tm_sec = 0;
+  jdTo = tm_to_jd(&stm) + 1.5 + today_lon / 360;
+  if (jdTo <= jdFrom) {
+    fprintf(stderr, "Error: Invalid dates range %s to %s\n", pszFrom, pszTo);
+    return 1;
+  }
+
+  switch (ctx.iFormat) {
+    case FMT_CSV: fwrite(ctx.rec.szBuf, 1, record_header(&ctx.rec), stdout); break;
+    case FMT_JSONL: break;
+    case FMT_JSON: printf("[\n"); break;
+    default: printf("%-10s  %-20s  %-20s  %s\n", "Night", "Start (UT)", "End (UT)", "Hours"); break;
+  }
+  dark_windows(jdFrom, jdTo, maxIllum, put_dark, &ctx);
+  if (ctx.iFormat == FMT_JSON) printf("%s]\n", ctx.nWindows ? "\n" : "");
+  return 0;
+}
+
+static int json_no_dark()	/* The json format is only supported for --dark */
+{
+  fprintf(stderr, "Error: Unsupported format: json. Use it with --dark\n");
+  return 1;
+}
+
+#define SYNODIC_MONTH	29.530588853	/* Mean lunation, in days */
+
+static void ics_line(const char *pszLine)
+/*
+ * Output an iCalendar content line, folded every 75 bytes, ending with CRLF.
+ * Never fold in the middle of an UTF-8 character.
+ */
+{
+  size_t n = strlen(pszLine);
+  size_t max = 75;		/* The first line has no leading space */
+
+  while (n > max) {
+    size_t l = max;
+    while ((l > 1) && ((pszLine[l] & 0xC0) == 0x80)) l--;
+    out_write(pszLine, l);
+    out_write("\r\n ", 3);
+    pszLine += l;
+    n -= l;
+    max = 74;
+  }
+  out_write(pszLine, n);
+  out_write("\r\n", 2);
+}
+
+static char *ics_text(char *buf, size_t size, const char *psz)
+/*
+ * Escape an iCalendar TEXT value.
+ */
+{
+  size_t n = 0;
+
+  for ( ; *psz && (n + 3 < size); psz++) {
+    if (strchr(",;\\", *psz)) buf[n++] = '\\';
+    if (*psz == '\n') {
+      buf[n++] = '\\';
+      buf[n++] = 'n';
+    } else {
+      buf[n++] = *psz;
+    }
+  }
+  buf[n] = '\0';
+  return buf;
+}
+
+static char *ics_utc(char *buf, time_t t)
+/*
+ * Format a UTC time as an iCalendar DATE-TIME.
+ */
+{
+  struct tm stm;
+
+  utc_to_tm(t, 0, 0, &stm);
+  sprintf(buf, "%04d%02d%02dT%02d%02d%02dZ", stm.tm_year+1900, stm.tm_mon+1,
+	  stm.tm_mday, stm.tm_hour, stm.tm_min, stm.tm_sec);
+  return buf;
+}
+
+static void ics_event(const char *pszUid, const char *pszStart, const char *pszEnd,
+		      const char *pszSummary, const char *pszStamp, const char *pszLocation)
+/*
+ * Output a VEVENT. For all-day events, pszStart and pszEnd are
+ * ";VALUE=DATE:YYYYMMDD". Else pszStart is ":YYYYMMDDTHHMMSSZ", and pszEnd
+ * is NULL for an event with no duration.
+ */
+{
+  char line[400];
+
+  ics_line("BEGIN:VEVENT");
+  sprintf(line, "UID:%s", pszUid);
+  ics_line(line);
+  sprintf(line, "DTSTAMP:%s", pszStamp);
+  ics_line(line);
+  sprintf(line, "DTSTART%s", pszStart);
+  ics_line(line);
+  if (pszEnd) {
+    sprintf(line, "DTEND%s", pszEnd);
+    ics_line(line);
+  }
+  sprintf(line, "SUMMARY:%s", pszSummary);
+  ics_line(line);
+  sprintf(line, "LOCATION:%s", pszLocation);
+  ics_line(line);
+  ics_line("TRANSP:TRANSPARENT");
+  ics_line("END:VEVENT");
+}
+
+int doics(pszFrom, pszTo)
+char *pszFrom;
+char *pszTo;
+/*
+ * Output an RFC 5545 iCalendar feed with the sunrise, sunset, and moon phase
+ * events for the dates FROM to TO, at the configured location.
+ * The events are streamed day by day, so any range uses a constant amount of
+ * memory. Their UIDs depend only on the event, its date, and the location, so
+ * that regenerating a calendar updates the same events.
+ */
+{
+  static char *phases[4] = {"New Moon", "First Quarter", "Full Moon", "Last Quarter"};
+  static char *kinds[4] = {"newmoon", "firstquarter", "fullmoon", "lastquarter"};
+  char szRange[128];
+  char szSite[48];		/* Location key for the UIDs */
+  char szCity[300];		/* Escaped city name */
+  char szStamp[20];
+  char szUid[96];
+  char szStart[48], szEnd[48];
+  char line[400];
+  DATERANGE dr;
+  struct tm stm;
+  SUNDAY sd;
+  double jdeNext;		/* Next moon phase */
+  int iPhase;			/* Its index in phases[] */
+  time_t tNext;
+
+  if (get_location(pszCfgFile)) {
+    fprintf(stderr, "Error: Can't read the location from %s\n", pszCfgFile);
+    return 1;
+  }
+  sprintf(szRange, "%.60s/%.60s", pszFrom, pszTo);
+  if (daterange_parse(szRange, &dr) || !daterange_next(&dr, &stm)) {
+    fprintf(stderr, "Error: Invalid dates range %s to %s\n", pszFrom, pszTo);
+    return 1;
+  }
+  sprintf(szSite, "%.4f%c%.4f%c", fabs(today_lat), (today_lat < 0) ? 'S' : 'N',
+	  fabs(today_lon), (today_lon > 0) ? 'W' : 'E');	/* Caution: lon +=West */
+  ics_text(szCity, sizeof(szCity), today_city);
+  ics_utc(szStamp, time(NULL));
+
+  /* Find the last moon phase before the first date */
+  stm.tm_hour = stm.tm_min = stm.tm_sec = 0;
+  jdeNext = moon_phase_jde(tm_to_jd(&stm) - SYNODIC_MONTH / 2, 0.0);
+  for (iPhase = 0; ; iPhase = (iPhase + 1) % 4) {
+    double jde = moon_phase_jde(jdeNext + SYNODIC_MONTH / 4, 90.0 * ((iPhase + 1) % 4));
+    if (jde > tm_to_jd(&stm)) break;
+    jdeNext = jde;
+  }
+  tNext = 0;
+
+  ics_line("BEGIN:VCALENDAR");
+  ics_line("VERSION:2.0");
+  ics_line("PRODID:-//JFL//today " VERSION "//EN");
+  ics_line("CALSCALE:GREGORIAN");
+  ics_line("METHOD:PUBLISH");
+  sprintf(line, "X-WR-CALNAME:Sun and moon in %s", szCity);
+  ics_line(line);
+
+  do {
+    int year = stm.tm_year + 1900;
+    int month = stm.tm_mon + 1;
+    int day = stm.tm_mday;
+    time_t t0 = (time_t)days_from_civil(year, month, day) * 86400 - loc_utc_offset(&stm);
+    int i;
+
+    if (sun_day(&stm, pszCfgFile, &sd)) return 1;
+    if (sd.state == RS_RISES) {
+      for (i = 0; i < 2; i++) {
+	double h = i ? sd.set : sd.rise;
+	sprintf(szUid, "%04d%02d%02d-%s-%s@today", year, month, day, i ? "sunset" : "sunrise", szSite);
+	szStart[0] = ':';
+	ics_utc(szStart + 1, t0 + (time_t)(h * 60 + 0.5) * 60);	/* Rounded to the minute */
+	ics_event(szUid, szStart, NULL, i ? "Sunset" : "Sunrise", szStamp, szCity);
+      }
+    } else {		/* Polar day or night: An all-day event */
+      int y, m, d;
+      civil_from_days(days_from_civil(year, month, day) + 1, &y, &m, &d);
+      sprintf(szUid, "%04d%02d%02d-%s-%s@today", year, month, day,
+	      (sd.state == RS_CIRCUMPOLAR) ? "polarday" : "polarnight", szSite);
+      sprintf(szStart, ";VALUE=DATE:%04d%02d%02d", year, month, day);
+      sprintf(szEnd, ";VALUE=DATE:%04d%02d%02d", y, m, d);
+      ics_event(szUid, szStart, szEnd, (sd.state == RS_CIRCUMPOLAR)
+		? "The sun does not set" : "The sun does not rise", szStamp, szCity);
+    }
+
+    /* The moon phases until the end of this local day */
+    for (;;) {
+      if (!tNext) {		/* Compute the next phase instant */
+	jdeNext = moon_phase_jde(jdeNext + SYNODIC_MONTH / 4, 90.0 * ((iPhase + 1) % 4));
+	iPhase = (iPhase + 1) % 4;
+	tNext = (time_t)floor((jdeNext - delta_t(jdeNext) / 86400 - 2440587.5) * 86400 + 0.5);
+      }
+      if (tNext >= t0 + 86400) break;
+      if (tNext >= t0) {
+	struct tm stmPhase;
+	utc_to_tm(tNext, 0, 0, &stmPhase);
+	sprintf(szUid, "%04d%02d%02d-%s-%s@today", stmPhase.tm_year+1900,
+		stmPhase.tm_mon+1, stmPhase.tm_mday, kinds[iPhase], szSite);
+	szStart[0] = ':';
+	ics_utc(szStart + 1, tNext - tNext % 60);
+	ics_event(szUid, szStart, NULL, phases[iPhase], szStamp, szCity);
+      }
+      tNext = 0;
+    }
+  } while (daterange_next(&dr, &stm));
+
+  ics_line("END:VCALENDAR");
+  out_flush();
+  return 0;
+}
+
+/* A member of a flat JSON object, parsed in place by json_parse() */
+typedef struct _JSONITEM {
+  char *pszKey;
+  char *pszValue;		/* String; array of strings joined with \n; or number text */
+  char cType;			/* '"' = String; '[' = Array; '0' = Number, true, false, null */
+} JSONITEM;
+
+#define JSON_ITEMS	16		/* Maximum number of members in a request */
+#define SITE_CACHE	16		/* Number of locations kept between requests */
+#define REQUESTSIZE	65536		/* Maximum length of a request line */
+
+static char *json_string(char **pp)
+/*
+ * Decode in place the JSON string at *pp, which points at its opening quote.
+ * Return the decoded string, or NULL if invalid. Update *pp past the string.
+ */
+{
+  char *p = *pp + 1;
+  char *pszOut = *pp;		/* The decoded text is never longer */
+  char *psz = pszOut;
+  unsigned u;
+  int i;
+
+  for ( ; *p != '"'; p++) {
+    if ((unsigned char)*p < ' ') return NULL;	/* Including the final NUL */
+    if (*p != '\\') {
+      *(psz++) = *p;
+      continue;
+    }
+    switch (*(++p)) {
+      case '"': case '\\': case '/': *(psz++) = *p; break;
+      case 'b': *(psz++) = '\b'; break;
+      case 'f': *(psz++) = '\f'; break;
+      case 'n': *(psz++) = '\n'; break;
+      case 'r': *(psz++) = '\r'; break;
+      case 't': *(psz++) = '\t'; break;
+      case 'u':			/* Encode it in UTF-8. Surrogates become '?' */
+	for (u = 0, i = 0; i < 4; i++) {
+	  char c = *(++p);
+	  if (!isxdigit(c)) return NULL;
+	  u = (u << 4) | (isdigit(c) ? c - '0' : (c | 0x20) - 'a' + 10);
+	}
+	if ((u >= 0xD800) && (u < 0xE000)) u = '?';
+	if (u < 0x80) {
+	  *(psz++) = (char)u;
+	} else if (u < 0x800) {
+	  *(psz++) = (char)(0xC0 | (u >> 6));
+	  *(psz++) = (char)(0x80 | (u & 0x3F));
+	} else {
+	  *(psz++) = (char)(0xE0 | (u >> 12));
+	  *(psz++) = (char)(0x80 | ((u >> 6) & 0x3F));
+	  *(psz++) = (char)(0x80 | (u & 0x3F));
+	}
+	break;
+      default: return NULL;
+    }
+  }
+  *pp = p + 1;
+  *psz = '\0';			/* Possibly over the closing quote */
+  return pszOut;
+}
+
+static int json_parse(char *p, JSONITEM *pItems, int nMax)
+/*
+ * Parse in place a flat JSON object, whose values are strings, numbers,
+ * booleans, null, or arrays of strings. Return the number of members, or -1.
+ */
+{
+  int n = 0;
+
+#define SKIP_BLANKS() while (isspace((unsigned char)*p)) p++
+  SKIP_BLANKS();
+  if (*(p++) != '{') return -1;
+  SKIP_BLANKS();
+  if (*p == '}') return 0;
+  for (;;) {
+    JSONITEM *pItem = pItems + n;
+    if ((n++ == nMax) || (*p != '"') || !(pItem->pszKey = json_string(&p))) return -1;
+    SKIP_BLANKS();
+    if (*(p++) != ':') return -1;
+    SKIP_BLANKS();
+    pItem->cType = (*p == '"') ? '"' : (*p == '[') ? '[' : '0';
+    if (*p == '"') {
+      if (!(pItem->pszValue = json_string(&p))) return -1;
+    } else if (*p == '[') {	/* Join the strings in place, with \n */
+      char *psz = pItem->pszValue = p++;
+      SKIP_BLANKS();
+      if (*p == ']') p++;
+      else for (;;) {
+	char *pszItem;
+	size_t l;
+	if ((*p != '"') || !(pszItem = json_string(&p))) return -1;
+	l = strlen(pszItem);
+	if (psz != pItem->pszValue) *(psz++) = '\n';
+	memmove(psz, pszItem, l);
+	psz += l;
+	SKIP_BLANKS();
+	if (*p == ']') {
+	  p++;
+	  break;
+	}
+	if (*(p++) != ',') return -1;
+	SKIP_BLANKS();
+      }
+      *psz = '\0';		/* Before the closing ], or over it */
+    } else {			/* A number, true, false, or null */
+      pItem->pszValue = p;
+      while (isalnum((unsigned char)*p) || (*p && strchr("+-.", *p))) p++;
+      if (p == pItem->pszValue) return -1;
+      if (isspace((unsigned char)*p)) *(p++) = '\0';
+    }
+    SKIP_BLANKS();
+    if (*p == '}') {
+      *p = '\0';		/* In case a number ended there */
+      return n;
+    }
+    if (*p != ',') return -1;
+    *(p++) = '\0';
+    SKIP_BLANKS();
+  }
+#undef SKIP_BLANKS
+}
+
+static const char *json_get(JSONITEM *pItems, int n, const char *pszKey, char cType)
+/*
+ * Get the value of a member of a given type, or NULL if absent or of another type.
+ */
+{
+  int i;
+
+  for (i = 0; i < n; i++) {
+    if (streq(pItems[i].pszKey, pszKey)) {
+      return (pItems[i].cType == cType) ? pItems[i].pszValue : NULL;
+    }
+  }
+  return NULL;
+}
+
+static int json_token(const char *p)
+/*
+ * Check that a json_parse() number value is a valid JSON number, true,
+ * false, or null. Return 1 if it is, else 0.
+ */
+{
+  if (streq(p, "true") || streq(p, "false") || streq(p, "null")) return 1;
+  if (*p == '-') p++;
+  if (*p == '0') {
+    p++;
+  } else {
+    if (!isdigit((unsigned char)*p)) return 0;
+    while (isdigit((unsigned char)*p)) p++;
+  }
+  if (*p == '.') {
+    if (!isdigit((unsigned char)*(++p))) return 0;
+    while (isdigit((unsigned char)*p)) p++;
+  }
+  if ((*p | 0x20) == 'e') {
+    if ((*(++p) == '+') || (*p == '-')) p++;
+    if (!isdigit((unsigned char)*p)) return 0;
+    while (isdigit((unsigned char)*p)) p++;
+  }
+  return !*p;
+}
+
+static int has_word(const char *pszList, const char *pszWord)
+/*
+ * Check if a \n-separated list contains a word.
+ */
+{
+  size_t l = strlen(pszWord);
+
+  while (pszList) {
+    if (!strncmp(pszList, pszWord, l) && ((pszList[l] == '\n') || !pszList[l])) return TRUE;
+    pszList = strchr(pszList, '\n');
+    if (pszList) pszList++;
+  }
+  return FALSE;
+}
+
+static LOCATION *serve_site(double dLat, double dLonEast, const char *pszTz, const char *pszCity)
+/*
+ * Get a location from the cache, or create it, replacing the oldest one.
+ */
+{
+  static LOCATION *pSites[SITE_CACHE];
+  static int iNext = 0;
+  LOCATION *ploc;
+  int i;
+
+  if (!pszTz) pszTz = "";
+  if (!pszCity) pszCity = "";
+  for (i = 0; i < SITE_CACHE; i++) {
+    ploc = pSites[i];
+    if (ploc && (ploc->lat == dLat) && (ploc->lon == -dLonEast)
+	&& !strncmp(ploc->tzid, pszTz, sizeof(ploc->tzid) - 1)
+	&& !strncmp(ploc->city, pszCity, sizeof(ploc->city) - 1)) return ploc;
+  }
+  ploc = today_site_new(dLat, dLonEast, *pszTz ? pszTz : NULL, pszCity);
+  if (!ploc) return NULL;		/* Out of memory, or invalid time zone */
+  today_site_close(pSites[iNext]);
+  pSites[iNext] = ploc;
+  iNext = (iNext + 1) % SITE_CACHE;
+  return ploc;
+}
+
+static void serve_request(char *pszLine, LOCATION *plocDefault)
+/*
+ * Process one JSON request line, and output one JSON response line.
+ */
+{
+  JSONITEM items[JSON_ITEMS];
+  const char *names[24];	/* The response fields, in the order they're set */
+  const char *pszId, *pszIdToken, *pszDate, *pszLat, *pszLon, *pszTz, *pszOutputs;
+  const char *pszError = NULL;
+  LOCATION *ploc = plocDefault;
+  struct tm stm;
+  RECORD rec;
+  long offset;
+  int year, month, day;
+  int nItems, n = 0;
+  int iSun, iMoon, iText;
+
+  nItems = json_parse(pszLine, items, JSON_ITEMS);
+  if (nItems < 0) {
+    nItems = 0;
+    pszError = "Invalid JSON request";
+  }
+  pszId = json_get(items, nItems, "id", '"');
+  pszIdToken = json_get(items, nItems, "id", '0');	/* Echoed as is */
+  if (pszIdToken && !json_token(pszIdToken)) {
+    pszIdToken = NULL;
+    pszError = "Invalid JSON request";
+  }
+  pszDate = json_get(items, nItems, "date", '"');
+  pszLat = json_get(items, nItems, "lat", '0');
+  pszLon = json_get(items, nItems, "lon", '0');
+  pszTz = json_get(items, nItems, "tz", '"');
+  pszOutputs = json_get(items, nItems, "outputs", '[');
+  if (!pszOutputs) pszOutputs = "sun\nmoon";
+  iSun = has_word(pszOutputs, "sun");
+  iMoon = has_word(pszOutputs, "moon");
+  iText = has_word(pszOutputs, "text");
+
+  if (!pszError && (pszLat || pszLon || pszTz)) {	/* Location override */
+    if (!pszLat || !pszLon || (fabs(atof(pszLat)) > 90) || (fabs(atof(pszLon)) > 180)) {
+      pszError = "Invalid location";
+    } else {
+      ploc = serve_site(atof(pszLat), atof(pszLon), pszTz, json_get(items, nItems, "city", '"'));
+      if (!ploc) pszError = "Invalid time zone";
+    }
+  }
+  if (!pszError) {
+    if (pszDate) {		/* In the site time zone. The default one uses the system's, like -x */
+      if (parsetime_tz(pszDate, &stm, (ploc == plocDefault) ? system_tz() : &ploc->tzf)) {
+	pszError = "Invalid date";
+      }
+    } else if (ploc == plocDefault) {
+      location_localtime(ploc, time(NULL), &stm);
+    } else {
+      today_local_time(ploc, time(NULL), &stm);
+    }
+  }
+  if (!pszError && (stm.tm_year < 1583 - 1900)) pszError = "Date out of range";
+
+  /* The response fields */
+  if (pszId || pszIdToken) names[n++] = "id";
+  if (pszError) {
+    names[n++] = "error";
+  } else {
+    names[n++] = "date";
+    names[n++] = "time";
+    names[n++] = "city";
+    if (iSun) {
+      names[n++] = "sunrise";
+      names[n++] = "noon";
+      names[n++] = "sunset";
+      names[n++] = "tz";
+      names[n++] = "status";
+    }
+    if (iMoon) {
+      names[n++] = "illumination";
+      names[n++] = "waxing";
+      names[n++] = "phase";
+    }
+    if (iText) {
+      names[n++] = "date_text";
+      names[n++] = "time_text";
+    }
+  }
+  names[n] = NULL;
+
+  record_init(&rec, FMT_JSONL, names);
+  record_begin(&rec);
+  if (pszId) record_str(&rec, pszId);
+  if (pszIdToken) record_raw(&rec, pszIdToken);
+  if (pszError) {
+    record_str(&rec, pszError);
+    out_write(rec.szBuf, record_end(&rec));
+    return;
+  }
+
+  year = stm.tm_year + 1900;
+  month = stm.tm_mon + 1;
+  day = stm.tm_mday;
+  offset = location_utc_offset(ploc, &stm);
+  record_date(&rec, year, month, day);
+  if (stm.tm_hour < 0) {	/* No time specified */
+    record_null(&rec);
+  } else {
+    record_time(&rec, year, month, day, stm.tm_hour * 3600L
+		+ ((stm.tm_min > 0) ? stm.tm_min * 60L : 0)
+		+ ((stm.tm_sec > 0) ? stm.tm_sec : 0), offset);
+  }
+  record_str(&rec, ploc->city);
+  if (iSun) {
+    SUNDAY sd;
+    int iErr = sun_day_at(ploc, &stm, &sd);
+    if (!iErr && (sd.state != RS_RISES)) {
+      iErr = (sd.state == RS_CIRCUMPOLAR) ? SUN_ALWAYS_UP : SUN_ALWAYS_DOWN;
+    }
+    if (iErr) {
+      record_null(&rec);
+    } else {
+      record_time(&rec, year, month, day, (long)floor(sd.rise * 3600 + 0.5), offset);
+    }
+    if (iErr == 1) {
+      record_null(&rec);
+    } else {
+      record_time(&rec, year, month, day, (long)floor(sd.noon * 3600 + 0.5), offset);
+    }
+    if (iErr) {
+      record_null(&rec);
+    } else {
+      record_time(&rec, year, month, day, (long)floor(sd.set * 3600 + 0.5), offset);
+    }
+    record_str(&rec, (iErr == 1) ? NULL : location_tz_abbr(ploc, &stm));
+    record_str(&rec, sun_status(iErr));
+  }
+  if (iMoon) {
+    int waxing;
+    double phase = moon_illum(&stm, &waxing);
+    record_num(&rec, phase / 100, 4);
+    record_bool(&rec, waxing);
+    record_str(&rec, moon_phase_name(phase, waxing));
+  }
+  if (iText) {
+    datetxt_n(outline, sizeof(outline), year, month, day);
+    record_str(&rec, outline);
+    if (stm.tm_hour < 0) {
+      record_null(&rec);
+    } else {
+      timetxt_n(outline, sizeof(outline), stm.tm_hour, stm.tm_min, stm.tm_sec, -1);	/* -1 = No time zone */
+      record_str(&rec, outline);
+    }
+  }
+  out_write(rec.szBuf, record_end(&rec));
+}
+
+int doserve()
+/*
+ * Co-process mode: Read one JSON request per line, and write one JSON
+ * response per line, in the same order. The input is read in blocks, and
+ * the responses to all the complete lines in a block are written at once,
+ * before waiting for more input. The locations stay loaded between requests.
+ * Ex: {"id":1,"date":"2026-06-21","lat":78.22,"lon":15.65,"tz":"Europe/Oslo","outputs":["sun","text"]}
+ */
+{
+  LOCATION *plocDefault;
+  char *pBuf;
+  size_t nLen = 0;
+  int iSkip = FALSE;		/* TRUE = Skipping the end of a request too long */
+
+  plocDefault = today_site_open(pszCfgFile);
+  pBuf = malloc(REQUESTSIZE);
+  if (!plocDefault || !pBuf) {
+    fprintf(stderr, "Error: Can't %s\n", pBuf ? "read the location configuration" : "allocate memory");
+    return 1;
+  }
+  system_tz();
+  for (;;) {
+    char *pLine, *pEnd;
+    int n = (int)read(0, pBuf + nLen, (unsigned)(REQUESTSIZE - 1 - nLen));
+    if (n <= 0) {		/* End of input. Process the last line without a \n, if any */
+      if (nLen && !iSkip) {
+	pBuf[nLen] = '\0';
+	serve_request(pBuf, plocDefault);
+      }
+      break;
+    }
+    nLen += n;
+    for (pLine = pBuf; (pEnd = memchr(pLine, '\n', nLen - (pLine - pBuf))) != NULL; pLine = pEnd + 1) {
+      *pEnd = '\0';
+      if (!iSkip && (pLine[strspn(pLine, " \t\r")])) serve_request(pLine, plocDefault);
+      iSkip = FALSE;
+    }
+    nLen -= pLine - pBuf;
+    memmove(pBuf, pLine, nLen);
+    if (nLen == REQUESTSIZE - 1) {	/* Too long. Report it once, and skip it */
+      if (!iSkip) out_write("{\"error\":\"Request too long\"}\n", 29);
+      iSkip = TRUE;
+      nLen = 0;
+    }
+    out_flush();		/* The responses for this batch */
+    fflush(stdout);
+  }
+  out_flush();
+  fflush(stdout);
+  free(pBuf);
+  today_site_close(plocDefault);
+  return 0;
+}
+
 void process(ptm)
 struct tm *ptm;
 /*
@@ -371,6 +1327,7 @@ struct tm *ptm;
   char szDateTime[32];
   char *pszIntroduction;
   time_t sec_1970;
+  struct tm stmNow;
   struct tm *ptmNow;
   int year = ptm->tm_year + 1900;	/* Year		1900 = 1900	*/
   int month = ptm->tm_mon + 1;		/* Month	January = 1	*/
@@ -380,11 +1337,15 @@ struct tm *ptm;
   int second = ptm->tm_sec;		/* Second	0 .. 59		*/
   int daylight = ptm->tm_isdst;		/* Daylight savings time if 1	*/
 
-  if (debug) printf("process({%d, %d, %d, %d, %d, %d, %d});\n", ptm->tm_year, ptm->tm_mon, ptm->tm_mday, ptm->tm_hour, ptm->tm_min, ptm->tm_sec, ptm->tm_isdst);
+  if (today_debug) printf("process({%d, %d, %d, %d, %d, %d, %d});\n", ptm->tm_year, ptm->tm_mon, ptm->tm_mday, ptm->tm_hour, ptm->tm_min, ptm->tm_sec, ptm->tm_isdst);
+  if (iFormat) {
+    out_record(ptm);
+    return;
+  }
 
   time(&sec_1970);
-  ptmNow = localtime(&sec_1970);
-  if (debug) printf("now = {%d, %d, %d, %d, %d, %d, %d};\n", ptmNow->tm_year, ptmNow->tm_mon, ptmNow->tm_mday, ptmNow->tm_hour, ptmNow->tm_min, ptmNow->tm_sec, ptmNow->tm_isdst);
+  ptmNow = loc_localtime(sec_1970, &stmNow);
+  if (today_debug) printf("now = {%d, %d, %d, %d, %d, %d, %d};\n", ptmNow->tm_year, ptmNow->tm_mon, ptmNow->tm_mday, ptmNow->tm_hour, ptmNow->tm_min, ptmNow->tm_sec, ptmNow->tm_isdst);
   if (ptm->tm_year == ptmNow->tm_year && ptm->tm_mon == ptmNow->tm_mon && ptm->tm_mday == ptmNow->tm_mday) {
     pszIntroduction = "Today is ";
   } else {
@@ -392,92 +1353,298 @@ struct tm *ptm;
     pszIntroduction = szDateTime;
   }
   if (!quiet) output(pszIntroduction);
-  datetxt(outline, year, month, day);
+  datetxt_n(outline, sizeof(outline), year, month, day);
   output(outline);
   output(".\n");
   if (quiet) return;
-  timetxt(outline, hour, minute, second,
-	  (polish) ? 0101010 : daylight);
+  timetxt_n(outline, sizeof(outline), hour, minute, second,
+	    (polish) ? 0101010 : daylight);
   output(outline);
   if (hour >= 0 || minute >= 0 || second >= 0) output(".\n");
   if (sunrise) {
     int sunrh, sunrm, sunsh, sunsm;
-    int iErr = sun(&sunrh, &sunrm, &sunsh, &sunsm, ptm, pszCfgFile);
-    if (iErr) return;
-    printf("In %s,\n", city);
-    output("Sunrise is at ");
-    timetxt(outline, sunrh, sunrm, -2, -1);
-    output(outline);
-    output(".\nSunset is at ");
-    timetxt(outline, sunsh, sunsm, -2, -1);
-    output(outline);
-    output(".\n");
+    int iErr;
+    TRACE_STAGE(TS_SUN, iErr = sun(&sunrh, &sunrm, &sunsh, &sunsm, ptm, pszCfgFile));
+    if (iErr == 1) return;
+    sprintf(outline, "In %s,\n", today_city);
+    out_write(outline, strlen(outline));
+    if (iErr == SUN_ALWAYS_UP) {
+      output("The sun does not set.\n");
+    } else if (iErr == SUN_ALWAYS_DOWN) {
+      output("The sun does not rise.\n");
+    } else {
+      output("Sunrise is at ");
+      timetxt_n(outline, sizeof(outline), sunrh, sunrm, -2, -1);
+      output(outline);
+      output(".\nSunset is at ");
+      timetxt_n(outline, sizeof(outline), sunsh, sunsm, -2, -1);
+      output(outline);
+      output(".\n");
+    }
+  }
+  if (planets) {
+    PLANETDAY pd[NPLANETS];
+    int i;
+    int iErr;
+    TRACE_STAGE(TS_PLANETS, iErr = planets_day(ptm, pd));
+    for (i = 0; !iErr && (i < NPLANETS); i++) {	/* Nothing outside of the valid years */
+      int mn, deg;
+      char *pc;
+      size_t len;
+      output((char *)today_planet_names[i]);
+      switch (pd[i].state) {
+	case RS_CIRCUMPOLAR:
+	  output(" does not set");
+	  break;
+	case RS_NEVER_RISES:
+	  output(" does not rise");
+	  break;
+	default:
+	  mn = (int)(pd[i].rise * 60 + 0.5) % 1440;
+	  output(" rises at ");
+	  timetxt_n(outline, sizeof(outline), mn / 60, mn % 60, -2, -1);
+	  output(outline);
+	  mn = (int)(pd[i].set * 60 + 0.5) % 1440;
+	  output(", and sets at ");
+	  timetxt_n(outline, sizeof(outline), mn / 60, mn % 60, -2, -1);
+	  output(outline);
+	  break;
+      }
+      output(". It is ");
+      deg = (int)(fabs(pd[i].elong) + 0.5);
+      len = nbradd(outline, sizeof(outline), 0, deg, 0);
+      pc = (deg == 1) ? " degree" : " degrees";
+      len = txtadd(outline, sizeof(outline), len, pc, strlen(pc));
+      pc = (pd[i].elong < 0) ? " west of the sun.\n" : " east of the sun.\n";
+      txtadd(outline, sizeof(outline), len, pc, strlen(pc));
+      output(outline);
+    }
   }
   if (moon) {
-    moontxt(outline, ptm);	/* replaced by smarter version */
+    TRACE_STAGE(TS_MOON, moontxt(outline, ptm));	/* replaced by smarter version */
     output(outline);
     output(".\n");
   }
 }
 
-void output(text)
-char    *text;                                  /* What to print        */
+static void out_header()
 /*
- * Output routine.  Text is output using put() so that lines are
- * not more than LINEWIDTH bytes long.  Current position is in global ccpos.
- * (put is equivalent to putchar() except that it is locally buffered.)
+ * Output the CSV header line, or the binary header, once.
  */
 {
-  register char	*in;		/* Current pos. in scan */
-  register char	c;		/* Current character    */
-  register char	*wp;		/* Word pointer		*/
-
-  in = text;
-  while ((c = *in++) != '\0') {
-    switch (c) {
-    case '\n':			/* Force new line       */
-    case ' ':			/* or a space seen      */
-      if ((wordptr-wordbuffer) + ccpos >= lineWidth) {
-	put('\n');		/* Current word         */
-	ccpos = 0;		/* won't fit, dump it.  */
-      }
-      if (wordptr > wordbuffer) {
-	if (ccpos) {		/* Leading space needed */
-	  put(' ');
-	  ccpos++;
-	}
-	for (wp = wordbuffer; wp < wordptr;) {
-	  put(*wp++);
-	}
-	ccpos += (int)(wordptr - wordbuffer);
-	wordptr = wordbuffer;	/* Empty buffer	*/
-      }
-      if (c == '\n') {
-	put('\n');		/* Print a newline	*/
-	ccpos = 0;		/* and reset the cursor	*/
-      }
-      break;
+  RECORD rec;
 
-    default:
-      *wordptr++ = c;		/* Save piece of word   */
-    }
+  if (iHeader) return;
+  iHeader = 1;
+  if (iFormat == FMT_BIN) {
+    unsigned char buf[DAYBIN_HEADER_SIZE];
+#if defined(_MSDOS) || defined(_WIN32)
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    get_location(pszCfgFile);
+    out_write((char *)buf, daybin_header(buf, today_lat, -today_lon, today_city));
+    return;
+  }
+  record_init(&rec, iFormat, fields);
+  out_write(rec.szBuf, record_header(&rec));
+}
+
+static void out_record(ptm)
+struct tm *ptm;
+/*
+ * Output the information as one JSON Lines or CSV record, or binary day row.
+ */
+{
+  RECORD rec;
+  int year = ptm->tm_year + 1900;
+  int month = ptm->tm_mon + 1;
+  int day = ptm->tm_mday;
+  int sunrh, sunrm, sunsh, sunsm;
+  int iErr;
+  int waxing;
+  double phase;
+
+  out_header();
+  if (iFormat == FMT_BIN) {
+    unsigned char buf[DAYBIN_ROW_SIZE];
+    SUNDAY sd;
+    TRACE_STAGE(TS_SUN, iErr = sun_day(ptm, pszCfgFile, &sd));
+    TRACE_STAGE(TS_MOON, phase = moon_illum(ptm, &waxing));
+    out_write((char *)buf, daybin_row(buf, days_from_civil(year, month, day),
+				      iErr ? NULL : &sd, loc_utc_offset(ptm), phase / 100, waxing));
+    return;
   }
+  TRACE_STAGE(TS_SUN, iErr = sun(&sunrh, &sunrm, &sunsh, &sunsm, ptm, pszCfgFile));
+  record_init(&rec, iFormat, fields);
+  record_begin(&rec);
+  record_date(&rec, year, month, day);
+  if (ptm->tm_hour < 0) {	/* No time specified */
+    record_null(&rec);
+  } else {
+    record_time(&rec, year, month, day, ptm->tm_hour * 3600L
+		+ ((ptm->tm_min > 0) ? ptm->tm_min * 60L : 0)
+		+ ((ptm->tm_sec > 0) ? ptm->tm_sec : 0), loc_utc_offset(ptm));
+  }
+  if (iErr) {
+    record_null(&rec);
+    record_null(&rec);
+    record_null(&rec);
+    record_null(&rec);
+  } else {
+    record_time(&rec, year, month, day, (sunrh * 60L + sunrm) * 60, loc_utc_offset(ptm));
+    record_time(&rec, year, month, day, (sunsh * 60L + sunsm) * 60, loc_utc_offset(ptm));
+    record_int(&rec, sunrh * 60L + sunrm);
+    record_int(&rec, sunsh * 60L + sunsm);
+  }
+  record_str(&rec, (iErr == 1) ? NULL : loc_tz_abbr(ptm));
+  record_str(&rec, sun_status(iErr));
+  record_str(&rec, today_city);
+  TRACE_STAGE(TS_MOON, phase = moon_illum(ptm, &waxing));
+  record_num(&rec, phase / 100, 4);
+  record_bool(&rec, waxing);
+  record_str(&rec, moon_phase_name(phase, waxing));
+  out_write(rec.szBuf, record_end(&rec));
+}
+
+void out_flush()
+/*
+ * Write the buffered output text in one block.
+ */
+{
+  if (outlen && !pCapture) TRACE_STAGE(TS_OUTPUT, fwrite(outbuf, 1, outlen, stdout));
+  outlen = 0;
 }
 
-void put(c)
-register char	c;
+#ifdef TRACING
+static void dump_stats()
 /*
- * Actual output routine
+ * Output the counters and stage times to stderr, once, for option --stats.
  */
 {
-  if (c == '\n' || (lineptr - linebuffer) >= lineWidth) {
-    *lineptr = EOS;
-    puts(linebuffer);
-    lineptr = linebuffer;
-    if (c == '\n')
+  if (!iStats) return;
+  iStats = 0;
+  out_flush();
+  fflush(stdout);
+  trace_stats(stderr);
+}
+#endif
+
+static void out_write(const char *p, size_t n)
+/*
+ * Append a span of text to the output buffer, as is.
+ */
+{
+  if (pCapture) {		/* Parallel mode: Append to this thread's chunk */
+    if (pCapture->nLen + n > pCapture->nSize) {
+      size_t size = 2 * (pCapture->nLen + n) + 4096;
+      char *p = realloc(pCapture->pBuf, size);
+      if (!p) return;		/* Out of memory: Drop the text */
+      pCapture->pBuf = p;
+      pCapture->nSize = size;
+    }
+    memcpy(pCapture->pBuf + pCapture->nLen, p, n);
+    pCapture->nLen += n;
+    return;
+  }
+  if (outlen + n > OUTBUFSIZE) {
+    out_flush();
+    if (n > OUTBUFSIZE) {	/* Too big to be buffered anyway */
+      fwrite(p, 1, n, stdout);
       return;
+    }
+  }
+  memcpy(outbuf + outlen, p, n);
+  outlen += n;
+}
+
+static void init_line_width()
+/*
+ * Get the screen width, the first time text is output, if not set by -w.
+ * This avoids querying the terminal for the machine-readable formats.
+ */
+{
+  if (lineWidth >= 0) return;
+  lineWidth = GetScreenColumns() - 1;
+  if (lineWidth > MAXLINEWIDTH) lineWidth = MAXLINEWIDTH;
+  if (lineWidth <= 0) lineWidth = LINEWIDTH;	/* Screen width unknown */
+}
+
+static void out_word(const char *p1, size_t n1, const char *p2, size_t n2)
+/*
+ * Output a complete word, made of two spans, with a leading space if needed.
+ * Go to the next line first if it does not fit on the current one, and cut
+ * words longer than the line width into lines of that width. Never wrap if
+ * the line width is 0.
+ */
+{
+  size_t n = n1 + n2;
+
+  if (!n) return;
+  if (lineWidth < 0) init_line_width();
+  if (lineWidth && ccpos && (ccpos + n >= (size_t)lineWidth)) {
+    out_write("\n", 1);		/* Current word         */
+    ccpos = 0;			/* won't fit, dump it.  */
+  }
+  if (ccpos) {			/* Leading space needed */
+    out_write(" ", 1);
+    ccpos++;
+  }
+  while (lineWidth && (ccpos + n > (size_t)lineWidth)) { /* Too long for any line */
+    size_t l = lineWidth - ccpos;
+    size_t l1 = (l < n1) ? l : n1;
+    out_write(p1, l1);
+    out_write(p2, l - l1);
+    out_write("\n", 1);
+    p1 += l1; n1 -= l1;
+    p2 += l - l1; n2 -= l - l1;
+    n -= l;
+    ccpos = 0;
+  }
+  out_write(p1, n1);
+  out_write(p2, n2);
+  ccpos += (int)n;
+}
+
+void output(text)
+char    *text;                                  /* What to print        */
+/*
+ * Output routine.  Text is buffered so that lines are not more than
+ * lineWidth bytes long, or not wrapped if it's 0.  Current position is in
+ * global ccpos.
+ * Words are located with strcspn(), and copied as whole spans. A word
+ * that continues in the next call is kept in wordbuffer.
+ * (Use out_flush() to actually write the output buffer to stdout.)
+ */
+{
+  size_t n;
+
+  for (;;) {
+    n = strcspn(text, " \n");
+    if (!text[n]) {		/* The word continues in the next call */
+      if (wordlen + n > wordsize) {
+	size_t size = 2 * (wordlen + n) + 64;
+	char *p = realloc(wordbuffer, size);
+	if (!p) {		/* Out of memory: Cut the word here */
+	  out_word(wordbuffer, wordlen, text, n);
+	  wordlen = 0;
+	  break;
+	}
+	wordbuffer = p;
+	wordsize = size;
+      }
+      memcpy(wordbuffer + wordlen, text, n);
+      wordlen += n;
+      break;
+    }
+    out_word(wordbuffer, wordlen, text, n);	/* Empty words do nothing */
+    wordlen = 0;
+    text += n;
+    if (*(text++) == '\n') {	/* Force new line       */
+      out_write("\n", 1);	/* Print a newline	*/
+      ccpos = 0;		/* and reset the cursor	*/
+    }
   }
-  *lineptr++ = c;
+  if (today_debug) out_flush();	/* Keep in sync with the debug printf()s */
 }
 
 int getLine()
@@ -502,3 +1669,133 @@ int getLine()
 
 }
 
+#ifdef _OPENMP
+
+#define CHUNKSIZE	65536		/* Input bytes processed by a thread at a time */
+#define BATCHSIZE	(16*1048576)	/* Input bytes read from a pipe at a time */
+
+void dolines(pText, pEnd)
+char	*pText;				/* The input lines */
+char	*pEnd;				/* Their end */
+/*
+ * Split the input text into chunks of whole lines, without copying it.
+ * Chunks are processed in parallel, each into its own output buffer, and
+ * these buffers are written in the input order.
+ */
+{
+  char **ppChunk;
+  char *p;
+  int i, n;
+
+  ppChunk = malloc(((pEnd - pText) / CHUNKSIZE + 2) * sizeof(char *));
+  if (!ppChunk) {
+    fprintf(stderr, "Error: Out of memory\n");
+    return;
+  }
+  for (n = 0, p = pText; p < pEnd; ) {
+    ppChunk[n++] = p;
+    p += CHUNKSIZE;
+    if (p >= pEnd) break;
+    p = memchr(p, '\n', pEnd - p);
+    if (!p) break;
+    p += 1;
+  }
+  ppChunk[n] = pEnd;
+
+#pragma omp parallel for schedule(dynamic) ordered
+  for (i = 0; i < n; i++) {
+    OUTCHUNK out = {NULL, 0, 0};
+    char *pLine = NULL;
+    size_t nLineSize = 0;
+    char *q, *pNext;
+
+    pCapture = &out;
+    for (q = ppChunk[i]; q < ppChunk[i+1]; q = pNext + 1) {
+      size_t l;
+      pNext = memchr(q, '\n', ppChunk[i+1] - q);
+      if (!pNext) pNext = ppChunk[i+1];
+      l = pNext - q;
+      if (l >= nLineSize) {	/* Copy the line, to NUL-terminate it */
+	char *pNew = realloc(pLine, l + 64);
+	if (!pNew) break;
+	pLine = pNew;
+	nLineSize = l + 64;
+      }
+      memcpy(pLine, q, l);
+      pLine[l] = '\0';
+      dotexttime(pLine);
+    }
+    pCapture = NULL;
+#pragma omp ordered
+    {
+      if (out.nLen) TRACE_STAGE(TS_OUTPUT, fwrite(out.pBuf, 1, out.nLen, stdout));
+    }
+    free(out.pBuf);
+    free(pLine);
+  }
+  free(ppChunk);
+}
+
+int doparallel()
+/*
+ * Process all stdin lines in parallel. Map the input file if possible,
+ * else read it in large blocks, each processed with dolines().
+ */
+{
+  char *pBuf;
+  size_t nSize = BATCHSIZE;
+  size_t nLen = 0;
+  int iEOF = 0;
+#ifndef _WIN32
+  struct stat st;
+
+  if (!fstat(0, &st) && S_ISREG(st.st_mode) && (st.st_size > 0)) {
+    pBuf = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, 0, 0);
+    if (pBuf != MAP_FAILED) {
+      get_location(pszCfgFile);	/* Load it before starting the threads */
+      system_tz();
+      dolines(pBuf, pBuf + st.st_size);
+      munmap(pBuf, (size_t)st.st_size);
+      return 0;
+    }
+  }
+#endif
+
+  get_location(pszCfgFile);	/* Load it before starting the threads */
+  system_tz();
+  pBuf = malloc(nSize);
+  if (!pBuf) {
+    fprintf(stderr, "Error: Out of memory\n");
+    return 1;
+  }
+  while (!iEOF) {
+    size_t nDone;
+    while (nLen < nSize) {
+      int n = (int)read(0, pBuf + nLen, (unsigned)(nSize - nLen));
+      if (n <= 0) {
+	iEOF = 1;
+	break;
+      }
+      nLen += n;
+    }
+    for (nDone = nLen; nDone && (pBuf[nDone-1] != '\n'); nDone--) ;
+    if (iEOF) nDone = nLen;	/* Including the last line without a \n */
+    if (!nDone) {		/* The buffer is too small for a line */
+      char *pNew = realloc(pBuf, 2 * nSize);
+      if (!pNew) {
+	fprintf(stderr, "Error: Out of memory\n");
+	break;
+      }
+      pBuf = pNew;
+      nSize *= 2;
+      continue;
+    }
+    dolines(pBuf, pBuf + nDone);
+    memmove(pBuf, pBuf + nDone, nLen - nDone);
+    nLen -= nDone;
+  }
+  free(pBuf);
+  return 0;
+}
+
+#endif /* defined(_OPENMP) */
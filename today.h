@@ -1,26 +1,285 @@
+#include <stdio.h>
 #include <time.h>
 
-extern int debug;
+extern int today_debug;
 
 /* In sun.c. Defaults in params.h. May be updated with ~/.location data */
-extern char city[];
-extern char tzs[];
-extern char dtzs[];
+extern char today_city[];
+extern char today_tzs[];
+extern char today_dtzs[];
+extern double today_lat;	/* Latitude. +=North */
+extern double today_lon;	/* Longitude. Caution: +=West */
+extern int today_tz;		/* Standard time zone. Hours west of GMT */
+extern char today_tzid[];	/* Time zone ID, like Europe/Paris. Empty if unknown */
 
 /* Low level functions */
 extern char *nbrtxt(char *buffer, int datum, int ordflag);
 extern char *copyst(char *buffer, char *string);
 extern char *datetxt(char *buffer, int year, int month, int day);                   /* Date getter        */
 extern char *timetxt(char *buffer, int hour, int minute, int second, int daylight); /* Time of day getter */
+
+/* Bounded versions of the above. They return the length of the full text, like snprintf() */
+#define TXT_UNBOUNDED ((size_t)-1 / 2)	/* Size for buffers assumed to be large enough */
+extern size_t txtadd(char *buffer, size_t size, size_t len, const char *string, size_t n); /* Append n bytes at offset len */
+/* Same as txtadd(), with an inline fast path when there's room. Use a constant n if possible */
+#define TXTADD(buffer, size, len, string, n) (((len) + (n) < (size)) \
+  ? (memcpy((buffer) + (len), (string), (n)), (buffer)[(len) + (n)] = '\0', (len) + (n)) \
+  : txtadd((buffer), (size), (len), (string), (n)))
+extern size_t nbradd(char *buffer, size_t size, size_t len, int datum, int ordflag);	 /* Append a number at offset len */
+extern int nbrtxt_n(char *buffer, size_t size, int datum, int ordflag);
+extern int datetxt_n(char *buffer, size_t size, int year, int month, int day);
+extern int timetxt_n(char *buffer, size_t size, int hour, int minute, int second, int daylight);
+
 extern double dtor(double deg);
-extern int parsetime(char *text, struct tm *ptm);
+extern int parsetime(const char *text, struct tm *ptm);			 /* Parse a date/time in the system time zone */
 extern char *defaultSysConfFile(char *buf, size_t bufsize);	 /* Get the default system-wide configuration file name */
 extern char *defaultUserConfFile(char *buf, size_t bufsize);	 /* Get the default user-specific configuration file name */
+extern double jd_jan0(int year);					 /* Julian day of the 0th of January of year */
+extern void moon_elp(double jde, double *lambda, double *beta, double *dist);	 /* Moon geocentric ecliptic coordinates */
+extern void sun_meeus(double jde, double *lambda, double *r);			 /* Sun geometric ecliptic longitude */
+extern double moon_illum_elp(double jde);					 /* Illuminated % of the moon at a JDE */
+extern double phase_illum(double lm, double bm, double dm, double ls, double rs); /* Illuminated % from the moon & sun positions */
+extern void jd_to_tm(double jd, struct tm *ptm);				 /* Convert a Julian day to a GMT date/time */
+extern double tm_to_jd(struct tm *ptm);					 /* Convert a GMT date/time to a Julian day */
+extern double delta_t(double jd);						 /* TT - UT, in seconds */
+extern double moon_phase_jde(double jde, double angle);				 /* JDE when the moon elongation is angle */
+extern double solar_lon_apparent(double jde);					 /* Sun apparent ecliptic longitude */
+extern double solar_lon_jd(double jdGuess, double angle);			 /* JD when the Sun longitude is angle */
+extern void seasons(int year, double jd[4]);					 /* JD of the year equinoxes & solstices */
+
+/* Intermediate results of potm(). Angles in degrees. In moontx.c */
+typedef struct _MOONSTATE {
+  double LambdaSol;	/* Sun ecliptic longitude */
+  double l;		/* Moon mean longitude */
+  double Nm;		/* Moon mean longitude of the ascending node */
+  double ldprime;	/* Moon true orbital longitude */
+  double D;		/* Moon age, in degrees */
+  double phase;		/* Illuminated percentage */
+} MOONSTATE;
+
+/* Solar and lunar eclipses. In eclipse.c */
+#define ECL_SOLAR	0x10
+#define ECL_LUNAR	0x20
+#define ECL_PENUMBRAL	1	/* Lunar only */
+#define ECL_PARTIAL	2
+#define ECL_ANNULAR	3	/* Solar only */
+#define ECL_TOTAL	4
+typedef struct _ECLIPSE {
+  double jd;		/* Julian Day (UT) of the greatest eclipse */
+  int type;		/* ECL_SOLAR or ECL_LUNAR, ORed with the kind */
+  double gamma;		/* Distance of the shadow axis to the Earth center, in Earth radii */
+  double mag;		/* Magnitude: Fraction of the diameter obscured */
+} ECLIPSE;
+
+/* Rise & set states, output by rise_set_n(). In sun.c */
+#define RS_RISES	0	/* Rises and sets */
+#define RS_CIRCUMPOLAR	1	/* Always above the horizon */
+#define RS_NEVER_RISES	(-1)	/* Always below the horizon */
+#define SUN_ALWAYS_UP	2	/* sun() result: The sun does not set that day */
+#define SUN_ALWAYS_DOWN	3	/* sun() result: The sun does not rise that day */
+
+/* Planets. In planets.c */
+#define NPLANETS	5	/* Mercury, Venus, Mars, Jupiter, Saturn */
+#define PLANETS_MIN_YEAR 1800	/* Range of years where the planets elements are valid */
+#define PLANETS_MAX_YEAR 2050
+extern const char * const today_planet_names[NPLANETS];
+typedef struct _PLANETPOS {	/* Geocentric positions of all planets at one date */
+  double ra[NPLANETS];		/* Right ascension, in hours */
+  double dec[NPLANETS];		/* Declination, in degrees */
+  double dist[NPLANETS];	/* Distance, in AU */
+  double elong[NPLANETS];	/* Elongation, in degrees. > 0 = East of the Sun */
+} PLANETPOS;
+typedef struct _PLANETDAY {	/* Planet events on one day */
+  int state;			/* RS_RISES, RS_CIRCUMPOLAR, or RS_NEVER_RISES */
+  double rise, transit, set;	/* Local times, in hours */
+  double elong;			/* Elongation at the start of the day, in degrees */
+} PLANETDAY;
+
+/* Sun events on one day. In sun.c */
+typedef struct _SUNDAY {
+  int state;			/* RS_RISES, RS_CIRCUMPOLAR, or RS_NEVER_RISES */
+  double rise, noon, set;	/* Local times, in hours */
+} SUNDAY;
+
+/* Time zone information from a TZif file. In tzfile.c */
+#define TZ_ABBR_SIZE	16
+typedef struct _TZRULE {	/* POSIX TZ DST transition rule */
+  int kind;			/* 'M'=Mm.w.d; 'J'=Jn; 'D'=n */
+  int m, w, d;			/* Month, week, day */
+  long secs;			/* Local time of the transition, in seconds */
+} TZRULE;
+typedef struct _TZFILE {	/* A TZif file mapped in memory */
+  const unsigned char *pBase;	/* File contents */
+  size_t size;
+  int iMapped;			/* 1=mmap()ed; 0=malloc()ed */
+  int nTimeSize;		/* Size of the transition times: 4 or 8 */
+  long timecnt, typecnt, charcnt;
+  const unsigned char *pTimes;	/* Transition times. Big-endian */
+  const unsigned char *pIdx;	/* Local time type index for each transition */
+  const unsigned char *pTypes;	/* Local time types: UTC offset, DST flag, abbreviation index */
+  const unsigned char *pChars;	/* Abbreviations */
+  int iHasFooter;		/* 1=The POSIX TZ string below is valid */
+  int iHasDst;
+  long stdOffset, dstOffset;	/* UTC offsets, in seconds East */
+  char szStd[TZ_ABBR_SIZE], szDst[TZ_ABBR_SIZE];
+  TZRULE start, end;
+  long nCache;			/* Transitions decoded from 1900 to 2100 */
+  time_t *pCacheTimes;		/* Start of each period. [0] = 1900-01-01 */
+  long *pCacheOffsets;		/* UTC offset during each period */
+  unsigned char *pCacheDst;	/* DST flag during each period */
+  const char **ppCacheAbbr;	/* Abbreviation. NULL=szStd or szDst */
+  time_t tCacheEnd;		/* 2100-01-01 */
+} TZFILE;
+
+/* A location, with its time zone. In sun.c. Also known as TODAY_SITE in libtoday.h */
+typedef struct _LOCATION {
+  double lat;			/* Latitude. +=North */
+  double lon;			/* Longitude. Caution: +=West */
+  int tz;			/* Standard time zone. Hours west of GMT. Used if no tz database */
+  char tzs[8];			/* Time zone abbreviation. Used if no tz database */
+  char dtzs[8];			/* Daylight savings time abbreviation. Idem */
+  char tzid[64];		/* Time zone ID, like Europe/Paris. Empty if unknown */
+  char city[256];		/* City name */
+  TZFILE tzf;			/* The TZif file for tzid, if it could be loaded */
+  int iSysTz;			/* 1 = Else use the system time zone DST, like the programs */
+} LOCATION;
+
+/* ISO 8601 date intervals and repeats iterator. In daterange.c */
+typedef struct _DATERANGE {
+  struct tm tmStart;		/* First date, with its local time as entered */
+  int nYears, nMonths, nDays;	/* Step between two dates */
+  long nSeconds;
+  long nCount;			/* Number of dates. -1 = Unlimited */
+  int iHasEnd;			/* 1 = Stop after tEnd */
+  time_t tEnd;
+  long iNext;			/* Index of the next date */
+} DATERANGE;
+extern int daterange_parse(const char *text, DATERANGE *pdr);		 /* Return 0 if OK, or 1 + the error offset */
+extern int daterange_next(DATERANGE *pdr, struct tm *ptm);		 /* Return 1 if there's a next date, else 0 */
+
+/* Machine-readable output records. In record.c */
+#define FMT_TEXT	0	/* Plain text, for humans */
+#define FMT_CSV		1	/* Comma-separated values, with a header line */
+#define FMT_JSONL	2	/* JSON Lines: One JSON object per line */
+#define RECORD_SIZE	1024	/* Maximum length of one record line */
+typedef struct _RECORD {
+  int iFormat;			/* FMT_CSV or FMT_JSONL */
+  const char * const *ppNames;	/* Field names. NULL-terminated */
+  int iField;			/* Index of the next field */
+  size_t nLen;			/* Length of the text in szBuf */
+  char szBuf[RECORD_SIZE];	/* The record text. Reused for every record */
+} RECORD;
+extern int record_format(const char *pszName);				 /* "jsonl" or "csv". Return -1 if unknown */
+extern void record_init(RECORD *pr, int iFormat, const char * const *ppNames);
+extern size_t record_header(RECORD *pr);					 /* Build the CSV header line. Return its length */
+extern void record_begin(RECORD *pr);
+extern void record_null(RECORD *pr);						 /* Append the next field value */
+extern void record_str(RECORD *pr, const char *psz);
+extern void record_raw(RECORD *pr, const char *psz);				 /* A JSON number or literal, as is */
+extern void record_int(RECORD *pr, long l);
+extern void record_num(RECORD *pr, double d, int nDecimals);
+extern void record_bool(RECORD *pr, int i);
+extern void record_date(RECORD *pr, int y, int m, int d);
+extern void record_time(RECORD *pr, int y, int m, int d, long secs, long offset); /* Local date + secs, offset East */
+extern size_t record_end(RECORD *pr);						 /* Terminate the line. Return its length */
+
+/* Binary day rows, with fixed-width little-endian columns. In record.c */
+#define FMT_BIN			3	/* Binary day rows */
+#define DAYBIN_MAGIC		"TODAYBIN"
+#define DAYBIN_VERSION		1
+#define DAYBIN_HEADER_SIZE	256
+#define DAYBIN_ROW_SIZE		28
+extern size_t daybin_header(unsigned char *buf, double lat, double lonEast, const char *pszCity); /* Build the header */
+extern size_t daybin_row(unsigned char *buf, long day, const SUNDAY *psd, long offset, double illum, int waxing); /* Build one row */
+
+/* Darkness windows callback. Return 0 to continue. In dark.c */
+typedef int (*DARKCB)(double jdStart, double jdEnd, void *pRef);
+
+extern long days_from_civil(int y, int m, int d);				 /* Days since 1970-01-01 */
+extern void civil_from_days(long z, int *py, int *pm, int *pd);		 /* Date from days since 1970-01-01 */
+extern int parsetime_tz(const char *text, struct tm *ptm, const TZFILE *ptzf); /* Parse a date/time in a given time zone */
+extern int parsetime_nominal(const char *text, struct tm *ptm);		 /* parsetime(), keeping the time as entered */
+extern time_t tm_normalize(struct tm *ptm);				 /* Reentrant mktime(), for the system time zone */
+extern time_t tm_normalize_tz(struct tm *ptm, const TZFILE *ptzf);		 /* Same, for a given time zone */
+extern const TZFILE *system_tz(void);					 /* The system time zone, or NULL to use the C library */
+extern void utc_to_tm(time_t t, long offset, int isDst, struct tm *ptm);	 /* Reentrant gmtime(), shifted by a UTC offset */
+extern int tzfile_valid_id(const char *pszName);				 /* Check a tz database ID from a client. 1=Valid */
+extern int tzfile_open(const char *pszName, TZFILE *ptzf);			 /* Map a TZif file. Return 0 if OK */
+extern void tzfile_close(TZFILE *ptzf);
+extern int tzfile_lookup(const TZFILE *ptzf, time_t t, long *pOffset, int *pIsDst, const char **ppszAbbr); /* UTC offset at t */
 
 /* High level functions */
 extern void moontxt(char buf[], struct tm *ptm);                                 /* Phase of the moon getter  */
 extern char *moonaa(int nLines, int nCols, int inverse, struct tm *pt);		 /* Moon Ascii Art generator  */
-extern int sun(int *sunrh, int *sunrm, int *sunsh, int *sunsm, struct tm *ptm, char *pFile); /* Sunrine and sunset getter */
+extern double potm(double days);						 /* Illuminated % of the moon. Days since EPOCH */
+extern double potm_elp(double days);						 /* Same, using the ELP-2000/82 theory */
+extern double (*today_potm)(double days);					 /* Phase engine used: potm or potm_elp */
+extern void moon_state(double days, MOONSTATE *pms);				 /* Same as potm(), with intermediate results */
+extern double moon_illum(struct tm *ptm, int *pWaxing);			 /* Illuminated % of the moon at that GMT time */
+extern double moon_illum_with(double (*pfn)(double days), struct tm *ptm, int *pWaxing); /* Same, with a given engine */
+extern char *moon_phase_name(double phase, int waxing);			 /* "new", "waxing_crescent", ..., "waning_crescent" */
+extern int eclipses(double jdFrom, double jdTo, ECLIPSE **ppList);		 /* Eclipses search. Returns the count, or -1 */
+extern int dark_windows(double jdFrom, double jdTo, double maxIllum, DARKCB pfn, void *pRef); /* Astronomical darkness windows */
+extern int get_location(char *pFile);						 /* Load lat, lon, city, etc. Return 0 if OK */
+extern void rise_set_n(int n, const double *alpha, const double *delta, double h0,
+		       double *lstr, double *lsts, double *ar, int *state); /* Rise & set of n objects */
+extern double midnight_lst(struct tm *pt);					 /* Local sidereal time of midnight */
+extern PLANETPOS *planet_positions(double jd);					 /* Planets positions at a JD (UT). Cached */
+extern int planets_day(struct tm *pt, PLANETDAY pd[NPLANETS]);		 /* Planets rise/transit/set on a local date. 0=OK; 1=Out of range */
+extern double loc_tz_hours(struct tm *pt);					 /* Location time zone on that date. Hours West */
+extern char *loc_tz_abbr(struct tm *pt);					 /* Location time zone abbreviation on that date */
+extern long loc_utc_offset(struct tm *pt);					 /* Location UTC offset on that date. Seconds East */
+extern struct tm *loc_localtime(time_t t, struct tm *ptm);			 /* Location local time at t */
+extern int sun_day(struct tm *ptm, char *pFile, SUNDAY *psd);			 /* Sun rise, noon, and set. 0=OK; 1=Error */
+extern int sun(int *sunrh, int *sunrm, int *sunsh, int *sunsm, struct tm *ptm, char *pFile); /* Sunrise and sunset getter. 0=OK; 1=Error; or SUN_ALWAYS_xxx */
+extern char *sun_status(int iErr);						 /* "ok", "polar_day", "polar_night", or "error" */
+
+/* Reentrant versions of the above, for a given location. In sun.c */
+extern int location_load(char *pFile, LOCATION *ploc);				 /* Load the config files & environment. 0=OK */
+extern void location_free(LOCATION *ploc);
+extern int sun_day_at(const LOCATION *ploc, struct tm *ptm, SUNDAY *psd);	 /* Sun rise, noon, and set. 0=OK */
+extern double location_midnight_lst(const LOCATION *ploc, struct tm *pt);
+extern double location_tz_hours(const LOCATION *ploc, struct tm *pt);
+extern long location_utc_offset(const LOCATION *ploc, struct tm *pt);
+extern const char *location_tz_abbr(const LOCATION *ploc, struct tm *pt);
+extern struct tm *location_localtime(const LOCATION *ploc, time_t t, struct tm *ptm);
+
+/* Tracing and statistics. In trace.c.
+   Compiled in with make TRACE=1, which defines TRACING, or in the debug builds.
+   Else all the TRACE_xxx() macros below compile to nothing. */
+#if defined(_DEBUG) && !defined(TRACING)
+#define TRACING 1
+#endif
+enum {				/* Event counters */
+  TC_KEPLER,			/* Kepler equation iterations in solar_lon() */
+  TC_RANGE,			/* Range reduction loops iterations */
+  TC_CONFIG,			/* Configuration files read */
+  TC_TZFILE,			/* TZif files loaded */
+  TC_COUNT
+};
+enum {				/* Timed stages */
+  TS_CONFIG,			/* Loading the location */
+  TS_PARSE,			/* Parsing the dates */
+  TS_SUN,			/* Sun rise and set */
+  TS_MOON,			/* Moon phase */
+  TS_PLANETS,			/* Planets rise and set */
+  TS_OUTPUT,			/* Writing the output */
+  TS_COUNT
+};
+extern int trace_stats(FILE *f);					 /* Dump the counters and stage times. 0=OK; 1=Not compiled in */
+#ifdef TRACING
+extern void trace_event(const char *pszFormat, ...);			 /* Output a logfmt event, if debug is set */
+extern void trace_count(int iCounter, long n);				 /* Add n to a counter */
+extern double trace_now(void);						 /* Monotonic time, in seconds */
+extern void trace_stage(int iStage, double t0);				 /* Add the time since t0 to a stage */
+#define TRACE(args) (today_debug ? trace_event args : (void)0) /* Ex: TRACE(("fn=gmst jd=%f", jd)) */
+#define TRACE_COUNT(c, n) trace_count(c, n)
+#define TRACE_STAGE(s, statement) { double t0_ = trace_now(); statement; trace_stage(s, t0_); }
+#else
+#define TRACE(args) ((void)0)
+#define TRACE_COUNT(c, n) ((void)0)
+#define TRACE_STAGE(s, statement) { statement; }
+#endif
 
 /* Avoid Microsoft C complaints */ 
 #ifdef _MSC_VER
@@ -0,0 +1,196 @@
+/*
+** today_bash.c - Bash loadable builtin, setting sun and moon shell variables
+**
+** Loaded into bash with:  enable -f libtoday_bash.so today
+** Then each run of the today builtin sets these shell variables, without
+** starting any program. This makes it cheap enough to use in PS1 or in
+** PROMPT_COMMAND:
+**
+**   TODAY_DATE         Local date, as YYYY-MM-DD
+**   TODAY_SUNRISE      Local sunrise time, as HH:MM. Empty if polar day/night
+**   TODAY_SUNSET       Local sunset time, as HH:MM. Empty if polar day/night
+**   TODAY_SUN_STATUS   ok, polar_day, or polar_night
+**   TODAY_SUNSET_IN    Time left until the sunset, as H:MM. Empty after it
+**   TODAY_MOON_ILLUM   Moon illuminated percentage, from 0 to 100
+**   TODAY_MOON_PHASE   new, waxing_crescent, ..., waning_crescent
+**   TODAY_MOON_GLYPH   The moon phase emoji, like U+1F314 for waxing gibbous
+**
+** The location is loaded once from the configuration files, like the today
+** programs do, or from the file given with option -c. That file remains in
+** use for the next runs without option -c.
+** The sun and moon results are cached until the local date changes. So
+** most runs just read the clock, and set the variables.
+**
+** The today program can still be run with its full path, like
+** /usr/local/bin/today, or after disabling the builtin with "enable -n today".
+**
+** Build: make libtoday_bash, with the bash loadable builtins headers
+** installed. (In Debian and Ubuntu, they're in the bash-builtins package.)
+**
+** Authors:
+**   JFL jf.larvoire@free.fr
+**
+** History:
+**   2026-10-19 JFL Created this builtin.
+*/
+
+#define VERSION "2026-10-19"
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "loadables.h"
+
+#include "libtoday.h"
+
+static TODAY_SITE *psCache = NULL;	/* The location */
+static char *pszCacheFile = NULL;	/* Its configuration file. NULL=Default */
+static int iCacheDate = -1;		/* Local date of the cached results, as YYYYMMDD */
+static TODAY_SUN sunCache;
+static TODAY_MOON moonCache;
+
+/* Moon phase emojis, U+1F311 to U+1F318, in UTF-8 */
+static const struct {
+  const char *pszPhase;
+  const char *pszGlyph;
+} glyphs[] = {
+  {"new",		"\xF0\x9F\x8C\x91"},
+  {"waxing_crescent",	"\xF0\x9F\x8C\x92"},
+  {"first_quarter",	"\xF0\x9F\x8C\x93"},
+  {"waxing_gibbous",	"\xF0\x9F\x8C\x94"},
+  {"full",		"\xF0\x9F\x8C\x95"},
+  {"waning_gibbous",	"\xF0\x9F\x8C\x96"},
+  {"last_quarter",	"\xF0\x9F\x8C\x97"},
+  {"waning_crescent",	"\xF0\x9F\x8C\x98"},
+};
+#define NGLYPHS (sizeof(glyphs) / sizeof(glyphs[0]))
+
+/* Set a shell variable */
+static void set_var(const char *pszName, const char *pszValue) {
+  bind_variable((char *)pszName, (char *)pszValue, 0);
+}
+
+/* Format local hours as HH:MM, rounded to the minute */
+static char *fmt_hm(char *buf, double h) {
+  int mn = (int)(h * 60 + 0.5);
+
+  mn = ((mn % 1440) + 1440) % 1440;
+  sprintf(buf, "%02d:%02d", mn / 60, mn % 60);
+  return buf;
+}
+
+int today_builtin(WORD_LIST *list) {
+  char *pszFile = NULL;
+  char buf[32];
+  const char *pszStatus;
+  time_t now;
+  struct tm stm;
+  int iDate;
+  int opt;
+  size_t i;
+
+  reset_internal_getopt();
+  while ((opt = internal_getopt(list, "c:")) != -1) {
+    switch (opt) {
+      case 'c':
+	pszFile = list_optarg;
+	break;
+      CASE_HELPOPT;
+      default:
+	builtin_usage();
+	return EX_USAGE;
+    }
+  }
+  list = loptend;
+  if (list) {
+    builtin_usage();
+    return EX_USAGE;
+  }
+
+  /* Load the location the first time, or if the configuration file changed */
+  if (   !psCache
+      || (pszFile && (!pszCacheFile || strcmp(pszFile, pszCacheFile)))) {
+    TODAY_SITE *ps = today_site_open(pszFile);
+    if (!ps) {
+      builtin_error("can't read the location configuration %s", pszFile ? pszFile : "");
+      return EXECUTION_FAILURE;
+    }
+    today_site_close(psCache);
+    psCache = ps;
+    free(pszCacheFile);
+    pszCacheFile = pszFile ? savestring(pszFile) : NULL;
+    iCacheDate = -1;
+  }
+
+  now = time(NULL);
+  today_local_time(psCache, now, &stm);
+  iDate = ((stm.tm_year + 1900) * 100 + stm.tm_mon + 1) * 100 + stm.tm_mday;
+  if (iDate != iCacheDate) {	/* Compute the new day results */
+    today_sun_compute(psCache, stm.tm_year + 1900, stm.tm_mon + 1, stm.tm_mday, &sunCache);
+    today_moon_state(now, TODAY_MOON_ELP, &moonCache);
+    iCacheDate = iDate;
+
+    sprintf(buf, "%04d-%02d-%02d", stm.tm_year + 1900, stm.tm_mon + 1, stm.tm_mday);
+    set_var("TODAY_DATE", buf);
+    pszStatus = (sunCache.status == TODAY_POLAR_DAY) ? "polar_day"
+	      : (sunCache.status == TODAY_POLAR_NIGHT) ? "polar_night" : "ok";
+    set_var("TODAY_SUN_STATUS", pszStatus);
+    set_var("TODAY_SUNRISE", (sunCache.status == TODAY_OK) ? fmt_hm(buf, sunCache.rise) : "");
+    set_var("TODAY_SUNSET", (sunCache.status == TODAY_OK) ? fmt_hm(buf, sunCache.set) : "");
+    sprintf(buf, "%d", (int)(moonCache.illumination * 100 + 0.5));
+    set_var("TODAY_MOON_ILLUM", buf);
+    set_var("TODAY_MOON_PHASE", moonCache.phase);
+    for (i = 0; i < NGLYPHS; i++) {
+      if (!strcmp(moonCache.phase, glyphs[i].pszPhase)) set_var("TODAY_MOON_GLYPH", glyphs[i].pszGlyph);
+    }
+  }
+
+  /* The countdown changes at every run */
+  buf[0] = '\0';
+  if (sunCache.status == TODAY_OK) {
+    long lLeft = (long)(sunCache.set * 3600) - (stm.tm_hour * 3600L + stm.tm_min * 60 + stm.tm_sec);
+    if (lLeft > 0) sprintf(buf, "%ld:%02ld", lLeft / 3600, (lLeft / 60) % 60);
+  }
+  set_var("TODAY_SUNSET_IN", buf);
+
+  return EXECUTION_SUCCESS;
+}
+
+int today_builtin_load(char *name) {
+  return 1;			/* Success */
+}
+
+void today_builtin_unload(char *name) {
+  today_site_close(psCache);
+  psCache = NULL;
+  free(pszCacheFile);
+  pszCacheFile = NULL;
+}
+
+char *today_doc[] = {
+  "Set sun and moon shell variables for today.",
+  "",
+  "Set TODAY_DATE, TODAY_SUNRISE, TODAY_SUNSET, TODAY_SUN_STATUS,",
+  "TODAY_SUNSET_IN, TODAY_MOON_ILLUM, TODAY_MOON_PHASE, and TODAY_MOON_GLYPH,",
+  "for the current date at the configured location. The results are cached",
+  "until the date changes, so this is fast enough for shell prompts.",
+  "",
+  "Options:",
+  "  -c PATHNAME\tLocation configuration file. Default: Like the today program",
+  "",
+  "Version " VERSION ". Use \"enable -n today\" to run the today program again.",
+  (char *)NULL
+};
+
+struct builtin today_struct = {
+  "today",			/* Builtin name */
+  today_builtin,		/* Function implementing it */
+  BUILTIN_ENABLED,		/* Initial flags */
+  today_doc,			/* Long documentation */
+  "today [-c PATHNAME]",	/* Short usage */
+  0				/* Reserved */
+};
@@ -0,0 +1,393 @@
+/*
+** todaybench.c - Micro-benchmarks of the hot routines, for regression checks
+**
+** Measures the time per call, and the number of memory allocations per call,
+** of the routines that dominate the today programs run time. Each routine
+** runs over fixed corpora, so that two runs of the same build do the same
+** work, and their results can be compared with diff:
+**
+**   - Dates evenly spread from 1584-01-01 to 3000-12-31, at various times.
+**     (julian_date() exits for dates before 1583, and sun() also needs the
+**     Julian date of the 0th of January.)
+**   - Locations from the Equator to the polar circles, at all longitudes,
+**     with a time zone computed from the longitude, without any tz database.
+**   - No dependency on the current time: The routines that default to now
+**     are always given a corpus date. And the time zone is set to UTC.
+**
+** Each routine is called repeatedly over its corpus, doubling the number
+** of calls until the run lasts at least the minimum time. The results are
+** output as JSON Lines, one record per routine and size, after a header
+** record describing the run. They're generated by the same code as the
+** --format=jsonl records of the other programs.
+**
+** The allocations are counted only on Linux, where the Makefile wraps
+** malloc(), calloc(), and realloc() with the GNU linker. Elsewhere they're
+** output as null.
+**
+** Authors:
+**   JFL jf.larvoire@free.fr
+**
+** History:
+**   2026-10-19 JFL Created this program.
+*/
+
+#define VERSION "2026-10-19"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(_MSDOS) || defined(_WIN32)
+#include <io.h>
+#define dup _dup
+#define dup2 _dup2
+#define NULL_DEVICE "NUL"
+#else
+#include <unistd.h>
+#define NULL_DEVICE "/dev/null"
+#endif
+#include <fcntl.h>
+
+#include "today.h"
+#include "moontx.h"
+#include "versions.h"
+
+#define streq(s1, s2) (!strcmp(s1, s2))
+
+#define NDATES	4096		/* Size of the dates corpus */
+#define NLOCS	61		/* Size of the locations corpus. Prime, to vary the pairs */
+
+/* Internal routines of sun.c */
+extern double julian_date(int m, int d, int y);
+extern double solar_lon(double ed);
+
+/* Routines and variables of today.c, compiled with -DMULTICALL */
+extern void output(char *text);
+extern void out_flush(void);
+extern int lineWidth;
+
+/* The corpora */
+static struct tm tmDates[NDATES];	/* Dates, in UTC or local time */
+static double dDays[NDATES];		/* Same, in days since EPOCH */
+static char szTimes[NDATES][32];	/* Same, as texts in various formats */
+static int iNumbers[NDATES];		/* Numbers to convert to text */
+static char szWords[NDATES][256];	/* Words to output, ending with a space */
+static LOCATION locs[NLOCS];		/* Locations */
+
+static volatile double dSink;		/* Prevents the compiler from optimizing the calls away */
+
+#ifdef COUNT_ALLOCS
+/* Count the allocations. The Makefile links with -Wl,--wrap=malloc, etc */
+static long nAllocs = 0;
+extern void *__real_malloc(size_t n);
+extern void *__real_calloc(size_t n, size_t size);
+extern void *__real_realloc(void *p, size_t n);
+void *__wrap_malloc(size_t n) { nAllocs++; return __real_malloc(n); }
+void *__wrap_calloc(size_t n, size_t size) { nAllocs++; return __real_calloc(n, size); }
+void *__wrap_realloc(void *p, size_t n) { nAllocs++; return __real_realloc(p, n); }
+#endif
+
+void usage() {
+  printf("\
+todaybench - Micro-benchmarks of the hot routines, for regression checks\n\
+\n\
+Usage: todaybench [OPTIONS] [ROUTINE ...]\n\
+\n\
+Options:\n\
+  -?|-h|--help      Display this help screen\n\
+  --format=jsonl|csv Output format. Default: jsonl\n\
+  -l|--list         List the routines benchmarked\n\
+  -t MS             Minimum time for each routine, in ms. Default: 200\n\
+  -V|--version      Display the program version\n\
+\n\
+Routine: Only benchmark these routines. Default: All\n\
+\n\
+All runs use the same dates from 1584 to 3000, the same locations from the\n\
+Equator to the polar circles, in the UTC time zone.\n\
+\n\
+");
+}
+
+/* The benchmarked routines. Each kernel makes one call for item i */
+static double k_sun(long i, int size) {
+  SUNDAY sd;
+  sun_day_at(&locs[i % NLOCS], &tmDates[i % NDATES], &sd);
+  return sd.noon;
+}
+
+static double k_solar_lon(long i, int size) {
+  return solar_lon(dDays[i % NDATES]);
+}
+
+static double k_julian_date(long i, int size) {
+  struct tm *pt = &tmDates[i % NDATES];
+  return julian_date(pt->tm_mon + 1, pt->tm_mday, pt->tm_year + 1900);
+}
+
+static double k_potm(long i, int size) {
+  return potm(dDays[i % NDATES]);
+}
+
+static double k_moontxt(long i, int size) {
+  char buf[256];
+  moontxt(buf, &tmDates[i % NDATES]);
+  return buf[12];
+}
+
+static double k_moonaa(long i, int size) {
+  char *psz = moonaa(size, 2 * size, 0, &tmDates[i % NDATES]);
+  double d = psz ? psz[size] : 0;
+  free(psz);
+  return d;
+}
+
+static double k_parsetime(long i, int size) {
+  struct tm stm;
+  parsetime(szTimes[i % NDATES], &stm);
+  return stm.tm_mday;
+}
+
+static double k_nbrtxt(long i, int size) {
+  char buf[256];
+  nbrtxt(buf, iNumbers[i % NDATES], (int)(i & 1));
+  return buf[0];
+}
+
+static double k_datetxt(long i, int size) {
+  char buf[256];
+  struct tm *pt = &tmDates[i % NDATES];
+  datetxt(buf, pt->tm_year + 1900, pt->tm_mon + 1, pt->tm_mday);
+  return buf[0];
+}
+
+static double k_timetxt(long i, int size) {
+  char buf[256];
+  struct tm *pt = &tmDates[i % NDATES];
+  timetxt(buf, pt->tm_hour, pt->tm_min, pt->tm_sec, (int)(i & 1));
+  return buf[0];
+}
+
+static double k_output(long i, int size) {
+  output(szWords[i % NDATES]);
+  return 0;
+}
+
+typedef double (*KERNEL)(long i, int size);
+
+static const struct {
+  const char *pszName;
+  int iSize;			/* Size argument, like the moonaa() lines. 0=None */
+  KERNEL pKernel;
+} benches[] = {
+  {"sun",		0,	k_sun},
+  {"solar_lon",		0,	k_solar_lon},
+  {"julian_date",	0,	k_julian_date},
+  {"potm",		0,	k_potm},
+  {"moontxt",		0,	k_moontxt},
+  {"moonaa",		5,	k_moonaa},
+  {"moonaa",		10,	k_moonaa},
+  {"moonaa",		20,	k_moonaa},
+  {"moonaa",		40,	k_moonaa},
+  {"parsetime",		0,	k_parsetime},
+  {"nbrtxt",		0,	k_nbrtxt},
+  {"datetxt",		0,	k_datetxt},
+  {"timetxt",		0,	k_timetxt},
+  {"output",		0,	k_output},
+};
+#define NBENCHES (sizeof(benches) / sizeof(benches[0]))
+
+/* Build the corpora. Everything derives from the indexes, not from the clock */
+static void init_corpora(void) {
+  long day0 = days_from_civil(1584, 1, 1);
+  long span = days_from_civil(3000, 12, 31) + 1 - day0;
+  int i;
+
+  for (i = 0; i < NDATES; i++) {
+    struct tm *pt = &tmDates[i];
+    long day = day0 + (long)((double)span * (i + 0.5) / NDATES);
+    long secs = (i * 7919L) % 86400;	/* Various times of the day */
+    int y, m, d;
+
+    civil_from_days(day, &y, &m, &d);
+    memset(pt, 0, sizeof(*pt));
+    pt->tm_year = y - 1900;
+    pt->tm_mon = m - 1;
+    pt->tm_mday = d;
+    pt->tm_hour = (int)(secs / 3600);
+    pt->tm_min = (int)((secs / 60) % 60);
+    pt->tm_sec = (int)(secs % 60);
+    pt->tm_wday = (int)(((day % 7) + 11) % 7);	/* 1970-01-01 was a Thursday */
+    pt->tm_yday = (int)(day - days_from_civil(y, 1, 1));	/* Used by moontxt() and moonaa() */
+    dDays[i] = (double)(day - days_from_civil(EPOCH, 1, 1)) + secs / 86400.0;
+
+    switch (i % 4) {		/* The formats accepted in the input files */
+      case 0: sprintf(szTimes[i], "%04d-%02d-%02dT%02d:%02d:%02d", y, m, d, pt->tm_hour, pt->tm_min, pt->tm_sec); break;
+      case 1: sprintf(szTimes[i], "%04d-%02d-%02d %02d:%02d", y, m, d, pt->tm_hour, pt->tm_min); break;
+      case 2: sprintf(szTimes[i], "%04d-%03d", y, (int)(day - days_from_civil(y, 1, 1) + 1)); break;
+      case 3: sprintf(szTimes[i], "%04d-%02d-%02dT%02d:%02d:%02d+02:00", y, m, d, pt->tm_hour, pt->tm_min, pt->tm_sec); break;
+    }
+    iNumbers[i] = (int)((i * 104729L) % 1000000L) >> (i % 16);	/* From 0 to 999999, mostly small */
+    datetxt_n(szWords[i], sizeof(szWords[i]) - 1, y, m, d);
+    strcat(szWords[i], " ");
+  }
+
+  for (i = 0; i < NLOCS; i++) {
+    LOCATION *ploc = &locs[i];
+    double lonEast = -180.0 + 360.0 * ((i * 37) % NLOCS) / NLOCS;
+
+    memset(ploc, 0, sizeof(*ploc));
+    ploc->lat = 66.56 * i / (NLOCS - 1) * ((i & 1) ? -1 : 1);
+    ploc->lon = -lonEast;
+    ploc->tz = -(int)(lonEast / 15.0 + ((lonEast < 0) ? -0.5 : 0.5));
+    strcpy(ploc->tzs, "LMT");
+    strcpy(ploc->dtzs, "LMT");
+  }
+}
+
+/* Run a kernel n times. Return the elapsed time in ns */
+static double run(KERNEL pKernel, int iSize, long n) {
+  clock_t t0, t1;
+  double sum = 0.0;
+  long i;
+
+  t0 = clock();
+  for (i = 0; i < n; i++) sum += (*pKernel)(i, iSize);
+  t1 = clock();
+  dSink = sum;
+  return 1e9 * (double)(t1 - t0) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[]) {
+  int i;
+  size_t j;
+  long msMin = 200;
+  int iFormat = FMT_JSONL;
+  char **ppszOnly = NULL;
+  int nOnly = 0;
+  RECORD rec;
+  static const char * const runFields[] = {
+    "program", "version", "os", "dates", "locations", "min_ms", NULL
+  };
+  static const char * const fields[] = {
+    "routine", "size", "calls", "ns_per_call", "allocs_per_call", NULL
+  };
+  int fdStdout = -1;
+
+  for (i=1; i<argc; i++) {
+    char *arg = argv[i];
+    if (   streq(arg, "-?")
+        || streq(arg, "-h")
+        || streq(arg, "--help")) {
+      usage();
+      return 0;
+    }
+    if (!strncmp(arg, "--format=", 9)) {
+      iFormat = record_format(arg + 9);
+      if (iFormat < 0) {
+	fprintf(stderr, "Error: Unsupported format: %s\n", arg + 9);
+	return 1;
+      }
+      continue;
+    }
+    if (   streq(arg, "-l")
+	|| streq(arg, "--list")) {
+      for (j = 0; j < NBENCHES; j++) {
+	if (!j || strcmp(benches[j].pszName, benches[j-1].pszName)) printf("%s\n", benches[j].pszName);
+      }
+      return 0;
+    }
+    if (streq(arg, "-t") && ((i+1)<argc)) {
+      msMin = atol(argv[++i]);
+      continue;
+    }
+    if (   streq(arg, "-V")
+	|| streq(arg, "--version")) {
+      printf(VERSION " " EXE_OS_NAME "\n");
+      return 0;
+    }
+    if ((arg[0] == '-') && arg[1]) {
+      fprintf(stderr, "Unexpected option: %s\n", arg);
+      return 1;
+    }
+    ppszOnly = argv + i;	/* The routines to benchmark */
+    nOnly = argc - i;
+    break;
+  }
+  for (i = 0; i < nOnly; i++) {
+    for (j = 0; (j < NBENCHES) && strcmp(ppszOnly[i], benches[j].pszName); j++) ;
+    if (j == NBENCHES) {
+      fprintf(stderr, "Error: Unknown routine: %s\n", ppszOnly[i]);
+      return 1;
+    }
+  }
+
+  putenv("TZ=UTC");		/* So that parsetime() does the same work everywhere */
+  init_corpora();
+  lineWidth = 80;		/* Instead of the screen width */
+
+  record_init(&rec, iFormat, runFields);
+  fwrite(rec.szBuf, 1, record_header(&rec), stdout);
+  record_begin(&rec);
+  record_str(&rec, "todaybench");
+  record_str(&rec, VERSION);
+  record_str(&rec, EXE_OS_NAME);
+  record_int(&rec, NDATES);
+  record_int(&rec, NLOCS);
+  record_int(&rec, msMin);
+  fwrite(rec.szBuf, 1, record_end(&rec), stdout);
+
+  record_init(&rec, iFormat, fields);
+  fwrite(rec.szBuf, 1, record_header(&rec), stdout);
+  for (j = 0; j < NBENCHES; j++) {
+    KERNEL pKernel = benches[j].pKernel;
+    int iSize = benches[j].iSize;
+    long n = NDATES;
+    double ns;
+#ifdef COUNT_ALLOCS
+    long nAllocs0;
+#endif
+
+    for (i = 0; (i < nOnly) && strcmp(ppszOnly[i], benches[j].pszName); i++) ;
+    if (nOnly && (i == nOnly)) continue;
+
+    fflush(stdout);
+    if (pKernel == k_output) {	/* Send the output() text to the null device */
+      int fdNull = open(NULL_DEVICE, O_WRONLY);
+      fdStdout = dup(1);
+      if ((fdNull >= 0) && (fdStdout >= 0)) dup2(fdNull, 1);
+      if (fdNull >= 0) close(fdNull);
+    }
+
+    run(pKernel, iSize, NDATES);	/* Warm up the caches, and load the tables */
+    for (;;) {
+#ifdef COUNT_ALLOCS
+      nAllocs0 = nAllocs;
+#endif
+      ns = run(pKernel, iSize, n);
+      if ((ns >= msMin * 1e6) || (n >= 0x40000000L)) break;
+      n *= 2;
+    }
+
+    if (fdStdout >= 0) {	/* Restore stdout */
+      out_flush();
+      fflush(stdout);
+      dup2(fdStdout, 1);
+      close(fdStdout);
+      fdStdout = -1;
+    }
+
+    record_begin(&rec);
+    record_str(&rec, benches[j].pszName);
+    if (iSize) record_int(&rec, iSize); else record_null(&rec);
+    record_int(&rec, n);
+    record_num(&rec, ns / n, 1);
+#ifdef COUNT_ALLOCS
+    record_num(&rec, (double)(nAllocs - nAllocs0) / n, 3);
+#else
+    record_null(&rec);
+#endif
+    fwrite(rec.szBuf, 1, record_end(&rec), stdout);
+  }
+
+  return 0;
+}
@@ -0,0 +1,139 @@
+/*
+** todaybox.c - Multi-call program, combining all the today programs
+**
+** Like busybox, this single executable contains the sunrise, sunset, today,
+** potm, localtime, and stars programs, and runs the one named by argv[0].
+** The Makefile install target installs it, with symbolic links named after
+** each program. So the engine code is loaded only once in memory and on disk,
+** for all the programs.
+**
+** It can also be run as "todaybox PROGRAM [OPTIONS] [ARGUMENTS]".
+**
+** The programs sources are compiled with -DMULTICALL, which renames their
+** main() and usage() routines to PROGRAM_main() and PROGRAM_usage().
+**
+** Authors:
+**   JFL jf.larvoire@free.fr
+**
+** History:
+**   2026-10-19 JFL Created this program.
+**		    Exit with 1 when run with no arguments under an unknown name.
+*/
+
+#define VERSION "2026-10-19"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "versions.h"
+
+#define streq(s1, s2) (!strcmp(s1, s2))
+
+typedef int (*MAIN)(int argc, char *argv[]);
+
+extern int sunrise_main(int argc, char *argv[]);
+extern int sunset_main(int argc, char *argv[]);
+extern int today_main(int argc, char *argv[]);
+extern int potm_main(int argc, char *argv[]);
+extern int localtime_main(int argc, char *argv[]);
+extern int stars_main(int argc, char *argv[]);
+
+static const struct {		/* The programs in this executable */
+  const char *pszName;
+  MAIN pMain;
+} programs[] = {
+  {"sunrise", sunrise_main},
+  {"sunset", sunset_main},
+  {"today", today_main},
+  {"potm", potm_main},
+  {"localtime", localtime_main},
+  {"stars", stars_main},
+};
+#define NPROGRAMS (sizeof(programs) / sizeof(programs[0]))
+
+void usage() {
+  size_t i;
+
+  printf("\
+todaybox - Multi-call program, combining all the today programs\n\
+\n\
+Usage: PROGRAM [OPTIONS] [ARGUMENTS]\n\
+   or: todaybox PROGRAM [OPTIONS] [ARGUMENTS]\n\
+   or: todaybox [OPTIONS]\n\
+\n\
+Options:\n\
+  -?|-h|--help      Display this help screen\n\
+  -l|--list         List the programs, one per line\n\
+  -V|--version      Display the program version\n\
+\n\
+Programs:");
+  for (i = 0; i < NPROGRAMS; i++) printf(" %s", programs[i].pszName);
+  printf("\n\
+Run PROGRAM -h for help about each one.\n\
+"
+#ifdef __unix__
+"\n"
+#endif
+);
+}
+
+/* Find a program by name. Return NULL if not found */
+static MAIN find_program(const char *pszName) {
+  size_t i;
+
+  for (i = 0; i < NPROGRAMS; i++) {
+    if (streq(pszName, programs[i].pszName)) return programs[i].pMain;
+  }
+  return NULL;
+}
+
+int main(int argc, char *argv[]) {
+  char szName[32];
+  const char *pszName = argv[0];
+  const char *psz;
+  size_t l;
+  MAIN pMain;
+  size_t i;
+
+  /* Get the base name of the command, without the path and the extension */
+  for (psz = pszName; *psz; psz++) {
+    if ((*psz == '/') || (*psz == '\\') || (*psz == ':')) pszName = psz + 1;
+  }
+  l = strcspn(pszName, ".");	/* Remove the .exe extension in Windows */
+  if (l >= sizeof(szName)) l = sizeof(szName) - 1;
+  memcpy(szName, pszName, l);
+  szName[l] = '\0';
+  pMain = find_program(szName);
+  if (pMain) return pMain(argc, argv);
+
+  /* Else this is todaybox itself */
+  if ((argc > 1) && ((pMain = find_program(argv[1])) != NULL)) {
+    return pMain(argc - 1, argv + 1);
+  }
+  if ((argc > 1) && (   streq(argv[1], "-l")
+		     || streq(argv[1], "--list"))) {
+    for (i = 0; i < NPROGRAMS; i++) printf("%s\n", programs[i].pszName);
+    return 0;
+  }
+  if ((argc > 1) && (   streq(argv[1], "-V")
+		     || streq(argv[1], "--version"))) {
+    printf(VERSION " " EXE_OS_NAME "\n");
+    return 0;
+  }
+  if ((argc == 1) && strncmp(szName, "todaybox", 8)) {	/* Ex: A bad link name */
+    fprintf(stderr, "Error: Unknown program: %s\n", szName);
+    return 1;
+  }
+  if (   (argc == 1)
+      || streq(argv[1], "-?")
+#if defined(_MSDOS) || defined(_WIN32)
+      || streq(argv[1], "/?")
+#endif
+      || streq(argv[1], "-h")
+      || streq(argv[1], "--help")) {
+    usage();
+    return 0;
+  }
+  fprintf(stderr, "Error: Unknown program: %s\n", argv[1]);
+  return 1;
+}
@@ -0,0 +1,260 @@
+/*
+** todayc.c - Client for the todayd daemon, for tests and benchmarks
+**
+** Sends requests to todayd, and outputs its responses. The requests are
+** the command line arguments, or else the lines read from stdin. All are
+** sent without waiting for the responses, which are read at the same time.
+**
+** With option -b, sends the same request many times, and reports the
+** throughput with all requests pipelined, then the round-trip latency with
+** one request at a time.
+**
+** Linux only, like todayd.
+**
+** Authors:
+**   JFL jf.larvoire@free.fr
+**
+** History:
+**   2026-10-19 JFL Created this program.
+*/
+
+#define VERSION "2026-10-19"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "versions.h"
+
+#define streq(s1, s2) (!strcmp(s1, s2))
+
+#define DEFAULT_SOCKET	"/tmp/todayd.sock"
+#define BUF_SIZE	65536
+#define WINDOW		1024	/* Maximum number of requests in flight */
+
+void usage() {
+  printf("\
+todayc - Client for the todayd daemon, for tests and benchmarks\n\
+\n\
+Usage: todayc [OPTIONS] [REQUEST ...]\n\
+\n\
+Options:\n\
+  -?|-h|--help      Display this help screen\n\
+  -b N              Benchmark: Send the request N times, and report the speed\n\
+  -s PATHNAME       Socket name. Default: " DEFAULT_SOCKET "\n\
+  -V|--version      Display the program version\n\
+\n\
+Requests: See todayd -h. Default: Read them from stdin, one per line.\n\
+"
+#ifdef __unix__
+"\n"
+#endif
+);
+}
+
+static double now_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* Write a whole buffer. Return 0 if OK */
+static int write_all(int fd, const char *buf, size_t n) {
+  while (n) {
+    ssize_t l = write(fd, buf, n);
+    if (l < 0) {
+      if (errno == EINTR) continue;
+      return 1;
+    }
+    buf += l;
+    n -= (size_t)l;
+  }
+  return 0;
+}
+
+/* Copy the requests from fdIn to the daemon, and its responses to stdout */
+static int relay(int sfd, int fdIn, const char *pszReqs) {
+  char buf[BUF_SIZE];
+  char in[BUF_SIZE];
+  const char *pPend = pszReqs;	/* Requests not sent yet */
+  size_t nPend = pszReqs ? strlen(pszReqs) : 0;
+  int iInDone = (pszReqs != NULL);
+
+  if (!nPend && iInDone) shutdown(sfd, SHUT_WR);
+  for (;;) {
+    struct pollfd pfd[2];
+    int n = 1;
+    pfd[0].fd = sfd;
+    pfd[0].events = POLLIN | (nPend ? POLLOUT : 0);
+    if (!nPend && !iInDone) {	/* Read more requests only when the previous ones are sent */
+      pfd[1].fd = fdIn;
+      pfd[1].events = POLLIN;
+      n++;
+    }
+    if (poll(pfd, n, -1) < 0) {
+      if (errno == EINTR) continue;
+      return 1;
+    }
+    if ((n > 1) && (pfd[1].revents & (POLLIN | POLLHUP))) {
+      ssize_t l = read(fdIn, in, sizeof(in));
+      if (l > 0) {
+	pPend = in;
+	nPend = (size_t)l;
+      } else {
+	iInDone = 1;
+	shutdown(sfd, SHUT_WR);
+      }
+    }
+    if (nPend && (pfd[0].revents & POLLOUT)) {	/* Never block, else the daemon might block too */
+      ssize_t l = send(sfd, pPend, nPend, MSG_DONTWAIT | MSG_NOSIGNAL);
+      if ((l < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) return 1;
+      if (l > 0) {
+	pPend += l;
+	nPend -= (size_t)l;
+	if (!nPend && iInDone) shutdown(sfd, SHUT_WR);
+      }
+    }
+    if (pfd[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+      ssize_t l = read(sfd, buf, sizeof(buf));
+      if (l <= 0) return (l < 0);
+      if (write_all(1, buf, l)) return 1;
+    }
+  }
+}
+
+/* Send a request n times pipelined, then n/10 times one at a time */
+static int bench(int sfd, const char *pszReq, long n) {
+  char buf[BUF_SIZE];
+  size_t l = strlen(pszReq);
+  long nSent = 0, nRecv = 0;
+  double t0, t1;
+  char *pszBatch;
+  long nBatch = WINDOW / 2;	/* So that sends never block on a full socket */
+  long i;
+
+  pszBatch = malloc(nBatch * (l + 1));
+  if (!pszBatch) return 1;
+  for (i = 0; i < nBatch; i++) {
+    memcpy(pszBatch + i * (l + 1), pszReq, l);
+    pszBatch[i * (l + 1) + l] = '\n';
+  }
+
+  t0 = now_us();
+  while (nRecv < n) {
+    struct pollfd pfd;
+    pfd.fd = sfd;
+    pfd.events = POLLIN | (((nSent < n) && (nSent - nRecv <= WINDOW - nBatch)) ? POLLOUT : 0);
+    if (poll(&pfd, 1, -1) < 0) return 1;
+    if (pfd.events & pfd.revents & POLLOUT) {
+      long k = (n - nSent < nBatch) ? n - nSent : nBatch;
+      if (write_all(sfd, pszBatch, k * (l + 1))) return 1;
+      nSent += k;
+    }
+    if (pfd.revents & POLLIN) {
+      ssize_t r = read(sfd, buf, sizeof(buf));
+      if (r <= 0) return 1;
+      for (i = 0; i < r; i++) nRecv += (buf[i] == '\n');
+    }
+  }
+  t1 = now_us();
+  printf("Pipelined: %ld requests in %.3f s = %.0f requests/s\n", n, (t1 - t0) / 1e6, n / ((t1 - t0) / 1e6));
+
+  n = (n + 9) / 10;
+  t0 = now_us();
+  for (nRecv = 0; nRecv < n; nRecv++) {
+    ssize_t r;
+    if (write_all(sfd, pszBatch, l + 1)) return 1;
+    do {
+      r = read(sfd, buf, sizeof(buf));
+    } while ((r > 0) && (buf[r-1] != '\n'));
+    if (r <= 0) return 1;
+  }
+  t1 = now_us();
+  printf("One at a time: %ld requests, %.1f us per round trip\n", n, (t1 - t0) / n);
+  printf("Last response: %.*s", (int)(strchr(buf, '\n') - buf + 1), buf);
+  free(pszBatch);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  int i;
+  char *pszSocket = DEFAULT_SOCKET;
+  long nBench = 0;
+  struct sockaddr_un sa;
+  char *pszReqs = NULL;
+  size_t nReqs = 0;
+  int sfd;
+
+  for (i=1; i<argc; i++) {
+    char *arg = argv[i];
+    if (   streq(arg, "-?")
+        || streq(arg, "-h")
+        || streq(arg, "--help")) {
+      usage();
+      return 0;
+    }
+    if (streq(arg, "-b") && ((i+1)<argc)) {
+      nBench = atol(argv[++i]);
+      continue;
+    }
+    if (streq(arg, "-s") && ((i+1)<argc)) {
+      pszSocket = argv[++i];
+      continue;
+    }
+    if (   streq(arg, "-V")
+	|| streq(arg, "--version")) {
+      printf(VERSION " " EXE_OS_NAME "\n");
+      return 0;
+    }
+    if ((arg[0] == '-') && arg[1]) {
+      fprintf(stderr, "Unexpected option: %s\n", arg);
+      return 1;
+    }
+    break;			/* The requests begin here */
+  }
+  for ( ; i < argc; i++) {	/* Join the requests, one per line */
+    size_t l = strlen(argv[i]);
+    char *psz = realloc(pszReqs, nReqs + l + 2);
+    if (!psz) return 1;
+    pszReqs = psz;
+    memcpy(pszReqs + nReqs, argv[i], l);
+    nReqs += l;
+    pszReqs[nReqs++] = '\n';
+    pszReqs[nReqs] = '\0';
+  }
+  if (nBench && !pszReqs) {
+    fprintf(stderr, "Error: No request to benchmark\n");
+    return 1;
+  }
+
+  if (strlen(pszSocket) >= sizeof(sa.sun_path)) {
+    fprintf(stderr, "Error: Socket name too long: %s\n", pszSocket);
+    return 1;
+  }
+  memset(&sa, 0, sizeof(sa));
+  sa.sun_family = AF_UNIX;
+  strcpy(sa.sun_path, pszSocket);
+  sfd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if ((sfd < 0) || connect(sfd, (struct sockaddr *)&sa, sizeof(sa))) {
+    fprintf(stderr, "Error: Can't connect to %s: %s\n", pszSocket, strerror(errno));
+    return 1;
+  }
+
+  if (nBench) {
+    pszReqs[strlen(pszReqs) - 1] = '\0';	/* Only the first request is used */
+    if (strchr(pszReqs, '\n')) *strchr(pszReqs, '\n') = '\0';
+    i = bench(sfd, pszReqs, nBench);
+  } else {
+    i = relay(sfd, 0, pszReqs);
+  }
+  if (i) fprintf(stderr, "Error: Connection to %s failed\n", pszSocket);
+  close(sfd);
+  return i;
+}
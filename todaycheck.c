@@ -0,0 +1,680 @@
+/*
+** todaycheck.c - Accuracy versus speed checks of the engines, with golden tables
+**
+** Compares the results of each sun and moon engine with a golden table of
+** sunrise, sunset, and moon illumination, over a grid of latitudes from the
+** Equator to beyond the polar circles, longitudes, and dates from 1600 to
+** 2900. For each engine, reports the distribution of the errors, the number
+** of flipped results (Polar day/night status, or moon phase name), and the
+** time per call. So that any faster code path can be checked for accuracy
+** before it's adopted.
+**
+** The golden table golden.csv is generated once with option -g, by the
+** high-precision reference mode of this program:
+**   - The sunrise and sunset are the times when the Sun center apparent
+**     altitude is -0.8333 degrees (Refraction and semi-diameter), found by
+**     bisection to 0.01s, with the Meeus Sun apparent longitude, and Delta T.
+**   - The illumination is that of the ELP-2000/82 moon theory, at 00:00 UT
+**     converted to TT with Delta T.
+** It's then kept in the sources, and all checks run offline.
+**
+** The limits of these errors are those of the least accurate results, near
+** the polar circles. So the results of each engine are also saved once in
+** engines.csv, with option -s, and compared row by row with option -r. Any
+** result that moves by more than a few seconds, or any flipped status or
+** phase name, is a regression, even where the errors are small.
+**
+** The exit code is 1 if any error exceeds the limits, or if any result changed,
+** for use in make check.
+**
+** Authors:
+**   JFL jf.larvoire@free.fr
+**
+** History:
+**   2026-10-19 JFL Created this program.
+**		    Added options -s and -r, for the row by row regression checks
+**		    against the saved results of the engines.
+*/
+
+#define VERSION "2026-10-19"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "today.h"
+#include "moontx.h"
+#include "versions.h"
+
+#define streq(s1, s2) (!strcmp(s1, s2))
+
+#define DEFAULT_GOLDEN	"golden.csv"
+#define MAXROWS		10000
+#define H0		(-0.8333)	/* Sun center altitude at rise & set, in degrees */
+#define J2000		2451545.0
+
+/* The grid of the golden table */
+static const double gridLats[] = {-70, -60, -45, -30, -15, 0, 15, 30, 45, 60, 65, 70};
+static const double gridLons[] = {-150, -75, 0, 135};	/* +=East */
+#define NLATS (sizeof(gridLats) / sizeof(gridLats[0]))
+#define NLONS (sizeof(gridLons) / sizeof(gridLons[0]))
+#define NGRIDDATES 24
+
+typedef struct _ROW {		/* One point of the grid, and its results */
+  int y, m, d;			/* Local date */
+  double lat, lon;		/* Latitude +=North, longitude +=East */
+  int offset;			/* Local time UTC offset, in hours East */
+  int status;			/* RS_RISES, RS_CIRCUMPOLAR, or RS_NEVER_RISES */
+  double rise, set;		/* Local times, in hours. NaN if none */
+  double illum;			/* Moon illuminated %, at 00:00 UT */
+  const char *phase;		/* Moon phase name */
+} ROW;
+
+typedef void (*ENGINE)(const ROW *pIn, ROW *pOut);
+
+static ROW golden[MAXROWS];
+static int nRows = 0;
+
+static const char * const phases[] = {
+  "new", "waxing_crescent", "first_quarter", "waxing_gibbous",
+  "full", "waning_gibbous", "last_quarter", "waning_crescent"
+};
+#define NPHASES (sizeof(phases) / sizeof(phases[0]))
+
+/* Limits of the errors, above which the check fails. They're the current
+   errors of the engines, with a margin. The largest sun errors are near the
+   polar circles, where the Sun grazes the horizon at sunrise and sunset. */
+#define SUN_LIMIT_MAX	60.0	/* Sunrise and sunset maximum error, in minutes */
+#define SUN_LIMIT_P99	12.0	/* Same, for the 99th percentile */
+#define SUN_LIMIT_FLIPS	10	/* Polar day/night status differences */
+#define MOON_LIMIT_MAX	1.5	/* Illumination maximum error, in % */
+#define MOON_LIMIT_P99	1.0	/* Same, for the 99th percentile */
+#define MOON_LIMIT_FLIPS 16	/* Phase names differences */
+
+/* Differences with the saved results of the same engine, above which the
+   result changed. Well above the rounding of the saved values. */
+#define SUN_CHANGE_MAX	0.05	/* Sunrise and sunset, in minutes. 3 seconds */
+#define MOON_CHANGE_MAX	0.001	/* Illumination, in % */
+
+static const double bins[] = {0.1, 0.5, 1, 2, 5, 10};	/* Histogram upper bounds */
+#define NBINS (sizeof(bins) / sizeof(bins[0]))
+
+void usage() {
+  printf("\
+todaycheck - Accuracy versus speed checks of the engines, with golden tables\n\
+\n\
+Usage: todaycheck [OPTIONS]\n\
+\n\
+Options:\n\
+  -?|-h|--help      Display this help screen\n\
+  -f PATHNAME       Golden table to check against. Default: " DEFAULT_GOLDEN "\n\
+  --format=jsonl|csv Output one record per engine and result. Default: Text\n\
+  -g PATHNAME       Generate the golden table with the reference mode\n\
+  -r PATHNAME       Check that no result changed from the saved ones\n\
+  -s PATHNAME       Save the results of all engines, for option -r\n\
+  -t MS             Minimum time for timing each engine, in ms. Default: 200\n\
+  -V|--version      Display the program version\n\
+\n\
+Exit code: 0 if all errors are within the limits, and no result changed, else 1.\n\
+\n\
+");
+}
+
+/* Sun center apparent altitude, in degrees, at a given UT Julian Day */
+static double sun_altitude(double jd, double lat, double lon) {
+  double jde = jd + delta_t(jd) / 86400.0;
+  double T = (jde - J2000) / 36525.0;
+  double lambda = dtor(solar_lon_apparent(jde));
+  double eps = dtor(23.4392911 - 0.0130042 * T + 0.00256 * cos(dtor(125.04 - 1934.136 * T)));
+  double alpha = atan2(cos(eps) * sin(lambda), cos(lambda));
+  double delta = asin(sin(eps) * sin(lambda));
+  double Tu = (jd - J2000) / 36525.0;
+  double theta = 280.46061837 + 360.98564736629 * (jd - J2000) + 0.000387933 * Tu * Tu; /* GMST */
+  double H = dtor(theta + lon) - alpha;
+  double phi = dtor(lat);
+
+  return asin(sin(phi) * sin(delta) + cos(phi) * cos(delta) * cos(H)) * 180.0 / PI;
+}
+
+/* Find the time in [jd1, jd2] when the altitude crosses H0. Return NaN if none */
+static double crossing(double jd1, double jd2, int iRising, double lat, double lon) {
+  double step = 10.0 / 1440;	/* 10 minutes */
+  double jd, a1, a2;
+
+  a1 = sun_altitude(jd1, lat, lon) - H0;
+  for (jd = jd1; jd < jd2; jd += step, a1 = a2) {
+    a2 = sun_altitude(jd + step, lat, lon) - H0;
+    if (iRising ? ((a1 < 0) && (a2 >= 0)) : ((a1 >= 0) && (a2 < 0))) {
+      double lo = jd, hi = jd + step;
+      while ((hi - lo) > 0.01 / 86400) {	/* Bisect down to 0.01s */
+	double mid = (lo + hi) / 2;
+	double a = sun_altitude(mid, lat, lon) - H0;
+	if ((a >= 0) == (iRising != 0)) hi = mid; else lo = mid;
+      }
+      return (lo + hi) / 2;
+    }
+  }
+  return NAN;
+}
+
+/* The reference mode: The rise in the 12 hours before the mean solar noon, and the set after it */
+static void e_reference(const ROW *pIn, ROW *pOut) {
+  double jd0 = J2000 - 0.5 + days_from_civil(pIn->y, pIn->m, pIn->d) - days_from_civil(2000, 1, 1);
+  double jdNoon = jd0 + (12.0 - pIn->lon / 15.0) / 24.0;	/* Mean solar noon, UT */
+  double jdRise = crossing(jdNoon - 0.5, jdNoon, 1, pIn->lat, pIn->lon);
+  double jdSet = crossing(jdNoon, jdNoon + 0.5, 0, pIn->lat, pIn->lon);
+
+  *pOut = *pIn;
+  if ((jdRise == jdRise) && (jdSet == jdSet)) {
+    pOut->status = RS_RISES;
+    pOut->rise = fmod((jdRise - jd0) * 24.0 + pIn->offset + 48.0, 24.0);
+    pOut->set = fmod((jdSet - jd0) * 24.0 + pIn->offset + 48.0, 24.0);
+  } else {
+    pOut->status = (sun_altitude(jdNoon, pIn->lat, pIn->lon) > H0) ? RS_CIRCUMPOLAR : RS_NEVER_RISES;
+    pOut->rise = pOut->set = NAN;
+  }
+}
+
+/* The sun engine of all programs */
+static void e_sun(const ROW *pIn, ROW *pOut) {
+  LOCATION loc;
+  struct tm stm;
+  SUNDAY sd;
+
+  *pOut = *pIn;
+  memset(&loc, 0, sizeof(loc));
+  loc.lat = pIn->lat;
+  loc.lon = -pIn->lon;
+  loc.tz = -pIn->offset;
+  memset(&stm, 0, sizeof(stm));
+  stm.tm_year = pIn->y - 1900;
+  stm.tm_mon = pIn->m - 1;
+  stm.tm_mday = pIn->d;
+  stm.tm_hour = 12;
+  sun_day_at(&loc, &stm, &sd);
+  pOut->status = sd.state;
+  pOut->rise = (sd.state == RS_RISES) ? sd.rise : NAN;
+  pOut->set = (sd.state == RS_RISES) ? sd.set : NAN;
+}
+
+/* The moon engines, at 00:00 UT, through the routine used by all programs */
+static void moon_with(double (*pfn)(double days), const ROW *pIn, ROW *pOut) {
+  struct tm stm;
+  int waxing;
+
+  *pOut = *pIn;
+  utc_to_tm((time_t)days_from_civil(pIn->y, pIn->m, pIn->d) * 86400, 0, 0, &stm);
+  pOut->illum = moon_illum_with(pfn, &stm, &waxing);
+  pOut->phase = moon_phase_name(pOut->illum, waxing);
+}
+
+/* The moon reference: ELP-2000/82 at the JDE corresponding to 00:00 UT */
+static void moon_reference(const ROW *pIn, ROW *pOut) {
+  double jd = J2000 - 0.5 + days_from_civil(pIn->y, pIn->m, pIn->d) - days_from_civil(2000, 1, 1);
+  double jde = jd + delta_t(jd) / 86400.0;
+
+  *pOut = *pIn;
+  pOut->illum = moon_illum_elp(jde);
+  pOut->phase = moon_phase_name(pOut->illum, moon_illum_elp(jde + 1.0 / 24) > pOut->illum);
+}
+
+static void e_potm(const ROW *pIn, ROW *pOut) {
+  moon_with(potm, pIn, pOut);
+}
+
+static void e_potm_elp(const ROW *pIn, ROW *pOut) {
+  moon_with(potm_elp, pIn, pOut);
+}
+
+#define SUN	1
+#define MOON	2
+static const struct {
+  const char *pszName;
+  int iKind;			/* SUN or MOON */
+  ENGINE pEngine;
+} engines[] = {
+  {"reference",	SUN,	e_reference},
+  {"sun",	SUN,	e_sun},
+  {"potm_elp",	MOON,	e_potm_elp},
+  {"potm",	MOON,	e_potm},
+};
+#define NENGINES (sizeof(engines) / sizeof(engines[0]))
+
+/* Generate the golden table */
+static int generate(const char *pszFile) {
+  static const char * const fields[] = {
+    "date", "lat", "lon", "utc_offset", "status", "rise", "set", "illumination", "phase", NULL
+  };
+  long day0 = days_from_civil(1600, 1, 1);
+  long span = days_from_civil(2900, 12, 31) + 1 - day0;
+  FILE *hf = fopen(pszFile, "w");
+  RECORD rec;
+  size_t iLat, iLon;
+  int i;
+
+  if (!hf) {
+    fprintf(stderr, "Error: Can't create %s\n", pszFile);
+    return 1;
+  }
+  record_init(&rec, FMT_CSV, fields);
+  fwrite(rec.szBuf, 1, record_header(&rec), hf);
+  for (i = 0; i < NGRIDDATES; i++) {
+    long day = day0 + (long)((double)span * (i + 0.5) / NGRIDDATES);
+    for (iLat = 0; iLat < NLATS; iLat++) {
+      for (iLon = 0; iLon < NLONS; iLon++) {
+	ROW in, out;
+	civil_from_days(day + (long)(iLat * 5 + iLon * 11), &in.y, &in.m, &in.d);	/* Vary the seasons */
+	in.lat = gridLats[iLat];
+	in.lon = gridLons[iLon];
+	in.offset = (int)floor(in.lon / 15.0 + 0.5);
+	e_reference(&in, &out);
+	moon_reference(&out, &out);
+	record_begin(&rec);
+	record_date(&rec, out.y, out.m, out.d);
+	record_num(&rec, out.lat, 2);
+	record_num(&rec, out.lon, 2);
+	record_int(&rec, out.offset);
+	record_str(&rec, (out.status == RS_RISES) ? "ok" : (out.status == RS_CIRCUMPOLAR) ? "polar_day" : "polar_night");
+	record_num(&rec, out.rise, 6);	/* NaN = null */
+	record_num(&rec, out.set, 6);
+	record_num(&rec, out.illum, 4);
+	record_str(&rec, out.phase);
+	fwrite(rec.szBuf, 1, record_end(&rec), hf);
+      }
+    }
+  }
+  fclose(hf);
+  return 0;
+}
+
+/* Split a CSV line into at most nMax fields. Return the number of fields */
+static int split_csv(char *p, char *pField[], int nMax) {
+  int n;
+
+  for (n = 0; n < nMax; ) {
+    pField[n++] = p;
+    p += strcspn(p, ",\r\n");
+    if (!*p) break;
+    *(p++) = '\0';
+  }
+  return n;
+}
+
+/* Get a phase name constant, for comparing them with pointers */
+static const char *phase_name(const char *pszName) {
+  size_t j;
+
+  for (j = 0; j < NPHASES; j++) {
+    if (streq(pszName, phases[j])) return phases[j];
+  }
+  return "";
+}
+
+/* Load the golden table */
+static int load(const char *pszFile) {
+  char line[256];
+  FILE *hf = fopen(pszFile, "r");
+  int iLine = 0;
+
+  if (!hf) {
+    fprintf(stderr, "Error: Can't open %s\n", pszFile);
+    return 1;
+  }
+  while (fgets(line, sizeof(line), hf)) {
+    char *pField[9];
+    ROW *pr = &golden[nRows];
+    int n;
+
+    if (!iLine++) continue;	/* Skip the header */
+    n = split_csv(line, pField, 9);
+    if ((n < 9) || (nRows == MAXROWS) || (sscanf(pField[0], "%d-%d-%d", &pr->y, &pr->m, &pr->d) != 3)) {
+      fprintf(stderr, "Error: Invalid line %d in %s\n", iLine, pszFile);
+      fclose(hf);
+      return 1;
+    }
+    pr->lat = atof(pField[1]);
+    pr->lon = atof(pField[2]);
+    pr->offset = atoi(pField[3]);
+    pr->status = streq(pField[4], "ok") ? RS_RISES : streq(pField[4], "polar_day") ? RS_CIRCUMPOLAR : RS_NEVER_RISES;
+    pr->rise = *pField[5] ? atof(pField[5]) : NAN;
+    pr->set = *pField[6] ? atof(pField[6]) : NAN;
+    pr->illum = atof(pField[7]);
+    pr->phase = phase_name(pField[8]);
+    nRows++;
+  }
+  fclose(hf);
+  if (!nRows) {
+    fprintf(stderr, "Error: No data in %s\n", pszFile);
+    return 1;
+  }
+  return 0;
+}
+
+/* Save the results of all engines for all the golden rows */
+static int save_results(const char *pszFile) {
+  static const char * const fields[] = {
+    "engine", "date", "lat", "lon", "status", "rise", "set", "illumination", "phase", NULL
+  };
+  FILE *hf = fopen(pszFile, "w");
+  RECORD rec;
+  size_t j;
+  int i;
+
+  if (!hf) {
+    fprintf(stderr, "Error: Can't create %s\n", pszFile);
+    return 1;
+  }
+  record_init(&rec, FMT_CSV, fields);
+  fwrite(rec.szBuf, 1, record_header(&rec), hf);
+  for (j = 0; j < NENGINES; j++) {
+    for (i = 0; i < nRows; i++) {
+      ROW out;
+      (*engines[j].pEngine)(&golden[i], &out);
+      record_begin(&rec);
+      record_str(&rec, engines[j].pszName);
+      record_date(&rec, out.y, out.m, out.d);
+      record_num(&rec, out.lat, 2);
+      record_num(&rec, out.lon, 2);
+      if (engines[j].iKind == SUN) {
+	record_str(&rec, (out.status == RS_RISES) ? "ok" : (out.status == RS_CIRCUMPOLAR) ? "polar_day" : "polar_night");
+	record_num(&rec, out.rise, 6);	/* NaN = null */
+	record_num(&rec, out.set, 6);
+	record_null(&rec);
+	record_null(&rec);
+      } else {
+	record_null(&rec);
+	record_null(&rec);
+	record_null(&rec);
+	record_num(&rec, out.illum, 6);
+	record_str(&rec, out.phase);
+      }
+      fwrite(rec.szBuf, 1, record_end(&rec), hf);
+    }
+  }
+  fclose(hf);
+  return 0;
+}
+
+/* Load the saved results of the engines. They must be for the same golden rows */
+static int load_results(const char *pszFile, ROW saved[NENGINES][MAXROWS], int nSaved[NENGINES]) {
+  char line[256];
+  FILE *hf = fopen(pszFile, "r");
+  int iLine = 0;
+  size_t j;
+
+  if (!hf) {
+    fprintf(stderr, "Error: Can't open %s\n", pszFile);
+    return 1;
+  }
+  while (fgets(line, sizeof(line), hf)) {
+    char *pField[9];
+    ROW *pr = NULL;
+
+    if (!iLine++) continue;	/* Skip the header */
+    if (split_csv(line, pField, 9) == 9) {
+      for (j = 0; j < NENGINES; j++) {
+	if (streq(pField[0], engines[j].pszName) && (nSaved[j] < nRows)) {
+	  pr = &saved[j][nSaved[j]];
+	  break;
+	}
+      }
+    }
+    if (!pr || (sscanf(pField[1], "%d-%d-%d", &pr->y, &pr->m, &pr->d) != 3)
+	|| (pr->y != golden[nSaved[j]].y) || (pr->m != golden[nSaved[j]].m) || (pr->d != golden[nSaved[j]].d)
+	|| (atof(pField[2]) != golden[nSaved[j]].lat) || (atof(pField[3]) != golden[nSaved[j]].lon)) {
+      fprintf(stderr, "Error: Invalid line %d in %s, or not for the same golden table\n", iLine, pszFile);
+      fclose(hf);
+      return 1;
+    }
+    pr->lat = atof(pField[2]);
+    pr->lon = atof(pField[3]);
+    pr->status = streq(pField[4], "ok") ? RS_RISES : streq(pField[4], "polar_day") ? RS_CIRCUMPOLAR : RS_NEVER_RISES;
+    pr->rise = *pField[5] ? atof(pField[5]) : NAN;
+    pr->set = *pField[6] ? atof(pField[6]) : NAN;
+    pr->illum = *pField[7] ? atof(pField[7]) : NAN;
+    pr->phase = phase_name(pField[8]);
+    nSaved[j]++;
+  }
+  fclose(hf);
+  for (j = 0; j < NENGINES; j++) {
+    if (nSaved[j] != nRows) {
+      fprintf(stderr, "Error: Missing %s results in %s\n", engines[j].pszName, pszFile);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int cmp_double(const void *p1, const void *p2) {
+  double d1 = *(const double *)p1, d2 = *(const double *)p2;
+  return (d1 > d2) - (d1 < d2);
+}
+
+typedef struct _STATS {		/* Distribution of the errors of one result */
+  const char *pszEngine;
+  const char *pszResult;
+  const char *pszUnit;
+  int n;			/* Number of errors measured */
+  double max, p99, mean;
+  long hist[NBINS + 1];		/* Errors <= bins[i], and the rest */
+  int nFlips;			/* Mismatched statuses or phase names */
+  int nChanged;			/* Results changed from the saved ones. -1 = Not checked */
+  double ns;			/* Time per call of the engine */
+  double limit;			/* Maximum error allowed */
+  double p99Limit;		/* Maximum 99th percentile allowed */
+  int flipLimit;		/* Maximum number of flips allowed */
+} STATS;
+
+static void stats(STATS *ps, double *pErr, int n) {
+  int i;
+  size_t j;
+
+  ps->n = n;
+  ps->max = ps->p99 = ps->mean = 0;
+  memset(ps->hist, 0, sizeof(ps->hist));
+  if (!n) return;
+  qsort(pErr, n, sizeof(double), cmp_double);
+  ps->max = pErr[n - 1];
+  ps->p99 = pErr[(int)ceil(0.99 * n) - 1];
+  for (i = 0; i < n; i++) {
+    ps->mean += pErr[i] / n;
+    for (j = 0; (j < NBINS) && (pErr[i] > bins[j]); j++) ;
+    ps->hist[j]++;
+  }
+}
+
+/* Time an engine over the whole grid. Return the ns per call */
+static double timeit(ENGINE pEngine, long msMin) {
+  clock_t t0, t1;
+  long nLoops = 1, l;
+  ROW out;
+  int i;
+
+  for (;;) {
+    t0 = clock();
+    for (l = 0; l < nLoops; l++) {
+      for (i = 0; i < nRows; i++) (*pEngine)(&golden[i], &out);
+    }
+    t1 = clock();
+    if (((t1 - t0) >= msMin * (CLOCKS_PER_SEC / 1000)) || (nLoops >= 0x100000L)) break;
+    nLoops *= 2;
+  }
+  return 1e9 * (double)(t1 - t0) / CLOCKS_PER_SEC / ((double)nLoops * nRows);
+}
+
+/* Circular difference of two local times, in minutes */
+static double diff_minutes(double h1, double h2) {
+  double d = fmod(fabs(h1 - h2), 24.0);
+  if (d > 12.0) d = 24.0 - d;
+  return d * 60.0;
+}
+
+int main(int argc, char *argv[]) {
+  int i;
+  size_t j, k;
+  char *pszGolden = DEFAULT_GOLDEN;
+  char *pszGenerate = NULL;
+  char *pszResults = NULL;
+  char *pszSave = NULL;
+  int iFormat = FMT_TEXT;
+  long msMin = 200;
+  static double err1[MAXROWS], err2[MAXROWS];
+  static ROW saved[NENGINES][MAXROWS];
+  int nSaved[NENGINES] = {0};
+  STATS st[2 * NENGINES];
+  int nStats = 0;
+  int iFailed = 0;
+  RECORD rec;
+  static const char * const fields[] = {
+    "engine", "result", "unit", "rows", "max", "p99", "mean", "le_0.1", "le_0.5",
+    "le_1", "le_2", "le_5", "le_10", "gt_10", "flips", "changed", "ns_per_call", "ok", NULL
+  };
+
+  for (i=1; i<argc; i++) {
+    char *arg = argv[i];
+    if (   streq(arg, "-?")
+        || streq(arg, "-h")
+        || streq(arg, "--help")) {
+      usage();
+      return 0;
+    }
+    if (streq(arg, "-f") && ((i+1)<argc)) {
+      pszGolden = argv[++i];
+      continue;
+    }
+    if (!strncmp(arg, "--format=", 9)) {
+      iFormat = record_format(arg + 9);
+      if (iFormat < 0) {
+	fprintf(stderr, "Error: Unsupported format: %s\n", arg + 9);
+	return 1;
+      }
+      continue;
+    }
+    if (streq(arg, "-g") && ((i+1)<argc)) {
+      pszGenerate = argv[++i];
+      continue;
+    }
+    if (streq(arg, "-r") && ((i+1)<argc)) {
+      pszResults = argv[++i];
+      continue;
+    }
+    if (streq(arg, "-s") && ((i+1)<argc)) {
+      pszSave = argv[++i];
+      continue;
+    }
+    if (streq(arg, "-t") && ((i+1)<argc)) {
+      msMin = atol(argv[++i]);
+      continue;
+    }
+    if (   streq(arg, "-V")
+	|| streq(arg, "--version")) {
+      printf(VERSION " " EXE_OS_NAME "\n");
+      return 0;
+    }
+    fprintf(stderr, "Unexpected argument: %s\n", arg);
+    return 1;
+  }
+
+  if (pszGenerate) return generate(pszGenerate);
+  if (load(pszGolden)) return 1;
+  if (pszSave) return save_results(pszSave);
+  if (pszResults && load_results(pszResults, saved, nSaved)) return 1;
+
+  for (j = 0; j < NENGINES; j++) {
+    ENGINE pEngine = engines[j].pEngine;
+    int n = 0, nFlips = 0;
+    int nChanged = (nSaved[j] == nRows) ? 0 : -1;
+    double ns = timeit(pEngine, msMin);
+
+    for (i = 0; i < nRows; i++) {
+      ROW out;
+      (*pEngine)(&golden[i], &out);
+      if (nChanged >= 0) {
+	const ROW *pr = &saved[j][i];
+	if (engines[j].iKind == SUN) {
+	  nChanged += (out.status != pr->status) || ((out.status == RS_RISES)
+		      && ((diff_minutes(out.rise, pr->rise) > SUN_CHANGE_MAX)
+		       || (diff_minutes(out.set, pr->set) > SUN_CHANGE_MAX)));
+	} else {
+	  nChanged += (fabs(out.illum - pr->illum) > MOON_CHANGE_MAX) || (out.phase != pr->phase);
+	}
+      }
+      if (engines[j].iKind == SUN) {
+	if (out.status != golden[i].status) {
+	  nFlips++;
+	} else if (out.status == RS_RISES) {
+	  err1[n] = diff_minutes(out.rise, golden[i].rise);
+	  err2[n++] = diff_minutes(out.set, golden[i].set);
+	}
+      } else {
+	err1[n++] = fabs(out.illum - golden[i].illum);
+	nFlips += !streq(out.phase, golden[i].phase);
+      }
+    }
+    for (k = 0; k < ((engines[j].iKind == SUN) ? 2U : 1U); k++) {
+      STATS *ps = &st[nStats++];
+      stats(ps, k ? err2 : err1, n);
+      ps->pszEngine = engines[j].pszName;
+      ps->nFlips = nFlips;
+      ps->nChanged = nChanged;
+      ps->ns = ns;
+      if (engines[j].iKind == SUN) {
+	ps->pszResult = k ? "sunset" : "sunrise";
+	ps->pszUnit = "min";
+	ps->limit = SUN_LIMIT_MAX;
+	ps->p99Limit = SUN_LIMIT_P99;
+	ps->flipLimit = SUN_LIMIT_FLIPS;
+      } else {
+	ps->pszResult = "illumination";
+	ps->pszUnit = "%";
+	ps->limit = MOON_LIMIT_MAX;
+	ps->p99Limit = MOON_LIMIT_P99;
+	ps->flipLimit = MOON_LIMIT_FLIPS;
+      }
+    }
+  }
+
+  if (iFormat == FMT_TEXT) {
+    printf("Golden table: %s, %d rows\n\n", pszGolden, nRows);
+    printf("Engine    Result       Unit     Max     P99    Mean  <=0.1  <=0.5    <=1    <=2    <=5   <=10    >10  Flips Changed  ns/call\n");
+  } else {
+    record_init(&rec, iFormat, fields);
+    fwrite(rec.szBuf, 1, record_header(&rec), stdout);
+  }
+  for (i = 0; i < nStats; i++) {
+    STATS *ps = &st[i];
+    int iOK = (ps->max <= ps->limit) && (ps->p99 <= ps->p99Limit) && (ps->nFlips <= ps->flipLimit)
+	      && (ps->nChanged <= 0);
+    if (!iOK) iFailed = 1;
+    if (iFormat == FMT_TEXT) {
+      printf("%-9s %-12s %-4s %7.3f %7.3f %7.3f", ps->pszEngine, ps->pszResult, ps->pszUnit, ps->max, ps->p99, ps->mean);
+      for (j = 0; j <= NBINS; j++) printf(" %6ld", ps->hist[j]);
+      printf(" %6d", ps->nFlips);
+      if (ps->nChanged < 0) printf("       -"); else printf(" %7d", ps->nChanged);
+      printf(" %8.0f%s\n", ps->ns, iOK ? "" : "  FAILED");
+    } else {
+      record_begin(&rec);
+      record_str(&rec, ps->pszEngine);
+      record_str(&rec, ps->pszResult);
+      record_str(&rec, ps->pszUnit);
+      record_int(&rec, ps->n);
+      record_num(&rec, ps->max, 4);
+      record_num(&rec, ps->p99, 4);
+      record_num(&rec, ps->mean, 4);
+      for (j = 0; j <= NBINS; j++) record_int(&rec, ps->hist[j]);
+      record_int(&rec, ps->nFlips);
+      if (ps->nChanged < 0) record_null(&rec); else record_int(&rec, ps->nChanged);
+      record_num(&rec, ps->ns, 1);
+      record_bool(&rec, iOK);
+      fwrite(rec.szBuf, 1, record_end(&rec), stdout);
+    }
+  }
+  if ((iFormat == FMT_TEXT) && iFailed) {
+    printf("\nFAILED: Limits: Sun max %.0f min, p99 %.0f min, %d status flips. Moon max %.1f %%, p99 %.1f %%, %d phase flips\n",
+	   SUN_LIMIT_MAX, SUN_LIMIT_P99, SUN_LIMIT_FLIPS, MOON_LIMIT_MAX, MOON_LIMIT_P99, MOON_LIMIT_FLIPS);
+    if (pszResults) printf("        Or results changed from %s by more than %.2f min or %.3f %%\n", pszResults, SUN_CHANGE_MAX, MOON_CHANGE_MAX);
+  }
+  return iFailed;
+}
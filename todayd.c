@@ -0,0 +1,506 @@
+/*
+** todayd.c - Sun and moon queries daemon, over a Unix domain socket
+**
+** Answers queries from other processes, without the cost of starting a
+** program for each. The sites, and the recent sunrise and sunset results,
+** remain cached in memory between queries.
+**
+** The protocol is line-based: Each request is one line, and gets exactly
+** one response line, in the same order. So clients can send many requests
+** without waiting for the responses. Requests are a command, followed by
+** space-separated arguments. Responses begin with OK or ERR:
+**
+**   PING                     OK VERSION
+**   SITE LAT LON [TZID [CITY]]  OK CITY. Use that site for the next queries.
+**                            LON +=East. Without arguments, use the default.
+**   SUN [DATE]               OK STATUS RISE NOON SET UTC_OFFSET
+**                            STATUS = ok, polar_day, or polar_night. Times =
+**                            HH:MM:SS local times, or - during polar days.
+**   MOON [TIME]              OK ILLUMINATION WAXING PHASE
+**   NEXT new|first|full|last [TIME]  OK YYYY-MM-DDTHH:MM:SSZ
+**   DATE [DATE]              OK English text of the date
+**   TIME [TIME]              OK English text of the time
+**
+** Dates and times have the same formats as the today programs arguments,
+** in the site time zone. The default is now.
+**
+** A single thread serves all connections, using an epoll event loop.
+** Each connection has fixed input and output buffers. When the output
+** buffer is nearly full, the connection stops reading requests until the
+** client has read enough responses.
+**
+** Linux only, for epoll.
+**
+** Authors:
+**   JFL jf.larvoire@free.fr
+**
+** History:
+**   2026-10-19 JFL Created this program.
+**		    Reject the invalid or unknown SITE time zones, which must
+**		    be tz database IDs, and not pathnames.
+**		    Reuse the least recently used sites when all are used,
+**		    instead of rejecting the new ones. Compare the whole SITE
+**		    arguments, instead of their first 127 characters.
+*/
+
+#define VERSION "2026-10-19"
+
+#define _GNU_SOURCE	/* For accept4() */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+
+#include "libtoday.h"
+#include "versions.h"
+
+#define streq(s1, s2) (!strcmp(s1, s2))
+
+#define DEFAULT_SOCKET	"/tmp/todayd.sock"
+#define IN_SIZE		65536	/* Input buffer size. Also the maximum request size */
+#define OUT_SIZE	131072	/* Output buffer size */
+#define RESPONSE_MAX	512	/* Maximum size of one response */
+#define MAX_SITES	256	/* Maximum number of sites cached */
+#define SUN_CACHE_SIZE	4096	/* Number of sun results cached. A power of 2 */
+#define MAX_EVENTS	64
+
+typedef struct _SITEDEF {	/* A cached site */
+  char *pszKey;			/* The SITE arguments that defined it */
+  TODAY_SITE *ps;
+  int nConns;			/* Number of connections using it */
+  unsigned long lastUse;	/* When it was last selected, for evicting the oldest */
+} SITEDEF;
+
+/* get_site() errors */
+#define SITE_INVALID	-1	/* Invalid latitude or longitude */
+#define SITE_BAD_TZ	-2	/* Invalid or unknown TZID */
+#define SITE_FULL	-3	/* All sites are in use by connections */
+#define SITE_NO_MEMORY	-4
+
+typedef struct _SUNCACHE {	/* A cached sun result */
+  int iSite;			/* -1 = Unused */
+  long day;			/* Local date key: (year * 12 + month) * 31 + day */
+  TODAY_SUN sun;
+} SUNCACHE;
+
+typedef struct _CONN {		/* A client connection */
+  int fd;
+  int iSite;			/* The site used for its queries */
+  unsigned int events;		/* The epoll events requested */
+  size_t nIn;			/* Bytes in the input buffer */
+  size_t nOut;			/* Bytes in the output buffer */
+  size_t iOut;			/* Bytes of it already sent */
+  char in[IN_SIZE];
+  char out[OUT_SIZE];
+} CONN;
+
+static SITEDEF sites[MAX_SITES];
+static int nSites = 0;
+static unsigned long nSiteUses = 0;
+static SUNCACHE sunCache[SUN_CACHE_SIZE];
+static volatile sig_atomic_t iStop = 0;
+
+void usage() {
+  printf("\
+todayd - Sun and moon queries daemon, over a Unix domain socket\n\
+\n\
+Usage: todayd [OPTIONS]\n\
+\n\
+Options:\n\
+  -?|-h|--help      Display this help screen\n\
+  -c PATHNAME       Configuration file name, for the default site\n\
+  -s PATHNAME       Socket name. Default: " DEFAULT_SOCKET "\n\
+  -V|--version      Display the program version\n\
+\n\
+Requests: One per line. Each gets one response line, in the same order.\n\
+  PING                      OK VERSION\n\
+  SITE LAT LON [TZID [CITY]]  Use that site for the next queries. LON +=East\n\
+  SITE                      Use the default site again\n\
+  SUN [DATE]                OK STATUS RISE NOON SET UTC_OFFSET\n\
+  MOON [TIME]               OK ILLUMINATION WAXING PHASE\n\
+  NEXT new|first|full|last [TIME]  OK YYYY-MM-DDTHH:MM:SSZ\n\
+  DATE [DATE]               OK English text of the date\n\
+  TIME [TIME]               OK English text of the time\n\
+Errors: ERR MESSAGE\n\
+\n\
+Dates and times: In the site time zone, like in the today program. Default: now\n\
+"
+#ifdef __unix__
+"\n"
+#endif
+);
+}
+
+static void on_signal(int iSig) {
+  iStop = iSig;
+}
+
+/* Split a line into space-separated arguments. The last one gets the rest of the line */
+static int split_args(char *psz, char *argv[], int nMax) {
+  int n = 0;
+
+  while (n < nMax) {
+    while ((*psz == ' ') || (*psz == '\t')) psz++;
+    if (!*psz) break;
+    argv[n++] = psz;
+    if (n == nMax) break;
+    while (*psz && (*psz != ' ') && (*psz != '\t')) psz++;
+    if (*psz) *(psz++) = '\0';
+  }
+  return n;
+}
+
+/* Find or create a site. Return its index, or a SITE_xxx error.
+   When all slots are used, reuse the least recently used one that no
+   connection is using. The default site 0 is never reused. */
+static int get_site(char *argv[], int argc) {
+  static char szKey[IN_SIZE];	/* The arguments come from one request line */
+  double lat, lon;
+  char *pszEnd;
+  char *pszKey;
+  TODAY_SITE *ps;
+  int i, iSite;
+
+  lat = strtod(argv[0], &pszEnd);
+  if (*pszEnd || (lat < -90) || (lat > 90)) return SITE_INVALID;
+  lon = strtod(argv[1], &pszEnd);
+  if (*pszEnd || (lon < -180) || (lon > 180)) return SITE_INVALID;
+  snprintf(szKey, sizeof(szKey), "%s %s %s %s", argv[0], argv[1],
+	   (argc > 2) ? argv[2] : "", (argc > 3) ? argv[3] : "");
+  for (i = 1; i < nSites; i++) {
+    if (streq(sites[i].pszKey, szKey)) {
+      sites[i].lastUse = ++nSiteUses;
+      return i;
+    }
+  }
+  iSite = nSites;
+  if (nSites == MAX_SITES) {	/* Find the least recently used free slot */
+    iSite = SITE_FULL;
+    for (i = 1; i < nSites; i++) {
+      if (!sites[i].nConns && ((iSite < 0) || (sites[i].lastUse < sites[iSite].lastUse))) iSite = i;
+    }
+    if (iSite < 0) return SITE_FULL;
+  }
+  ps = today_site_new(lat, lon, (argc > 2) ? argv[2] : NULL, (argc > 3) ? argv[3] : "");
+  if (!ps) return SITE_BAD_TZ;
+  pszKey = strdup(szKey);
+  if (!pszKey) {
+    today_site_close(ps);
+    return SITE_NO_MEMORY;
+  }
+  if (iSite < nSites) {		/* Evict the old site, and its cached sun results */
+    today_site_close(sites[iSite].ps);
+    free(sites[iSite].pszKey);
+    for (i = 0; i < SUN_CACHE_SIZE; i++) {
+      if (sunCache[i].iSite == iSite) sunCache[i].iSite = -1;
+    }
+  } else {
+    nSites++;
+  }
+  sites[iSite].pszKey = pszKey;
+  sites[iSite].ps = ps;
+  sites[iSite].nConns = 0;
+  sites[iSite].lastUse = ++nSiteUses;
+  return iSite;
+}
+
+/* Switch a connection to another site */
+static void set_site(CONN *pc, int iSite) {
+  sites[pc->iSite].nConns--;
+  sites[iSite].nConns++;
+  pc->iSite = iSite;
+}
+
+/* Get the time argument, or now. Return 0 if OK */
+static int get_time(int iSite, char *pszTime, time_t *pt, struct tm *ptm) {
+  TODAY_SITE *ps = sites[iSite].ps;
+
+  if (!pszTime) {
+    *pt = time(NULL);
+    today_local_time(ps, *pt, ptm);
+    return 0;
+  }
+  if (today_parse_time(ps, pszTime, ptm)) return 1;
+  *pt = today_utc_time(ps, ptm);
+  return 0;
+}
+
+/* Format fractional hours as HH:MM:SS */
+static char *hms(char *buf, double h) {
+  long s = (long)(h * 3600 + 0.5);
+
+  if (h < 0) return strcpy(buf, "-");
+  sprintf(buf, "%02ld:%02ld:%02ld", s / 3600, (s / 60) % 60, s % 60);
+  return buf;
+}
+
+/* Sun results on a local date, from the cache if possible */
+static TODAY_SUN *sun_cached(int iSite, struct tm *ptm) {
+  long day = ((ptm->tm_year + 1900) * 12L + ptm->tm_mon) * 31 + ptm->tm_mday;
+  SUNCACHE *pc = sunCache + (((unsigned long)day * 31 + (unsigned long)iSite) & (SUN_CACHE_SIZE - 1));
+
+  if ((pc->iSite != iSite) || (pc->day != day)) {
+    today_sun_compute(sites[iSite].ps, ptm->tm_year + 1900, ptm->tm_mon + 1, ptm->tm_mday, &pc->sun);
+    pc->iSite = iSite;
+    pc->day = day;
+  }
+  return &pc->sun;
+}
+
+/* Answer one request. Return the length of the response, including its \n */
+static int answer(CONN *pConn, char *pszLine, char *pBuf) {
+  static char *statusNames[4] = {"ok", "error", "polar_day", "polar_night"};
+  static char *phaseNames[4] = {"new", "first", "full", "last"};
+  char *argv[5];
+  int argc = split_args(pszLine, argv, 5);
+  char *pszCmd = argc ? argv[0] : "";
+  char *pszArg = (argc > 1) ? argv[1] : NULL;
+  time_t t;
+  struct tm stm;
+  int n;
+
+  if (!strcasecmp(pszCmd, "PING")) {
+    n = sprintf(pBuf, "OK %s", VERSION);
+  } else if (!strcasecmp(pszCmd, "SITE")) {
+    if (argc == 1) {
+      set_site(pConn, 0);
+    } else {
+      int iSite = (argc >= 3) ? get_site(argv + 1, argc - 1) : SITE_INVALID;
+      if (iSite == SITE_BAD_TZ) return sprintf(pBuf, "ERR Invalid time zone\n");
+      if (iSite == SITE_FULL) return sprintf(pBuf, "ERR Too many sites\n");
+      if (iSite == SITE_NO_MEMORY) return sprintf(pBuf, "ERR Out of memory\n");
+      if (iSite < 0) return sprintf(pBuf, "ERR Invalid site\n");
+      set_site(pConn, iSite);
+    }
+    n = snprintf(pBuf, RESPONSE_MAX - 1, "OK %s", today_site_city(sites[pConn->iSite].ps));
+    if (n > RESPONSE_MAX - 2) n = RESPONSE_MAX - 2;
+  } else if (!strcasecmp(pszCmd, "SUN")) {
+    TODAY_SUN *psun;
+    char szRise[16], szNoon[16], szSet[16];
+    long offset;
+    if (get_time(pConn->iSite, pszArg, &t, &stm)) return sprintf(pBuf, "ERR Invalid date\n");
+    if (stm.tm_year + 1900 < 1583) return sprintf(pBuf, "ERR Invalid date\n");
+    psun = sun_cached(pConn->iSite, &stm);
+    offset = (psun->utc_offset < 0) ? -psun->utc_offset : psun->utc_offset;
+    n = sprintf(pBuf, "OK %s %s %s %s %c%02ld:%02ld", statusNames[psun->status & 3],
+		hms(szRise, psun->rise), hms(szNoon, psun->noon), hms(szSet, psun->set),
+		(psun->utc_offset < 0) ? '-' : '+', offset / 3600, (offset / 60) % 60);
+  } else if (!strcasecmp(pszCmd, "MOON")) {
+    TODAY_MOON moon;
+    if (get_time(pConn->iSite, pszArg, &t, &stm)) return sprintf(pBuf, "ERR Invalid time\n");
+    if (today_moon_state(t, TODAY_MOON_ELP, &moon)) return sprintf(pBuf, "ERR Invalid time\n");
+    n = sprintf(pBuf, "OK %.4f %d %s", moon.illumination, moon.waxing, moon.phase);
+  } else if (!strcasecmp(pszCmd, "NEXT")) {
+    int iPhase;
+    for (iPhase = 0; iPhase < 4; iPhase++) {
+      if (pszArg && !strcasecmp(pszArg, phaseNames[iPhase])) break;
+    }
+    if (iPhase == 4) return sprintf(pBuf, "ERR Invalid phase\n");
+    if (get_time(pConn->iSite, (argc > 2) ? argv[2] : NULL, &t, &stm)) return sprintf(pBuf, "ERR Invalid time\n");
+    t = today_moon_phase(t, iPhase);
+    gmtime_r(&t, &stm);
+    n = sprintf(pBuf, "OK %04d-%02d-%02dT%02d:%02d:%02dZ", stm.tm_year + 1900, stm.tm_mon + 1,
+		stm.tm_mday, stm.tm_hour, stm.tm_min, stm.tm_sec);
+  } else if (!strcasecmp(pszCmd, "DATE")) {
+    if (get_time(pConn->iSite, pszArg, &t, &stm)) return sprintf(pBuf, "ERR Invalid date\n");
+    memcpy(pBuf, "OK ", 3);
+    n = 3 + today_date_text(pBuf + 3, RESPONSE_MAX - 4, stm.tm_year + 1900, stm.tm_mon + 1, stm.tm_mday);
+    if (n > RESPONSE_MAX - 2) n = RESPONSE_MAX - 2;
+  } else if (!strcasecmp(pszCmd, "TIME")) {
+    if (get_time(pConn->iSite, pszArg, &t, &stm)) return sprintf(pBuf, "ERR Invalid time\n");
+    memcpy(pBuf, "OK ", 3);
+    n = 3 + today_time_text(pBuf + 3, RESPONSE_MAX - 4, stm.tm_hour, stm.tm_min, stm.tm_sec);
+    if (n > RESPONSE_MAX - 2) n = RESPONSE_MAX - 2;
+  } else {
+    return sprintf(pBuf, "ERR Unknown command\n");
+  }
+  pBuf[n++] = '\n';
+  return n;
+}
+
+/* Answer all complete requests in the input buffer, while there's room for the responses */
+static void process(CONN *pc) {
+  char *pLine = pc->in;
+  char *pEnd = pc->in + pc->nIn;
+
+  while (OUT_SIZE - pc->nOut >= RESPONSE_MAX) {
+    char *pEol = memchr(pLine, '\n', pEnd - pLine);
+    if (!pEol) break;
+    *pEol = '\0';
+    if ((pEol > pLine) && (pEol[-1] == '\r')) pEol[-1] = '\0';
+    pc->nOut += answer(pc, pLine, pc->out + pc->nOut);
+    pLine = pEol + 1;
+  }
+  pc->nIn = pEnd - pLine;
+  if (pc->nIn && (pLine != pc->in)) memmove(pc->in, pLine, pc->nIn);
+}
+
+/* Send the pending responses. Return 0 if OK, or -1 if the connection failed */
+static int flush(CONN *pc) {
+  while (pc->iOut < pc->nOut) {
+    ssize_t n = send(pc->fd, pc->out + pc->iOut, pc->nOut - pc->iOut, MSG_NOSIGNAL);
+    if (n < 0) {
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) return 0;
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    pc->iOut += n;
+  }
+  pc->nOut = pc->iOut = 0;
+  return 0;
+}
+
+static void conn_close(int epfd, CONN *pc) {
+  sites[pc->iSite].nConns--;
+  epoll_ctl(epfd, EPOLL_CTL_DEL, pc->fd, NULL);
+  close(pc->fd);
+  free(pc);
+}
+
+/* Handle the events on a connection */
+static void conn_io(int epfd, CONN *pc, unsigned int events) {
+  struct epoll_event ev;
+  int iEof = 0;
+
+  if (events & EPOLLIN) {
+    ssize_t n = recv(pc->fd, pc->in + pc->nIn, IN_SIZE - pc->nIn, 0);
+    if (n > 0) {
+      pc->nIn += n;
+    } else if ((n == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))) {
+      iEof = 1;
+    }
+  }
+  for (;;) {
+    process(pc);
+    if (flush(pc)) {
+      conn_close(epfd, pc);
+      return;
+    }
+    if (pc->nOut || !memchr(pc->in, '\n', pc->nIn)) break;
+  }
+  if (pc->nIn == IN_SIZE) iEof = 1;	/* Request too long */
+  if (iEof && !pc->nOut) {
+    conn_close(epfd, pc);
+    return;
+  }
+  /* Read more requests only when there's room for their responses */
+  ev.events = ((!iEof && (OUT_SIZE - pc->nOut >= RESPONSE_MAX)) ? EPOLLIN : 0) | (pc->nOut ? EPOLLOUT : 0);
+  if (ev.events != pc->events) {
+    ev.data.ptr = pc;
+    pc->events = ev.events;
+    epoll_ctl(epfd, EPOLL_CTL_MOD, pc->fd, &ev);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int i;
+  char *pszCfgFile = NULL;
+  char *pszSocket = DEFAULT_SOCKET;
+  struct sockaddr_un sa;
+  struct epoll_event ev, events[MAX_EVENTS];
+  int sfd, epfd;
+
+  for (i=1; i<argc; i++) {
+    char *arg = argv[i];
+    if (   streq(arg, "-?")
+        || streq(arg, "-h")
+        || streq(arg, "--help")) {
+      usage();
+      return 0;
+    }
+    if (streq(arg, "-c") && ((i+1)<argc)) {
+      pszCfgFile = argv[++i];
+      continue;
+    }
+    if (streq(arg, "-s") && ((i+1)<argc)) {
+      pszSocket = argv[++i];
+      continue;
+    }
+    if (   streq(arg, "-V")
+	|| streq(arg, "--version")) {
+      printf(VERSION " " EXE_OS_NAME "\n");
+      return 0;
+    }
+    fprintf(stderr, "Unexpected argument: %s\n", arg);
+    return 1;
+  }
+
+  /* The default site is site 0 */
+  sites[0].ps = today_site_open(pszCfgFile);
+  if (!sites[0].ps) {
+    fprintf(stderr, "Error: Can't read the location configuration\n");
+    return 1;
+  }
+  nSites = 1;
+  for (i = 0; i < SUN_CACHE_SIZE; i++) sunCache[i].iSite = -1;
+
+  if (strlen(pszSocket) >= sizeof(sa.sun_path)) {
+    fprintf(stderr, "Error: Socket name too long: %s\n", pszSocket);
+    return 1;
+  }
+  memset(&sa, 0, sizeof(sa));
+  sa.sun_family = AF_UNIX;
+  strcpy(sa.sun_path, pszSocket);
+  sfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (sfd < 0) {
+    fprintf(stderr, "Error: Can't create a socket: %s\n", strerror(errno));
+    return 1;
+  }
+  unlink(pszSocket);
+  if (bind(sfd, (struct sockaddr *)&sa, sizeof(sa)) || listen(sfd, SOMAXCONN)) {
+    fprintf(stderr, "Error: Can't listen on %s: %s\n", pszSocket, strerror(errno));
+    return 1;
+  }
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+
+  epfd = epoll_create1(EPOLL_CLOEXEC);
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;		/* NULL = The listening socket */
+  epoll_ctl(epfd, EPOLL_CTL_ADD, sfd, &ev);
+
+  while (!iStop) {
+    int n = epoll_wait(epfd, events, MAX_EVENTS, -1);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      fprintf(stderr, "Error: epoll_wait failed: %s\n", strerror(errno));
+      break;
+    }
+    for (i = 0; i < n; i++) {
+      CONN *pc = events[i].data.ptr;
+      if (!pc) {		/* New connections */
+	int fd;
+	while ((fd = accept4(sfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+	  pc = malloc(sizeof(CONN));
+	  if (!pc) {
+	    close(fd);
+	    continue;
+	  }
+	  pc->fd = fd;
+	  pc->iSite = 0;
+	  sites[0].nConns++;
+	  pc->nIn = pc->nOut = pc->iOut = 0;
+	  pc->events = ev.events = EPOLLIN;
+	  ev.data.ptr = pc;
+	  epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+	}
+	continue;
+      }
+      conn_io(epfd, pc, events[i].events);
+    }
+  }
+
+  close(sfd);
+  unlink(pszSocket);
+  return 0;
+}
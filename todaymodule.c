@@ -0,0 +1,345 @@
+/*
+** todaymodule.c - Python extension module, for batches of sun and moon data
+**
+** Wraps the reentrant libtoday engine, for computing sunrise, sunset, and
+** moon phase for whole arrays at once. Ex, with NumPy or pandas:
+**
+**   import numpy as np, today
+**   t = df.time.values.astype("datetime64[s]").astype(np.int64)
+**   rise = np.empty(len(t)); set = np.empty(len(t))
+**   today.sun_batch(t, df.lat.values, df.lon.values, rise, set, tz="Europe/Paris")
+**
+** All arrays are passed with the buffer protocol, so NumPy arrays, array.array,
+** memoryviews, etc, are all supported. Input values are read in place, and
+** results are written in place into the output arrays allocated by the
+** caller. Nothing is copied, and nothing is allocated per row.
+** Latitudes and longitudes may also be single numbers, used for all rows.
+**
+** The GIL is released during the computations, so several Python threads can
+** process batches in parallel. When built with OPENMP=1, each batch is also
+** split between all cores.
+**
+** Build: make python, with the Python include files installed.
+**
+** Authors:
+**   JFL jf.larvoire@free.fr
+**
+** History:
+**   2026-10-19 JFL Created this module.
+**		    Bugfix: Never close the cached sites, as sun_batch() may still
+**		    be using them in other threads.
+**		    Reject the latitudes and longitudes out of range. Bugfix:
+**		    moon_batch() returned values for years out of range, and
+**		    bool outputs got 0xFF for -1.
+*/
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <math.h>
+#include <string.h>
+
+#include "libtoday.h"
+
+typedef struct _ARRAY {		/* An input or output argument */
+  Py_buffer view;		/* The array, if view.buf is not NULL */
+  char cType;			/* Its struct module type code */
+  double dValue;		/* Else the value for all rows */
+} ARRAY;
+
+/* Get the array type code, without the optional byte order prefix */
+static char array_type(const Py_buffer *pv) {
+  const char *psz = pv->format ? pv->format : "B";
+
+  if (strchr("@=<>!", *psz)) psz++;
+  return (psz[0] && !psz[1]) ? psz[0] : '\0';
+}
+
+/* Get an array from a Python object. Return 0 if OK, or -1 with an exception set */
+static int get_array(PyObject *pObj, ARRAY *pa, Py_ssize_t *pn, const char *pszName,
+		     const char *pszTypes, int iWritable, int iScalarOK) {
+  pa->view.buf = NULL;
+  if (!pObj || (pObj == Py_None)) return 0;	/* Optional output, not requested */
+  if (iScalarOK && (PyFloat_Check(pObj) || PyLong_Check(pObj))) {
+    pa->dValue = PyFloat_AsDouble(pObj);
+    return PyErr_Occurred() ? -1 : 0;
+  }
+  if (PyObject_GetBuffer(pObj, &pa->view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS
+					  | (iWritable ? PyBUF_WRITABLE : 0))) {
+    pa->view.buf = NULL;
+    return -1;
+  }
+  pa->cType = array_type(&pa->view);
+  if (!pa->cType || !strchr(pszTypes, pa->cType) || (pa->view.ndim > 1)) {
+    PyErr_Format(PyExc_TypeError, "%s: Unsupported array type %s, or more than 1 dimension",
+		 pszName, pa->view.format ? pa->view.format : "B");
+  } else if ((*pn >= 0) && (pa->view.len / pa->view.itemsize != *pn)) {
+    PyErr_Format(PyExc_ValueError, "%s: The arrays lengths differ", pszName);
+  } else {
+    *pn = pa->view.len / pa->view.itemsize;
+    return 0;
+  }
+  PyBuffer_Release(&pa->view);
+  pa->view.buf = NULL;
+  return -1;
+}
+
+static void release_array(ARRAY *pa) {
+  if (pa->view.buf) PyBuffer_Release(&pa->view);
+}
+
+#define NUMBER_TYPES	"dfqlihbQLIHB"	/* Supported input types */
+#define INTEGER_TYPES	"qlihbQLIHB?"	/* Supported integer output types */
+
+/* Get the value of row i */
+static double get_value(const ARRAY *pa, Py_ssize_t i) {
+  const char *p = (const char *)pa->view.buf;
+
+  if (!p) return pa->dValue;
+  switch (pa->cType) {
+    case 'd': return ((const double *)p)[i];
+    case 'f': return ((const float *)p)[i];
+    case 'q': return (double)((const long long *)p)[i];
+    case 'l': return (double)((const long *)p)[i];
+    case 'i': return ((const int *)p)[i];
+    case 'h': return ((const short *)p)[i];
+    case 'b': return ((const signed char *)p)[i];
+    case 'Q': return (double)((const unsigned long long *)p)[i];
+    case 'L': return (double)((const unsigned long *)p)[i];
+    case 'I': return ((const unsigned int *)p)[i];
+    case 'H': return ((const unsigned short *)p)[i];
+    case 'B': return ((const unsigned char *)p)[i];
+  }
+  return NAN;
+}
+
+/* Set an integer in row i of an output array, if any. Bools get 1 if > 0, else 0 */
+static void set_int(ARRAY *pa, Py_ssize_t i, int iValue) {
+  char *p = (char *)pa->view.buf;
+
+  if (!p) return;
+  switch (pa->cType) {
+    case 'q': case 'Q': ((long long *)p)[i] = iValue; break;
+    case 'l': case 'L': ((long *)p)[i] = iValue; break;
+    case 'i': case 'I': ((int *)p)[i] = iValue; break;
+    case 'h': case 'H': ((short *)p)[i] = (short)iValue; break;
+    case '?': p[i] = (char)(iValue > 0); break;	/* Only 0 or 1 are valid bools */
+    default: p[i] = (char)iValue; break;
+  }
+}
+
+/* Set a float64 in row i of an output array, if any */
+static void set_double(ARRAY *pa, Py_ssize_t i, double dValue) {
+  if (pa->view.buf) ((double *)pa->view.buf)[i] = dValue;
+}
+
+/* Get a site for a time zone. NULL = UTC. Return NULL with an exception set if error.
+   The sites are never closed, as other threads may still be using them with the
+   GIL released. There's at most one per time zone in the tz database. */
+static TODAY_SITE *get_site(const char *pszTz) {
+  static TODAY_SITE **ppSites = NULL;
+  static int nSites = 0;
+  static int nAlloc = 0;
+  TODAY_SITE *ps;
+  int i;
+
+  for (i = 0; i < nSites; i++) {	/* The city field holds the tz name */
+    if (!strcmp(today_site_city(ppSites[i]), pszTz ? pszTz : "")) return ppSites[i];
+  }
+  if (nSites == nAlloc) {		/* The GIL protects this cache */
+    TODAY_SITE **ppNew = PyMem_Realloc(ppSites, (nAlloc + 16) * sizeof(TODAY_SITE *));
+    if (!ppNew) return (TODAY_SITE *)PyErr_NoMemory();
+    ppSites = ppNew;
+    nAlloc += 16;
+  }
+  ps = today_site_new(0, 0, pszTz, pszTz ? pszTz : "");
+  if (!ps && pszTz) {		/* Invalid or unknown time zone ID */
+    PyErr_Format(PyExc_ValueError, "tz: Unknown time zone %s", pszTz);
+    return NULL;
+  }
+  if (!ps) return (TODAY_SITE *)PyErr_NoMemory();
+  ppSites[nSites++] = ps;
+  return ps;
+}
+
+PyDoc_STRVAR(sun_batch_doc,
+"sun_batch(t, lat, lon, rise, set, noon=None, status=None, tz=None)\n\
+\n\
+Compute the sunrise, solar noon, and sunset, on the local date of each\n\
+Unix time in array t, at latitudes lat (+=North) and longitudes lon (+=East).\n\
+lat and lon are arrays, or numbers used for all rows. The local dates are in\n\
+time zone tz, like \"Europe/Paris\". Default: UTC.\n\
+The results are written as Unix times into float64 arrays rise, set, and\n\
+noon, and as codes into integer array status: 0=OK, 1=Invalid input,\n\
+2=Polar day, 3=Polar night. Times are NaN when they don't exist.\n\
+Latitudes must be within [-90, 90], and longitudes within [-180, 180].\n\
+Numbers out of range raise ValueError, and array values get status 1.");
+
+static PyObject *sun_batch(PyObject *self, PyObject *args, PyObject *kwargs) {
+  static char *kwlist[] = {"t", "lat", "lon", "rise", "set", "noon", "status", "tz", NULL};
+  PyObject *pT, *pLat, *pLon, *pRise, *pSet, *pNoon = NULL, *pStatus = NULL;
+  const char *pszTz = NULL;
+  ARRAY aT, aLat, aLon, aRise, aSet, aNoon, aStatus;
+  TODAY_SITE *ps;
+  Py_ssize_t n = -1;
+  Py_ssize_t i;
+  int iErr;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOOO|OOz", kwlist, &pT, &pLat, &pLon,
+				   &pRise, &pSet, &pNoon, &pStatus, &pszTz)) return NULL;
+  ps = get_site(pszTz);
+  if (!ps) return NULL;
+  aT.view.buf = aLat.view.buf = aLon.view.buf = aRise.view.buf = NULL;
+  aSet.view.buf = aNoon.view.buf = aStatus.view.buf = NULL;
+  iErr = get_array(pT, &aT, &n, "t", NUMBER_TYPES, 0, 0)
+      || get_array(pLat, &aLat, &n, "lat", NUMBER_TYPES, 0, 1)
+      || get_array(pLon, &aLon, &n, "lon", NUMBER_TYPES, 0, 1)
+      || get_array(pRise, &aRise, &n, "rise", "d", 1, 0)
+      || get_array(pSet, &aSet, &n, "set", "d", 1, 0)
+      || get_array(pNoon, &aNoon, &n, "noon", "d", 1, 0)
+      || get_array(pStatus, &aStatus, &n, "status", INTEGER_TYPES, 1, 0);
+  if (!iErr && !aT.view.buf) {
+    PyErr_SetString(PyExc_TypeError, "t: An array is required");
+    iErr = 1;
+  }
+  if (!iErr && !aLat.view.buf && !(fabs(aLat.dValue) <= 90)) {
+    PyErr_Format(PyExc_ValueError, "lat: Out of range [-90, 90]: %R", pLat);
+    iErr = 1;
+  }
+  if (!iErr && !aLon.view.buf && !(fabs(aLon.dValue) <= 180)) {
+    PyErr_Format(PyExc_ValueError, "lon: Out of range [-180, 180]: %R", pLon);
+    iErr = 1;
+  }
+
+  if (!iErr) {
+    Py_BEGIN_ALLOW_THREADS
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (i = 0; i < n; i++) {
+      double t = get_value(&aT, i);
+      double lat = get_value(&aLat, i);
+      double lon = get_value(&aLon, i);
+      double t0;		/* Unix time of the local midnight, at the noon UTC offset */
+      struct tm stm;
+      TODAY_SUN sun;
+      int iStatus = TODAY_ERROR;
+
+      if ((t == t) && (fabs(t) < 1e14)) {	/* today_sun_compute_at() checks lat & lon */
+	today_local_time(ps, (time_t)floor(t), &stm);
+	iStatus = today_sun_compute_at(ps, lat, lon, stm.tm_year + 1900, stm.tm_mon + 1, stm.tm_mday, &sun);
+      }
+      if (iStatus == TODAY_ERROR) {
+	sun.rise = sun.set = sun.noon = NAN;
+      } else {
+	stm.tm_hour = 12;
+	stm.tm_min = stm.tm_sec = 0;
+	stm.tm_isdst = -1;
+	t0 = (double)today_utc_time(ps, &stm) - 12 * 3600;
+	if (iStatus == TODAY_OK) {
+	  sun.rise = t0 + floor(sun.rise * 3600 + 0.5);
+	  sun.set = t0 + floor(sun.set * 3600 + 0.5);
+	} else {
+	  sun.rise = sun.set = NAN;
+	}
+	sun.noon = t0 + floor(sun.noon * 3600 + 0.5);
+      }
+      set_double(&aRise, i, sun.rise);
+      set_double(&aSet, i, sun.set);
+      set_double(&aNoon, i, sun.noon);
+      set_int(&aStatus, i, iStatus);
+    }
+    Py_END_ALLOW_THREADS
+  }
+
+  release_array(&aT);
+  release_array(&aLat);
+  release_array(&aLon);
+  release_array(&aRise);
+  release_array(&aSet);
+  release_array(&aNoon);
+  release_array(&aStatus);
+  if (iErr) return NULL;
+  Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(moon_batch_doc,
+"moon_batch(t, illumination, waxing=None, precise=False)\n\
+\n\
+Compute the moon state at each Unix time in array t.\n\
+The illuminated fractions, from 0 to 1, are written into float64 array\n\
+illumination, and 1 if waxing or 0 if waning into integer array waxing.\n\
+precise=True uses the ELP-2000/82 engine, else the faster original one.\n\
+Values are NaN and -1 (False for bool arrays) for invalid times, out of the\n\
+years -4712 to 9999.");
+
+static PyObject *moon_batch(PyObject *self, PyObject *args, PyObject *kwargs) {
+  static char *kwlist[] = {"t", "illumination", "waxing", "precise", NULL};
+  PyObject *pT, *pIllum, *pWaxing = NULL;
+  int iPrecise = 0;
+  ARRAY aT, aIllum, aWaxing;
+  Py_ssize_t n = -1;
+  Py_ssize_t i;
+  int iErr;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|Op", kwlist, &pT, &pIllum,
+				   &pWaxing, &iPrecise)) return NULL;
+  aT.view.buf = aIllum.view.buf = aWaxing.view.buf = NULL;
+  iErr = get_array(pT, &aT, &n, "t", NUMBER_TYPES, 0, 0)
+      || get_array(pIllum, &aIllum, &n, "illumination", "d", 1, 0)
+      || get_array(pWaxing, &aWaxing, &n, "waxing", INTEGER_TYPES, 1, 0);
+  if (!iErr && !aT.view.buf) {
+    PyErr_SetString(PyExc_TypeError, "t: An array is required");
+    iErr = 1;
+  }
+
+  if (!iErr) {
+    Py_BEGIN_ALLOW_THREADS
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (i = 0; i < n; i++) {
+      double t = get_value(&aT, i);
+      TODAY_MOON moon;
+
+      if (!(t == t) || !(fabs(t) < 1e14)
+	  || today_moon_state((time_t)floor(t), iPrecise ? TODAY_MOON_ELP : TODAY_MOON_FAST, &moon)) {
+	moon.illumination = NAN;
+	moon.waxing = -1;
+      }
+      set_double(&aIllum, i, moon.illumination);
+      set_int(&aWaxing, i, moon.waxing);
+    }
+    Py_END_ALLOW_THREADS
+  }
+
+  release_array(&aT);
+  release_array(&aIllum);
+  release_array(&aWaxing);
+  if (iErr) return NULL;
+  Py_RETURN_NONE;
+}
+
+static PyObject *version(PyObject *self, PyObject *args) {
+  return PyUnicode_FromString(today_version());
+}
+
+static PyMethodDef today_methods[] = {
+  {"sun_batch", (PyCFunction)(void (*)(void))sun_batch, METH_VARARGS | METH_KEYWORDS, sun_batch_doc},
+  {"moon_batch", (PyCFunction)(void (*)(void))moon_batch, METH_VARARGS | METH_KEYWORDS, moon_batch_doc},
+  {"version", version, METH_NOARGS, "Get the libtoday version."},
+  {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef today_module = {
+  PyModuleDef_HEAD_INIT,
+  "today",
+  "Sun and moon computations for arrays, with the today programs engine.",
+  -1,
+  today_methods,
+  NULL, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_today(void) {
+  return PyModule_Create(&today_module);
+}
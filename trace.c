@@ -0,0 +1,131 @@
+/*
+ * trace.c
+ *
+ * Tracing events, event counters, and stage timings, declared in today.h.
+ *
+ * The hot routines call the TRACE(), TRACE_COUNT(), and TRACE_STAGE()
+ * macros. They're compiled in only when TRACING is defined, with
+ * make TRACE=1, or in the debug builds. Else they expand to nothing, and
+ * the routines below just report that the statistics are unavailable.
+ *
+ * The events are output to stdout in the logfmt format, one per line,
+ * when the -d option sets the debug flag:
+ *   trace t_us=12.3 fn=julian_date m=13 d=25 y=2017 jd=2458112.500000
+ * The counters and stage times are output by trace_stats(), also in the
+ * logfmt format, for option --stats:
+ *   counter=kepler_iterations value=4
+ *   stage=sun calls=1 total_us=9.4 mean_us=9.4
+ * With OpenMP, the updates are atomic, and the stage times are summed
+ * over all threads.
+ *
+ * Authors:
+ *   JFL jf.larvoire@free.fr
+ *
+ * History:
+ *   2026-10-19 JFL Created this module.
+ *		    Bugfix: trace_event() set the start time outside of the
+ *		    critical section, in the OpenMP builds.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>	/* For QueryPerformanceCounter() */
+#endif
+
+#include "today.h"
+
+#ifdef TRACING
+
+static const char * const counterNames[TC_COUNT] = {
+  "kepler_iterations", "range_loops", "config_reads", "tzfile_loads"
+};
+static const char * const stageNames[TS_COUNT] = {
+  "config", "parse", "sun", "moon", "planets", "output"
+};
+
+static long lCounts[TC_COUNT];		/* Event counters */
+static long lCalls[TS_COUNT];		/* Number of times each stage ran */
+static double dTimes[TS_COUNT];		/* Time spent in each stage, in seconds */
+static double dStart = -1;		/* Time of the first event */
+
+/* Monotonic time, in seconds */
+double trace_now() {
+#if defined(_WIN32)
+  LARGE_INTEGER li, liFreq;
+  QueryPerformanceCounter(&li);
+  QueryPerformanceFrequency(&liFreq);
+  return (double)li.QuadPart / (double)liFreq.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Output an event, with the time since the first one */
+void trace_event(const char *pszFormat, ...) {
+  va_list args;
+  double t = trace_now();
+
+  va_start(args, pszFormat);
+#ifdef _OPENMP
+#pragma omp critical (trace_output)
+#endif
+  {				/* Also protects dStart from the other threads */
+    if (dStart < 0) dStart = t;
+    printf("trace t_us=%.1f ", (t - dStart) * 1e6);
+    vprintf(pszFormat, args);
+    printf("\n");
+  }
+  va_end(args);
+}
+
+/* Add n to a counter */
+void trace_count(int iCounter, long n) {
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  lCounts[iCounter] += n;
+}
+
+/* Add the time since t0 to a stage */
+void trace_stage(int iStage, double t0) {
+  double dt = trace_now() - t0;
+
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  lCalls[iStage] += 1;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+  dTimes[iStage] += dt;
+}
+
+/* Dump the counters and stage times. Return 0 if OK */
+int trace_stats(FILE *f) {
+  int i;
+
+  for (i = 0; i < TC_COUNT; i++) {
+    fprintf(f, "counter=%s value=%ld\n", counterNames[i], lCounts[i]);
+  }
+  for (i = 0; i < TS_COUNT; i++) {
+    fprintf(f, "stage=%s calls=%ld total_us=%.1f mean_us=%.1f\n", stageNames[i],
+	    lCalls[i], dTimes[i] * 1e6, lCalls[i] ? dTimes[i] * 1e6 / lCalls[i] : 0.0);
+  }
+  return 0;
+}
+
+#else /* !defined(TRACING) */
+
+int trace_stats(FILE *f) {
+  fprintf(f, "Statistics not available. Rebuild with make TRACE=1\n");
+  return 1;
+}
+
+#endif /* defined(TRACING) */
@@ -0,0 +1,425 @@
+/*
+ * tzfile.c
+ *
+ * Read time zone information from the tz database TZif files, like
+ * /usr/share/zoneinfo/Europe/Paris, independently of the C library TZ state.
+ *
+ * The file is mapped into memory, and used in place: The transition times,
+ * the local time types, and the abbreviations are read directly from the
+ * mapped data. Looking up the UTC offset at a given time is a binary search
+ * over the transition times. After the last transition, the POSIX TZ string
+ * in the file footer (Ex: "CET-1CEST,M3.5.0,M10.5.0/3") gives the rules.
+ * The transitions from 1900 to 2100, from the file data or from the rules,
+ * are also decoded once into native arrays when the file is opened, so that
+ * the frequent lookups in that range are just a binary search in that table.
+ * Nothing is global, so any number of time zones can be used at the same
+ * time, by any number of threads.
+ *
+ * The format is documented in RFC 8536, and in the tzfile(5) man page.
+ *
+ * Authors:
+ *   JFL jf.larvoire@free.fr
+ *
+ * History:
+ *   2026-10-19 JFL Created this module.
+ *		    Use civil_from_days() from parsetime.c.
+ *		    Added the decoded transitions table for 1900 to 2100.
+ *		    Count the files loaded, for today --stats.
+ *		    Added tzfile_valid_id(), for the time zones from clients.
+ *		    Open only regular files, and never block opening them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HAS_MMAP 1
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "today.h"
+
+#define TZDIR		"/usr/share/zoneinfo"	/* Default tz database directory */
+#define HEADER_SIZE	44
+#define CACHE_FROM	1900			/* Years with a decoded transitions table */
+#define CACHE_TO	2100
+
+/* Big-endian integers in the file */
+static long be32(const unsigned char *p) {
+  unsigned long u = ((unsigned long)p[0] << 24) | ((unsigned long)p[1] << 16)
+		  | ((unsigned long)p[2] << 8) | (unsigned long)p[3];
+  return (u & 0x80000000UL) ? -(long)(0xFFFFFFFFUL - u) - 1 : (long)u;
+}
+
+static time_t be64(const unsigned char *p) {
+  time_t t = (signed char)p[0];	/* Sign-extend the high byte */
+  int i;
+  for (i = 1; i < 8; i++) t = (t << 8) | p[i];
+  return t;
+}
+
+static int raw_lookup(const TZFILE *ptzf, time_t t, long *pOffset, int *pIsDst, const char **ppszAbbr);
+static void build_cache(TZFILE *ptzf);
+
+static time_t tz_time(const TZFILE *ptzf, long i) {
+  if (ptzf->nTimeSize == 8) return be64(ptzf->pTimes + 8 * i);
+  return (time_t)be32(ptzf->pTimes + 4 * i);
+}
+
+/* Parse a POSIX TZ abbreviation. Return a pointer to the next character, or NULL */
+static const char *parse_abbr(const char *p, const char *pEnd, char *pszAbbr) {
+  int n = 0;
+  if ((p < pEnd) && (*p == '<')) {	/* Quoted form, like <+0530> */
+    for (p++; (p < pEnd) && (*p != '>'); p++) if (n < TZ_ABBR_SIZE-1) pszAbbr[n++] = *p;
+    if (p++ >= pEnd) return NULL;
+  } else {
+    for ( ; (p < pEnd) && isalpha((unsigned char)*p); p++) if (n < TZ_ABBR_SIZE-1) pszAbbr[n++] = *p;
+  }
+  pszAbbr[n] = '\0';
+  return n ? p : NULL;
+}
+
+/* Parse a [+|-]hh[:mm[:ss]] time. Return a pointer to the next character, or NULL */
+static const char *parse_hms(const char *p, const char *pEnd, long *pSecs) {
+  long sign = 1, v[3] = {0, 0, 0};
+  int i;
+  if ((p < pEnd) && ((*p == '+') || (*p == '-'))) sign = (*(p++) == '-') ? -1 : 1;
+  for (i = 0; i < 3; i++) {
+    if ((p >= pEnd) || !isdigit((unsigned char)*p)) return NULL;
+    while ((p < pEnd) && isdigit((unsigned char)*p)) v[i] = 10 * v[i] + (*(p++) - '0');
+    if ((i == 2) || (p >= pEnd) || (*p != ':')) break;
+    p++;
+  }
+  *pSecs = sign * (3600 * v[0] + 60 * v[1] + v[2]);
+  return p;
+}
+
+/* Parse an unsigned number. Return a pointer to the next character, or NULL */
+static const char *parse_num(const char *p, const char *pEnd, int min, int max, int *pn) {
+  int n = 0;
+  if ((p >= pEnd) || !isdigit((unsigned char)*p)) return NULL;
+  while ((p < pEnd) && isdigit((unsigned char)*p) && (n <= max)) n = 10 * n + (*(p++) - '0');
+  if ((n < min) || (n > max)) return NULL;
+  *pn = n;
+  return p;
+}
+
+/* Parse a ,date[/time] DST transition rule */
+static const char *parse_rule(const char *p, const char *pEnd, TZRULE *pr) {
+  if ((p >= pEnd) || (*(p++) != ',') || (p >= pEnd)) return NULL;
+  if (*p == 'M') {		/* Mm.w.d = Day d (0=Sunday) of week w (5=last) of month m */
+    pr->kind = *(p++);
+    if (!(p = parse_num(p, pEnd, 1, 12, &pr->m))) return NULL;
+    if ((p >= pEnd) || (*(p++) != '.') || !(p = parse_num(p, pEnd, 1, 5, &pr->w))) return NULL;
+    if ((p >= pEnd) || (*(p++) != '.') || !(p = parse_num(p, pEnd, 0, 6, &pr->d))) return NULL;
+  } else if (*p == 'J') {	/* Jn = Day n in [1, 365], never counting February 29 */
+    pr->kind = *(p++);
+    if (!(p = parse_num(p, pEnd, 1, 365, &pr->d))) return NULL;
+  } else {			/* n = Day n in [0, 365] */
+    pr->kind = 'D';
+    if (!(p = parse_num(p, pEnd, 0, 365, &pr->d))) return NULL;
+  }
+  pr->secs = 7200;	/* Default: 02:00:00 */
+  if ((p < pEnd) && (*p == '/')) p = parse_hms(p + 1, pEnd, &pr->secs);
+  return p;
+}
+
+/* Parse the POSIX TZ string in the footer. Return 0 if OK */
+static int parse_footer(TZFILE *ptzf, const char *p, const char *pEnd) {
+  long off;
+  if (!(p = parse_abbr(p, pEnd, ptzf->szStd))) return 1;
+  if (!(p = parse_hms(p, pEnd, &off))) return 1;
+  ptzf->stdOffset = -off;	/* POSIX offsets are positive West */
+  ptzf->iHasDst = 0;
+  if ((p >= pEnd) || !(p = parse_abbr(p, pEnd, ptzf->szDst))) return 0; /* No DST */
+  ptzf->dstOffset = ptzf->stdOffset + 3600;
+  if ((p < pEnd) && (*p != ',')) {
+    if (!(p = parse_hms(p, pEnd, &off))) return 1;
+    ptzf->dstOffset = -off;
+  }
+  if (!(p = parse_rule(p, pEnd, &ptzf->start))) return 1;
+  if (!(p = parse_rule(p, pEnd, &ptzf->end))) return 1;
+  ptzf->iHasDst = 1;
+  return 0;
+}
+
+/* UTC time of a transition rule in a given year. offset = UTC offset before the transition */
+static time_t rule_time(const TZRULE *pr, int year, long offset) {
+  int leap = ((year % 4) == 0) && (((year % 400) == 0) || ((year % 100) != 0));
+  long days;
+  switch (pr->kind) {
+    case 'M': {
+      static const int mdays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+      int nDays = mdays[pr->m - 1] + ((pr->m == 2) && leap);
+      long first = days_from_civil(year, pr->m, 1);
+      int wd1 = (int)(((first % 7) + 11) % 7);	/* Weekday of the 1st. 1970-01-01 was a Thursday */
+      int day = 1 + (pr->d - wd1 + 7) % 7 + (pr->w - 1) * 7;
+      while (day > nDays) day -= 7;
+      days = first + day - 1;
+      break;
+    }
+    case 'J':	/* 1-based day of year, never counting February 29 */
+      days = days_from_civil(year, 1, 1) + pr->d - 1 + ((pr->d >= 60) && leap);
+      break;
+    default:	/* 0-based day of year */
+      days = days_from_civil(year, 1, 1) + pr->d;
+      break;
+  }
+  return (time_t)days * 86400 + pr->secs - offset;
+}
+
+/* Append a transition to the cache, unless it changes nothing */
+static void cache_add(TZFILE *ptzf, time_t t) {
+  long n = ptzf->nCache;
+  long offset;
+  int isDst;
+  const char *pszAbbr;
+
+  if (raw_lookup(ptzf, t, &offset, &isDst, &pszAbbr)) return;
+  if ((pszAbbr == ptzf->szStd) || (pszAbbr == ptzf->szDst)) pszAbbr = NULL; /* Don't point inside the structure */
+  if (n && (offset == ptzf->pCacheOffsets[n-1]) && (isDst == ptzf->pCacheDst[n-1])
+      && (pszAbbr == ptzf->ppCacheAbbr[n-1])) return;
+  ptzf->pCacheTimes[n] = t;
+  ptzf->pCacheOffsets[n] = offset;
+  ptzf->pCacheDst[n] = (unsigned char)isDst;
+  ptzf->ppCacheAbbr[n] = pszAbbr;
+  ptzf->nCache = n + 1;
+}
+
+static void free_cache(TZFILE *ptzf) {
+  free(ptzf->pCacheTimes);
+  free(ptzf->pCacheOffsets);
+  free(ptzf->pCacheDst);
+  free((void *)ptzf->ppCacheAbbr);
+  ptzf->pCacheTimes = NULL;
+  ptzf->pCacheOffsets = NULL;
+  ptzf->pCacheDst = NULL;
+  ptzf->ppCacheAbbr = NULL;
+  ptzf->nCache = 0;
+}
+
+/* Check that a time zone ID from an untrusted source, like Europe/Paris, is
+   a tz database name, and not a pathname. Return 1 if valid */
+int tzfile_valid_id(const char *pszName) {
+  const char *pc;
+
+  if (!*pszName || (*pszName == '/') || (strlen(pszName) >= 64)) return 0;
+  for (pc = pszName; *pc; pc++) {	/* No . at all, so no .. either */
+    if (!isalnum((unsigned char)*pc) && !strchr("/_-+", *pc)) return 0;
+  }
+  return 1;
+}
+
+/* Open and map a TZif file. pszName is an ID like Europe/Paris, or a pathname. Return 0 if OK */
+int tzfile_open(const char *pszName, TZFILE *ptzf) {
+  char szPath[512];
+  const char *pszDir = getenv("TZDIR");
+  const unsigned char *p, *pEnd;
+  long isutcnt, isstdcnt, leapcnt;
+  int v2;
+
+  memset(ptzf, 0, sizeof(TZFILE));
+  if (!pszDir) pszDir = TZDIR;
+  if ((pszName[0] == '/') || (strlen(pszDir) + strlen(pszName) + 2 > sizeof(szPath))) {
+    if (strlen(pszName) >= sizeof(szPath)) return 1;
+    strcpy(szPath, pszName);
+  } else {
+    sprintf(szPath, "%s/%s", pszDir, pszName);
+  }
+
+#if HAS_MMAP
+  {
+    struct stat st;
+    void *pMap;
+    int fd = open(szPath, O_RDONLY | O_NONBLOCK);	/* Don't wait for a FIFO writer */
+    if (fd < 0) return 1;
+    if (fstat(fd, &st) || !S_ISREG(st.st_mode) || (st.st_size < HEADER_SIZE)) {
+      close(fd);
+      return 1;
+    }
+    pMap = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (pMap == MAP_FAILED) return 1;
+    ptzf->pBase = (const unsigned char *)pMap;
+    ptzf->size = (size_t)st.st_size;
+    ptzf->iMapped = 1;
+  }
+#else /* No mmap. Read the whole file instead */
+  {
+    FILE *f = fopen(szPath, "rb");
+    unsigned char *pBuf;
+    long l;
+    if (!f) return 1;
+    fseek(f, 0, SEEK_END);
+    l = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    pBuf = (l >= HEADER_SIZE) ? malloc((size_t)l) : NULL;
+    if (!pBuf || (fread(pBuf, 1, (size_t)l, f) != (size_t)l)) {
+      free(pBuf);
+      fclose(f);
+      return 1;
+    }
+    fclose(f);
+    ptzf->pBase = pBuf;
+    ptzf->size = (size_t)l;
+  }
+#endif
+  TRACE_COUNT(TC_TZFILE, 1);
+
+  p = ptzf->pBase;
+  pEnd = p + ptzf->size;
+  if (memcmp(p, "TZif", 4)) goto bad_file;
+  v2 = (p[4] >= '2') && (sizeof(time_t) >= 8);
+  ptzf->nTimeSize = 4;
+  for (;;) {	/* Parse the v1 data block, then the v2+ one if we use it */
+    long nData;
+    if (p + HEADER_SIZE > pEnd) goto bad_file;
+    isutcnt  = be32(p + 20);
+    isstdcnt = be32(p + 24);
+    leapcnt  = be32(p + 28);
+    ptzf->timecnt = be32(p + 32);
+    ptzf->typecnt = be32(p + 36);
+    ptzf->charcnt = be32(p + 40);
+    if ((isutcnt < 0) || (isstdcnt < 0) || (leapcnt < 0) || (ptzf->timecnt < 0)
+	|| (ptzf->typecnt < 1) || (ptzf->charcnt < 0)) goto bad_file;
+    nData = ptzf->timecnt * (ptzf->nTimeSize + 1) + ptzf->typecnt * 6 + ptzf->charcnt
+	    + leapcnt * (ptzf->nTimeSize + 4) + isstdcnt + isutcnt;
+    p += HEADER_SIZE;
+    if (nData > pEnd - p) goto bad_file;
+    if (v2 && (ptzf->nTimeSize == 4)) {	/* Skip the v1 block */
+      p += nData;
+      ptzf->nTimeSize = 8;
+      continue;
+    }
+    ptzf->pTimes = p;
+    ptzf->pIdx = p + ptzf->timecnt * ptzf->nTimeSize;
+    ptzf->pTypes = ptzf->pIdx + ptzf->timecnt;
+    ptzf->pChars = ptzf->pTypes + ptzf->typecnt * 6;
+    p += nData;
+    break;
+  }
+  if (v2 && (p < pEnd) && (*p == '\n')) {	/* The footer with the POSIX TZ string */
+    const unsigned char *pNL = memchr(p + 1, '\n', (size_t)(pEnd - p - 1));
+    if (pNL && (pNL > p + 1)) ptzf->iHasFooter = !parse_footer(ptzf, (const char *)p + 1, (const char *)pNL);
+  }
+  build_cache(ptzf);
+  return 0;
+
+bad_file:
+  tzfile_close(ptzf);
+  return 1;
+}
+
+void tzfile_close(TZFILE *ptzf) {
+  free_cache(ptzf);
+#if HAS_MMAP
+  if (ptzf->iMapped) munmap((void *)ptzf->pBase, ptzf->size);
+#endif
+  if (!ptzf->iMapped) free((void *)ptzf->pBase);
+  memset(ptzf, 0, sizeof(TZFILE));
+}
+
+/* Get the UTC offset at a given time from the file data */
+static int raw_lookup(const TZFILE *ptzf, time_t t, long *pOffset, int *pIsDst, const char **ppszAbbr) {
+  const unsigned char *pType;
+  int iType = 0;
+
+  if (!ptzf->pBase) return 1;
+  if (ptzf->iHasFooter && ((ptzf->timecnt == 0) || (t >= tz_time(ptzf, ptzf->timecnt - 1)))) {
+    int isDst = 0;
+    if (ptzf->iHasDst) {
+      long days = (long)(t / 86400);
+      int year, month, day;
+      time_t tStart, tEnd;
+      if ((t % 86400) < 0) days -= 1;	/* Round towards -infinity */
+      civil_from_days(days, &year, &month, &day);
+      tStart = rule_time(&ptzf->start, year, ptzf->stdOffset);
+      tEnd = rule_time(&ptzf->end, year, ptzf->dstOffset);
+      isDst = (tStart < tEnd) ? ((t >= tStart) && (t < tEnd)) : ((t >= tStart) || (t < tEnd));
+    }
+    *pOffset = isDst ? ptzf->dstOffset : ptzf->stdOffset;
+    *pIsDst = isDst;
+    *ppszAbbr = isDst ? ptzf->szDst : ptzf->szStd;
+    return 0;
+  }
+  if ((ptzf->timecnt > 0) && (t >= tz_time(ptzf, 0))) {
+    long lo = 0, hi = ptzf->timecnt;	/* Find the last transition <= t */
+    while (hi - lo > 1) {
+      long mid = (lo + hi) / 2;
+      if (tz_time(ptzf, mid) <= t) lo = mid; else hi = mid;
+    }
+    iType = ptzf->pIdx[lo];
+    if (iType >= ptzf->typecnt) return 1;
+  }
+  pType = ptzf->pTypes + 6 * iType;
+  *pOffset = be32(pType);
+  *pIsDst = pType[4];
+  *ppszAbbr = (pType[5] < ptzf->charcnt) ? (const char *)ptzf->pChars + pType[5] : "";
+  return 0;
+}
+
+/* Decode the transitions from CACHE_FROM to CACHE_TO into native arrays */
+static void build_cache(TZFILE *ptzf) {
+  time_t tFrom = (time_t)days_from_civil(CACHE_FROM, 1, 1) * 86400;
+  time_t tTo = (time_t)days_from_civil(CACHE_TO, 1, 1) * 86400;
+  long nMax = ptzf->timecnt + 2L * (CACHE_TO - CACHE_FROM) + 1;
+  time_t tLast = tFrom;
+  long i;
+
+  if (sizeof(time_t) < 8) return;	/* 1900 and 2100 are out of range */
+  ptzf->pCacheTimes = malloc(nMax * sizeof(time_t));
+  ptzf->pCacheOffsets = malloc(nMax * sizeof(long));
+  ptzf->pCacheDst = malloc(nMax);
+  ptzf->ppCacheAbbr = malloc(nMax * sizeof(char *));
+  if (!(ptzf->pCacheTimes && ptzf->pCacheOffsets && ptzf->pCacheDst && ptzf->ppCacheAbbr)) {
+    free_cache(ptzf);
+    return;
+  }
+  cache_add(ptzf, tFrom);
+  for (i = 0; i < ptzf->timecnt; i++) {
+    time_t t = tz_time(ptzf, i);
+    if ((t > tFrom) && (t < tTo)) cache_add(ptzf, t);
+    if (t > tLast) tLast = t;
+  }
+  if (ptzf->iHasFooter && ptzf->iHasDst) {	/* Then the transitions from the rules */
+    int year, month, day;
+    civil_from_days((long)(tLast / 86400), &year, &month, &day);
+    for ( ; year < CACHE_TO; year++) {
+      time_t tStart = rule_time(&ptzf->start, year, ptzf->stdOffset);
+      time_t tEnd = rule_time(&ptzf->end, year, ptzf->dstOffset);
+      time_t t1 = (tStart < tEnd) ? tStart : tEnd;
+      time_t t2 = (tStart < tEnd) ? tEnd : tStart;
+      if ((t1 > tLast) && (t1 < tTo)) cache_add(ptzf, t1);
+      if ((t2 > tLast) && (t2 < tTo)) cache_add(ptzf, t2);
+    }
+  }
+  ptzf->tCacheEnd = tTo;
+}
+
+/* Get the UTC offset, in seconds East, the DST flag, and the abbreviation at a given time.
+   Return 0 if OK */
+int tzfile_lookup(const TZFILE *ptzf, time_t t, long *pOffset, int *pIsDst, const char **ppszAbbr) {
+  long lo, hi;
+
+  if (!ptzf->nCache || (t < ptzf->pCacheTimes[0]) || (t >= ptzf->tCacheEnd)) {
+    return raw_lookup(ptzf, t, pOffset, pIsDst, ppszAbbr);
+  }
+  lo = 0;			/* Find the last transition <= t */
+  hi = ptzf->nCache;
+  while (hi - lo > 1) {
+    long mid = (lo + hi) / 2;
+    if (ptzf->pCacheTimes[mid] <= t) lo = mid; else hi = mid;
+  }
+  *pOffset = ptzf->pCacheOffsets[lo];
+  *pIsDst = ptzf->pCacheDst[lo];
+  *ppszAbbr = ptzf->ppCacheAbbr[lo];
+  if (!*ppszAbbr) *ppszAbbr = *pIsDst ? ptzf->szDst : ptzf->szStd;
+  return 0;
+}